@@ -16,13 +16,20 @@ sources = ["src/system/utility.cc",
            "src/loop/move.cc",
            "src/loop/moveutil.cc",
            "src/loop/loop.cc",
+           "src/loop/loopindex.cc",
+           "src/loop/pairmask.cc",
            "src/system/energyoptions.cc",
            "src/energymodel/nupackenergymodel.cc",
            "src/energymodel/energymodel.cc",
+           "src/energymodel/energycache.cc",
+           "src/energymodel/parametercache.cc",
            "src/state/scomplex.cc",
            "src/state/scomplexlist.cc",
+           "src/state/stopmatcher.cc",
+           "src/state/stopdistance.cc",
            "src/system/simoptions.cc",
            "src/system/ssystem.cc",
+           "src/system/randomstream.cc",
            "src/state/strandordering.cc"
            ]
 
@@ -33,7 +40,8 @@ def setup_ext( ):
                           include_dirs=["./src/include"],
                           language="c++",
                         undef_macros=['NDEBUG'],
-                        extra_compile_args = ['-O3','-g', '-w', "-std=c++11", ], #FD: adding c11 flag
+                        extra_compile_args = ['-O3','-g', '-w', "-std=c++11", "-pthread", ], #FD: adding c11 flag
+                        extra_link_args = ["-pthread", ], # threaded trajectories, see SimulationSystem
                           )
     return multi_ext
 
@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include <stddef.h>
+#include "energycache.h"
+
+thread_local EnergyCache EnergyCache::local;
+std::atomic<uint64_t> EnergyCache::generation(1);
+
+EnergyCache::EnergyCache(void) {
+
+	table = NULL; // allocated on first use, most threads never compute an energy
+	hits = 0;
+	misses = 0;
+
+}
+
+EnergyCache::~EnergyCache(void) {
+
+	if (table != NULL)
+		delete[] table;
+	table = NULL;
+
+}
+
+uint64_t EnergyCache::hashKey(EnergyModel* model, int type, int sides, int* lengths, char** starts) {
+
+	uint64_t hash = ((uint64_t) (uintptr_t) model) ^ ((uint64_t) type << 56) ^ ((uint64_t) sides << 48);
+
+	for (int loop = 0; loop < sides; loop++) {
+		hash = (hash ^ (uint64_t) (uintptr_t) starts[loop]) * 0x9E3779B97F4A7C15ULL;
+		hash = (hash ^ (uint64_t) lengths[loop]) * 0xC2B2AE3D27D4EB4FULL;
+	}
+
+	return hash ^ (hash >> 29);
+
+}
+
+bool EnergyCache::matches(Entry& entry, uint64_t hash, uint64_t current, EnergyModel* model, int type, int sides, int* lengths, char** starts) {
+
+	if (entry.generation != current || entry.hash != hash || entry.model != model || entry.type != type || entry.sides != sides)
+		return false;
+
+	for (int loop = 0; loop < sides; loop++)
+		if (entry.starts[loop] != starts[loop] || entry.lengths[loop] != lengths[loop])
+			return false;
+
+	return true;
+
+}
+
+bool EnergyCache::lookup(EnergyModel* model, int type, int sides, int* lengths, char** starts, double* energy) {
+
+	EnergyCache& cache = local;
+
+	if (sides > ENERGYCACHE_MAXSIDES || cache.table == NULL) {
+		cache.misses++;
+		return false;
+	}
+
+	uint64_t hash = hashKey(model, type, sides, lengths, starts);
+	Entry& entry = cache.table[hash & (ENERGYCACHE_SIZE - 1)];
+
+	if (matches(entry, hash, generation.load(std::memory_order_acquire), model, type, sides, lengths, starts)) {
+		cache.hits++;
+		*energy = entry.energy;
+		return true;
+	}
+
+	cache.misses++;
+	return false;
+
+}
+
+void EnergyCache::store(EnergyModel* model, int type, int sides, int* lengths, char** starts, double energy) {
+
+	EnergyCache& cache = local;
+
+	if (sides > ENERGYCACHE_MAXSIDES)
+		return;
+
+	if (cache.table == NULL) {
+		cache.table = new Entry[ENERGYCACHE_SIZE];
+		for (int loop = 0; loop < ENERGYCACHE_SIZE; loop++)
+			cache.table[loop].generation = 0;
+	}
+
+	uint64_t hash = hashKey(model, type, sides, lengths, starts);
+	Entry& entry = cache.table[hash & (ENERGYCACHE_SIZE - 1)];
+
+	entry.hash = hash;
+	entry.generation = generation.load(std::memory_order_acquire);
+	entry.model = model;
+	entry.type = type;
+	entry.sides = sides;
+	for (int loop = 0; loop < sides; loop++) {
+		entry.starts[loop] = starts[loop];
+		entry.lengths[loop] = lengths[loop];
+	}
+	entry.energy = energy;
+
+}
+
+// for the tables of all threads; 64 bits do not wrap around.
+void EnergyCache::invalidate(void) {
+
+	generation.fetch_add(1, std::memory_order_acq_rel);
+
+}
+
+long EnergyCache::getHits(void) {
+
+	return local.hits;
+
+}
+
+long EnergyCache::getMisses(void) {
+
+	return local.misses;
+
+}
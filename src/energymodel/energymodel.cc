@@ -20,25 +20,21 @@ bool printedRates = false; // to print the constants to file once
 const double INIT_PENALTY = 0.0; //kcal / mol
 
 EnergyModel::EnergyModel(PyObject *options) {
-	// nothing yet
+
+	arrheniusEnabled = false; // set by the derived model, from its options
 
 }
 
 EnergyModel::EnergyModel(void) {
-	// nothing yet either
+
+	arrheniusEnabled = false;
+
 }
 
 EnergyModel::~EnergyModel(void) {
 	// nothing
 }
 
-// Return state of the energyOption toggle
-bool EnergyModel::useArrhenius(void) {
-
-	return simOptions->energyOptions->usingArrhenius();
-
-}
-
 double expRate(double A, double E, double temperature) {
 
 	return exp(A - E / (gasConstant * temperature));
@@ -180,19 +176,6 @@ void EnergyModel::writeConstantsToFile() {
 
 }
 
-double EnergyModel::applyPrefactors(double tempRate, MoveType left, MoveType right) {
-
-	if (useArrhenius()) {
-
-		return tempRate * arrheniusRates[left * MOVETYPE_SIZE + right];
-
-	} else {
-
-		return tempRate;
-	}
-
-}
-
 // FD: A base pair is present between a stacking loop and a multi loop.
 // FD: We query the local context of the middle pair;
 // FD: this can be either a loop, stack+loop, or stack+stack situation.
@@ -306,7 +289,7 @@ MoveType EnergyModel::prefactorOpen(int index, int numOfSides, int sideLengths[]
 
 double EnergyModel::singleStrandedStacking(char* sequence, int length) {
 
-	if (simOptions->energyOptions->usingArrhenius() && length > 4) {
+	if (arrheniusEnabled && length > 4) {
 
 		return arrheniusLoopEnergy(sequence, length);
 
@@ -384,10 +367,6 @@ double EnergyModel::saltCorrection(int size) {
 
 }
 
-int pairs[5] = { 0, 0, 0, 0, 0 };
-int pairtypes[5][5] = { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 0 } };
-int basepair_sw[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-
 int lookuphelper[26] = { 1, 0, 2, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 0, 0, 0, 0, 0 };		// A C G T    1 2 3 4
 //                      A,B,C,D,E,F,G,H,I,J,K,L,M,N,O,P,Q,R,S,T,U,V,W,X,Y,Z
 
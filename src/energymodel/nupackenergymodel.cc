@@ -9,9 +9,12 @@ help@multistrand.org
 #include <math.h>
 #include <ctype.h>
 #include <assert.h>
+#include <algorithm>
 
 #include "simoptions.h"
 #include "options.h"
+#include "energycache.h"
+#include "parametercache.h"
 
 #undef DEBUG
 //#define DEBUG
@@ -26,16 +29,75 @@ static double T_scale(double dG, double dH, double T) {
 const double CELSIUS37_IN_KELVIN = 310.15;
 const double TEMPERATURE_ZERO_CELSIUS_IN_KELVIN = 273.15;
 
-extern int pairs[5];
-extern int pairtypes[5][5];
-extern int basepair_sw[8];
 
 // helper function to convert to numerical base format.
 extern int baseLookup(char base);
 
 NupackEnergyModel::~NupackEnergyModel(void) {
-	// TODO: is anything allocated now? Don't think so, all arrays are static still.
-	// nothing is allocated within an energy model.
+	// the tables are either parsed by this model, or mapped and shared (see ParameterCache).
+	if (parsed != NULL)
+		delete parsed;
+	parsed = NULL;
+
+	// a later model may be allocated at the same address.
+	EnergyCache::invalidate();
+}
+
+// The loop energies below are memoized per thread, see EnergyCache.
+
+double NupackEnergyModel::HairpinEnergy(char *seq, int size) {
+
+	double energy;
+
+	if (EnergyCache::lookup(this, ENERGYCACHE_HAIRPIN, 1, &size, &seq, &energy))
+		return energy;
+
+	energy = computeHairpinEnergy(seq, size);
+	EnergyCache::store(this, ENERGYCACHE_HAIRPIN, 1, &size, &seq, energy);
+
+	return energy;
+}
+
+double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int size2) {
+
+	double energy;
+	int lengths[2] = { size1, size2 };
+	char* starts[2] = { seq1, seq2 };
+
+	if (EnergyCache::lookup(this, ENERGYCACHE_INTERIOR, 2, lengths, starts, &energy))
+		return energy;
+
+	energy = computeInteriorEnergy(seq1, seq2, size1, size2);
+	EnergyCache::store(this, ENERGYCACHE_INTERIOR, 2, lengths, starts, energy);
+
+	return energy;
+}
+
+double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequences) {
+
+	double energy;
+
+	if (EnergyCache::lookup(this, ENERGYCACHE_MULTI, size, sidelen, sequences, &energy))
+		return energy;
+
+	energy = (this->*multiloopKernel)(size, sidelen, sequences);
+	EnergyCache::store(this, ENERGYCACHE_MULTI, size, sidelen, sequences, energy);
+
+	return energy;
+}
+
+// an open loop of size n has n + 1 sides.
+double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequences) {
+
+	double energy;
+
+	if (EnergyCache::lookup(this, ENERGYCACHE_OPEN, size + 1, sidelen, sequences, &energy))
+		return energy;
+
+	energy = (this->*openloopKernel)(size, sidelen, sequences);
+	EnergyCache::store(this, ENERGYCACHE_OPEN, size + 1, sidelen, sequences, energy);
+
+	return energy;
 }
 
 
@@ -49,11 +111,24 @@ double NupackEnergyModel::returnRate(double start_energy, double end_energy, int
 	}
 	// dG_assoc, if it were included in (start_energy, end_energy), would need to be deleted here. However, it never gets added into any energies except for display purposes. So it gets used in the join move rate, but not here.
 	// OLD: dG_assoc is typically a negative number, and included as part of the complex before disassociation. Thus it must be subtracted from the dE (leading to a typically slower disassociation rate.).
-	if (kinetic_rate_method == RATE_METHOD_KAWASAKI) {  // Kawasaki
+	return (this->*rateKernel)(dE);
+
+}
+
+void NupackEnergyModel::returnRates(double start_energy, double *end_energies, double *rates, int count) {
+
+	(this->*ratesKernel)(start_energy, end_energies, rates, count);
+
+}
+
+template<long rateMethod>
+double NupackEnergyModel::unimolecularRate(double dE) {
+
+	if (rateMethod == RATE_METHOD_KAWASAKI) {  // Kawasaki
 
 		return uniscale * exp(-0.5 * dE / _RT);
 
-	} else if (kinetic_rate_method == RATE_METHOD_METROPOLIS) {
+	} else if (rateMethod == RATE_METHOD_METROPOLIS) {
 		// Metropolis
 		if (dE < 0) {
 			return uniscale * 1.0;
@@ -67,6 +142,30 @@ double NupackEnergyModel::returnRate(double start_energy, double end_energy, int
 
 }
 
+// The same arithmetic as unimolecularRate, so the rates are bit for bit the same.
+template<long rateMethod>
+void NupackEnergyModel::unimolecularRates(double start_energy, double *end_energies, double *rates, int count) {
+
+	if (rateMethod == RATE_METHOD_KAWASAKI) {
+
+		for (int loop = 0; loop < count; loop++)
+			rates[loop] = uniscale * exp(-0.5 * (end_energies[loop] - start_energy) / _RT);
+
+	} else if (rateMethod == RATE_METHOD_METROPOLIS) {
+
+		for (int loop = 0; loop < count; loop++) {
+			double dE = end_energies[loop] - start_energy;
+			rates[loop] = (dE < 0) ? uniscale * 1.0 : uniscale * exp(-dE / _RT);
+		}
+
+	} else {
+
+		for (int loop = 0; loop < count; loop++)
+			rates[loop] = -9999.99;
+	}
+
+}
+
 double NupackEnergyModel::getJoinRate(void) {
 	return joinrate; // replace with the passed in rate
 					 // joinrate includes biscale (via setupRates();)
@@ -87,7 +186,7 @@ double NupackEnergyModel::getAssocEnergy(void) {
 // non entropy/enthalpy energy functions
 double NupackEnergyModel::StackEnergy(int i, int j, int p, int q) {
 
-	return stack_37_dG[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
+	return params->stack_37_dG[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
 
 }
 
@@ -97,31 +196,31 @@ double NupackEnergyModel::BulgeEnergy(int i, int j, int p, int q, int bulgesize)
 
 	if (bulgesize <= 30) {
 
-		energy = bulge_37_dG[bulgesize];
+		energy = params->bulge_37_dG[bulgesize];
 
 	} else {
 
-		energy = bulge_37_dG[30] + (log((double) bulgesize / 30.0) * log_loop_penalty / 100.0);
+		energy = params->bulge_37_dG[30] + (log((double) bulgesize / 30.0) * log_loop_penalty / 100.0);
 
 	}
 
 	if (bulgesize == 1) { // add stacking term for single-base bulges.
 
-		energy += stack_37_dG[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
+		energy += params->stack_37_dG[pairtypes[i][j] - 1][pairtypes[p][q] - 1];
 
 	} else { // AU penalty doesn't apply if they stack.
 
 		if (pairtypes[i][j] == 1 || pairtypes[i][j] > 3) // AT penalty applies
-			energy += terminal_AU;
+			energy += params->terminal_AU;
 		if (pairtypes[q][p] == 1 || pairtypes[q][p] > 3) // AT penalty applies
-			energy += terminal_AU;
+			energy += params->terminal_AU;
 
 	}
 
 	return energy;
 }
 
-double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int size2) {
+double NupackEnergyModel::computeInteriorEnergy(char *seq1, char *seq2, int size1, int size2) {
 
 	double energy, ninio;
 
@@ -130,23 +229,23 @@ double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int
 
 	// special case time. 1x1, 2x1 and 2x2's all get special cases.
 	if (size1 == 1 && size2 == 1)
-		return internal_1_1_37_dG[type1][type2][seq1[1]][seq2[size2]];
+		return params->internal_1_1_37_dG[type1][type2][(int) seq1[1]][(int) seq2[size2]];
 	if (size1 <= 2 && size2 <= 2)
 		if (size1 == 1 || size2 == 1) {
 			if (size1 == 1)
-				return internal_2_1_37_dG[type1][seq1[1]][type2][seq2[1]][seq2[size2]];
+				return params->internal_2_1_37_dG[type1][(int) seq1[1]][type2][(int) seq2[1]][(int) seq2[size2]];
 			else
-				return internal_2_1_37_dG[basepair_sw_mfold_actual[type2 + 1] - 1][seq2[1]][basepair_sw_mfold_actual[type1 + 1] - 1][seq1[1]][seq1[size1]];
+				return params->internal_2_1_37_dG[basepair_sw_mfold_actual[type2 + 1] - 1][(int) seq2[1]][basepair_sw_mfold_actual[type1 + 1] - 1][(int) seq1[1]][(int) seq1[size1]];
 		}
 	if (size1 == 2 && size2 == 2)
-		return internal_2_2_37_dG[type1][type2][seq1[1]][seq1[size1]][seq2[1]][seq2[size2]];
+		return params->internal_2_2_37_dG[type1][type2][(int) seq1[1]][(int) seq1[size1]][(int) seq2[1]][(int) seq2[size2]];
 
 	// Generic case.
 
 	if (size1 + size2 <= 30) {
-		energy = internal_37_dG[size1 + size2];
+		energy = params->internal_37_dG[size1 + size2];
 	} else {
-		energy = internal_37_dG[30] + (log((double) (size1 + size2) / 30.0) * log_loop_penalty / 100.0);
+		energy = params->internal_37_dG[30] + (log((double) (size1 + size2) / 30.0) * log_loop_penalty / 100.0);
 	}
 
 	// NINIO term...
@@ -160,19 +259,19 @@ double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int
 		asym = 4;
 	}
 
-	ninio = abs(size2 - size1) * ninio_correction_37[asym - 1];
+	ninio = abs(size2 - size1) * params->ninio_correction_37[asym - 1];
 
-	if (maximum_NINIO < ninio) {
-		energy += maximum_NINIO;
+	if (params->maximum_NINIO < ninio) {
+		energy += params->maximum_NINIO;
 	} else {
 		energy += ninio;
 	}
 
 	// try gail params?
 	if (size1 == 1 || size2 == 1) {
-		energy += internal_mismatch_37_dG[1][1][type1] + internal_mismatch_37_dG[1][1][basepair_sw_mfold_actual[type2 + 1] - 1];
+		energy += params->internal_mismatch_37_dG[1][1][type1] + params->internal_mismatch_37_dG[1][1][basepair_sw_mfold_actual[type2 + 1] - 1];
 	} else {
-		energy += internal_mismatch_37_dG[seq1[1]][seq2[size2]][type1] + internal_mismatch_37_dG[seq2[1]][seq1[size1]][basepair_sw_mfold_actual[type2 + 1] - 1];
+		energy += params->internal_mismatch_37_dG[(int) seq1[1]][(int) seq2[size2]][type1] + params->internal_mismatch_37_dG[(int) seq2[1]][(int) seq1[size1]][basepair_sw_mfold_actual[type2 + 1] - 1];
 	}
 
 	// FD: adding the singlestranded stacking term.
@@ -182,15 +281,15 @@ double NupackEnergyModel::InteriorEnergy(char *seq1, char *seq2, int size1, int
 	return energy;
 }
 
-double NupackEnergyModel::HairpinEnergy(char *seq, int size) {
+double NupackEnergyModel::computeHairpinEnergy(char *seq, int size) {
 
 	double energy = 0.0;
 	int lookup_index = 0;
 
 	if (size <= 30) {
-		energy = hairpin_37_dG[size];
+		energy = params->hairpin_37_dG[size];
 	} else {
-		energy = hairpin_37_dG[30] + (log((double) size / 30.0) * log_loop_penalty / 100.0);
+		energy = params->hairpin_37_dG[30] + (log((double) size / 30.0) * log_loop_penalty / 100.0);
 	}
 
 	if (size == 3) { // triloop bonuses
@@ -198,21 +297,21 @@ double NupackEnergyModel::HairpinEnergy(char *seq, int size) {
 		// We now always do the lookup, if no entry then it is 0.0.
 		lookup_index = ((seq[0] - 1) << 8) + ((seq[1] - 1) << 6) + ((seq[2] - 1) << 4) + ((seq[3] - 1) << 2) + (seq[4] - 1);
 
-		energy += hairpin_triloop_37_dG[lookup_index];
+		energy += params->hairpin_triloop_37_dG[lookup_index];
 
 		if ((seq[0] == baseT) || (seq[size + 1] == baseT)) {
-			energy += terminal_AU;
+			energy += params->terminal_AU;
 		}
 	}
 
 	if (size == 4) {
 		lookup_index = ((seq[0] - 1) << 10) + ((seq[1] - 1) << 8) + ((seq[2] - 1) << 6) + ((seq[3] - 1) << 4) + ((seq[4] - 1) << 2) + (seq[5] - 1);
 
-		energy += hairpin_tetraloop_37_dG[lookup_index];
+		energy += params->hairpin_tetraloop_37_dG[lookup_index];
 	}
 
 	if (size >= 4)
-		energy += hairpin_mismatch_37_dG[(pairtypes[seq[0]][seq[size + 1]] - 1)][seq[1]][seq[size]];
+		energy += params->hairpin_mismatch_37_dG[(pairtypes[(int) seq[0]][(int) seq[size + 1]] - 1)][(int) seq[1]][(int) seq[size]];
 
 	// FD: single stranded stacks.
 	energy += singleStrandedStacking(seq, size);
@@ -220,7 +319,8 @@ double NupackEnergyModel::HairpinEnergy(char *seq, int size) {
 	return energy;
 }
 
-double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequences) {
+template<long dangleMode, bool arrhenius>
+double NupackEnergyModel::computeMultiloopEnergy(int size, int *sidelen, char **sequences) {
 
 	// no dangle terms yet, this is equiv to dangles = 0;
 	int totallength = 0;
@@ -234,7 +334,7 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 		pt = pairtypes[sequences[loopminus1][sidelen[loopminus1] + 1]][sequences[loop][0]] - 1;
 
 		if ((pt == 0) || (pt > 2)) { // AT penalty applies
-			energy += terminal_AU;
+			energy += params->terminal_AU;
 		}
 		if (!gtenable && (pt > 3)) { // GT penalty applies
 			energy += 100000.00;
@@ -247,7 +347,8 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 		}
 
 		// FD: single stranded stacks.
-		energy += singleStrandedStacking(sequences[loop], sidelen[loop]);
+		if (arrhenius)
+			energy += singleStrandedStacking(sequences[loop], sidelen[loop]);
 		// FD: initialization of branch migration penalty.
 		energy += initializationPenalty(sidelen[loop], loop, size);
 
@@ -259,18 +360,11 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 	}
 
 
-	energy += size * multiloop_internal;
-	energy += multiloop_closing;
-
-	if (!logml) {
-		energy += multiloop_base * totallength;
-	} else if (totallength <= 6) {
-		energy += multiloop_base * totallength;
-	} else {
-		energy += multiloop_base * 6 + (log((double) totallength / 6.0) * log_loop_penalty / 100.0);
-	}
+	energy += size * params->multiloop_internal;
+	energy += params->multiloop_closing;
+	energy += multiloopLengthEnergy(totallength);
 
-	if (dangles == DANGLES_NONE) {
+	if (dangleMode == DANGLES_NONE) {
 
 		return energy;
 
@@ -283,14 +377,14 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 
 			rt_pt = pairtypes[sequences[loop][0]][sequences[loopminus1][sidelen[loopminus1] + 1]] - 1;
 
-			if (!(dangles == DANGLES_SOME && sidelen[loopminus1] == 0)) {
+			if (!(dangleMode == DANGLES_SOME && sidelen[loopminus1] == 0)) {
 
 
 
-				dangle5 = dangle_5_37_dG[pt][sequences[loopminus1][1]];
-				dangle3 = dangle_3_37_dG[rt_pt][sequences[loopminus1][sidelen[loopminus1]]];
+				dangle5 = params->dangle_5_37_dG[pt][(int) sequences[loopminus1][1]];
+				dangle3 = params->dangle_3_37_dG[rt_pt][(int) sequences[loopminus1][sidelen[loopminus1]]];
 
-				if (dangles == DANGLES_SOME && sidelen[loopminus1] == 1) {
+				if (dangleMode == DANGLES_SOME && sidelen[loopminus1] == 1) {
 					energy += ((dangle3 < dangle5) ? dangle3 : dangle5); // minimum of two terms.
 
 				} else {
@@ -312,7 +406,8 @@ double NupackEnergyModel::MultiloopEnergy(int size, int *sidelen, char **sequenc
 
 }
 
-double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequences) {
+template<long dangleMode, bool arrhenius>
+double NupackEnergyModel::computeOpenloopEnergy(int size, int *sidelen, char **sequences) {
 
 	if(debugTraces){
 		cout << "Computing OpenLoopEnergy, size = " << size << endl;
@@ -327,14 +422,15 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 		// TODO: slight efficiency gain if we wrap this into the dangles version separately, rather than doing a double pass in the dangle case.
 
 		if ((pt == 0) || (pt > 2)) { // AT penalty applies
-			energy += terminal_AU;
+			energy += params->terminal_AU;
 		}
 		if (!gtenable && (pt > 3)) { // GT penalty applies
 			energy += 100000.0;
 		}
 
 		// FD: adding singlestranded stacking.
-		energy += singleStrandedStacking(sequences[loop], sidelen[loop]);
+		if (arrhenius)
+			energy += singleStrandedStacking(sequences[loop], sidelen[loop]);
 		// FD: initialization of branch migration penalty.
 		energy +=  initializationPenalty(sidelen[loop], loop, size);
 
@@ -345,7 +441,7 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 		cout << "Mid OpenLoop -- Energy is now " << energy << endl;
 	}
 
-	if (dangles == DANGLES_NONE || size == 0) {
+	if (dangleMode == DANGLES_NONE || size == 0) {
 		return energy;
 	} else {
 
@@ -357,7 +453,7 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 		if (sidelen[0] == 0)
 			dangle3 = 0.0;
 		else
-			dangle3 = dangle_3_37_dG[pt][sequences[0][sidelen[0]]];
+			dangle3 = params->dangle_3_37_dG[pt][(int) sequences[0][sidelen[0]]];
 
 		energy += dangle3; // added for either dangle version.
 
@@ -369,11 +465,11 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 		for (loop = 0; loop < size - 1; loop++) {
 
 			rt_pt = pairtypes[sequences[loop + 2][0]][sequences[loop + 1][sidelen[loop + 1] + 1]] - 1;
-			dangle5 = dangle_5_37_dG[pt][sequences[loop + 1][1]];
-			dangle3 = dangle_3_37_dG[rt_pt][sequences[loop + 1][sidelen[loop + 1]]];
-			if (dangles == DANGLES_SOME && sidelen[loop + 1] == 1) {
+			dangle5 = params->dangle_5_37_dG[pt][(int) sequences[loop + 1][1]];
+			dangle3 = params->dangle_3_37_dG[rt_pt][(int) sequences[loop + 1][sidelen[loop + 1]]];
+			if (dangleMode == DANGLES_SOME && sidelen[loop + 1] == 1) {
 				energy += (dangle3 < dangle5 ? dangle3 : dangle5); // minimum of the two terms.
-			} else if (dangles == DANGLES_SOME && sidelen[loop + 1] == 0) {
+			} else if (dangleMode == DANGLES_SOME && sidelen[loop + 1] == 0) {
 				energy += 0.0; // dangles=DANGLES_SOME has no stacking when 0 bases between.
 							 // dangles=DANGLES_ALL, however, does. Weird, eh?
 			} else {
@@ -393,7 +489,7 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 		if (sidelen[size] == 0) {
 			dangle5 = 0.0;
 		} else {
-			dangle5 = dangle_5_37_dG[pt][sequences[size][1]];
+			dangle5 = params->dangle_5_37_dG[pt][(int) sequences[size][1]];
 		}
 
 		energy += dangle5; // added for either dangle version.
@@ -406,11 +502,313 @@ double NupackEnergyModel::OpenloopEnergy(int size, int *sidelen, char **sequence
 	return energy;
 }
 
+double NupackEnergyModel::multiloopLengthEnergy(int totallength) {
+
+	if (!logml) {
+		return params->multiloop_base * totallength;
+	} else if (totallength <= 6) {
+		return params->multiloop_base * totallength;
+	} else {
+		return params->multiloop_base * 6 + (log((double) totallength / 6.0) * log_loop_penalty / 100.0);
+	}
+
+}
+
+/*
+
+ Lower bounds for grouped creation moves
+
+ A creation move in an open or multi loop makes a new loop out of part of the old one, and
+ leaves the rest as an open or multi loop. The energy of the rest only changes in the sides
+ that the new pair cuts, the pairs that move to the new loop, and the length terms of a
+ multiloop. The bound takes the exact energy of those parts of the old loop, and the
+ smallest table entries for the new loop and the cut sides. Only the singlestranded
+ stacking of the Arrhenius model is not covered, so grouping is off in that model.
+
+ */
+
+// the sides of an open loop at its 5' and 3' ends only dangle over one pair.
+const int SIDE_FIRST = 0;
+const int SIDE_INNER = 1;
+const int SIDE_LAST = 2;
+
+// kcal/mol, so that rounding in the loop energies cannot push a move past its bound.
+const double CREATION_BOUND_MARGIN = 1e-6;
+
+static inline double min3(double a, double b, double c) {
+
+	return std::min(a, std::min(b, c));
+
+}
+
+void NupackEnergyModel::setupBounds(void) {
+
+	int loop, loop2, loop3, loop4, loop5, loop6;
+
+	bound_stack = params->stack_37_dG[0][0];
+	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
+		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
+			bound_stack = std::min(bound_stack, params->stack_37_dG[loop][loop2]);
+
+	bound_hairpin_mismatch = params->hairpin_mismatch_37_dG[0][0][0];
+	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
+		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
+			for (loop3 = 0; loop3 < NUM_BASES; loop3++)
+				bound_hairpin_mismatch = std::min(bound_hairpin_mismatch, params->hairpin_mismatch_37_dG[loop][loop2][loop3]);
+
+	bound_triloop = params->hairpin_triloop_37_dG[0];
+	for (loop = 0; loop < 1024; loop++)
+		bound_triloop = std::min(bound_triloop, params->hairpin_triloop_37_dG[loop]);
+
+	bound_tetraloop = params->hairpin_tetraloop_37_dG[0];
+	for (loop = 0; loop < 4096; loop++)
+		bound_tetraloop = std::min(bound_tetraloop, params->hairpin_tetraloop_37_dG[loop]);
+
+	bound_internal_mismatch = params->internal_mismatch_37_dG[0][0][0];
+	for (loop = 0; loop < NUM_BASES; loop++)
+		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
+			for (loop3 = 0; loop3 < NUM_BASEPAIRS_NUPACK; loop3++)
+				bound_internal_mismatch = std::min(bound_internal_mismatch, params->internal_mismatch_37_dG[loop][loop2][loop3]);
+
+	bound_internal_1_1 = params->internal_1_1_37_dG[0][0][0][0];
+	bound_internal_2_1 = params->internal_2_1_37_dG[0][0][0][0][0];
+	bound_internal_2_2 = params->internal_2_2_37_dG[0][0][0][0][0][0];
+	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
+		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
+			for (loop3 = 0; loop3 < NUM_BASES; loop3++)
+				for (loop4 = 0; loop4 < NUM_BASES; loop4++) {
+					bound_internal_1_1 = std::min(bound_internal_1_1, params->internal_1_1_37_dG[loop][loop2][loop3][loop4]);
+					for (loop5 = 0; loop5 < NUM_BASES; loop5++) {
+						bound_internal_2_1 = std::min(bound_internal_2_1, params->internal_2_1_37_dG[loop][loop5][loop2][loop3][loop4]);
+						for (loop6 = 0; loop6 < NUM_BASES; loop6++)
+							bound_internal_2_2 = std::min(bound_internal_2_2, params->internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][loop6]);
+					}
+				}
+
+	// computeInteriorEnergy uses the first four corrections.
+	bound_ninio = params->ninio_correction_37[0];
+	for (loop = 0; loop < 4; loop++)
+		bound_ninio = std::min(bound_ninio, params->ninio_correction_37[loop]);
+
+	bound_dangle_3 = params->dangle_3_37_dG[0][0];
+	bound_dangle_5 = params->dangle_5_37_dG[0][0];
+	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
+		for (loop2 = 0; loop2 < NUM_BASES; loop2++) {
+			bound_dangle_3 = std::min(bound_dangle_3, params->dangle_3_37_dG[loop][loop2]);
+			bound_dangle_5 = std::min(bound_dangle_5, params->dangle_5_37_dG[loop][loop2]);
+		}
+
+	// the AU penalty either applies or it does not.
+	bound_terminal = std::min(0.0, params->terminal_AU);
+
+	// the initialization penalty for a side of zero, one, or more bases.
+	bound_init = min3(0.0, initializationPenalty(0, 1, 2), initializationPenalty(1, 1, 2));
+
+}
+
+double NupackEnergyModel::hairpinBound(int size) {
+
+	double bound;
+
+	if (size <= 30) {
+		bound = params->hairpin_37_dG[size];
+	} else {
+		bound = params->hairpin_37_dG[30] + (log((double) size / 30.0) * log_loop_penalty / 100.0);
+	}
+
+	if (size == 3)
+		bound += bound_triloop + std::min(0.0, params->terminal_AU);
+
+	if (size == 4)
+		bound += bound_tetraloop;
+
+	if (size >= 4)
+		bound += bound_hairpin_mismatch;
+
+	return bound;
+
+}
+
+// any stack (size 0), bulge or interior loop with size unpaired bases.
+double NupackEnergyModel::interiorBound(int size) {
+
+	double bulge, interior;
+
+	if (size == 0)
+		return bound_stack;
+
+	if (size <= 30) {
+		bulge = params->bulge_37_dG[size];
+	} else {
+		bulge = params->bulge_37_dG[30] + (log((double) size / 30.0) * log_loop_penalty / 100.0);
+	}
+
+	if (size == 1)
+		return bulge + bound_stack;
+
+	bulge += 2 * std::min(0.0, params->terminal_AU);
+
+	if (size == 2) {
+		interior = bound_internal_1_1;
+	} else if (size == 3) {
+		interior = bound_internal_2_1;
+	} else {
+
+		if (size <= 30) {
+			interior = params->internal_37_dG[size];
+		} else {
+			interior = params->internal_37_dG[30] + (log((double) size / 30.0) * log_loop_penalty / 100.0);
+		}
+
+		// the asymmetry is at most size, and the correction is capped.
+		interior += std::min(params->maximum_NINIO, std::min(0.0, size * bound_ninio));
+		interior += 2 * bound_internal_mismatch;
+
+		if (size == 4) // 2x2, or the generic 1x3
+			interior = std::min(interior, bound_internal_2_2);
+	}
+
+	return std::min(bulge, interior);
+
+}
+
+// a side that a creation move cuts short, of any length. Sides with index 0 do not pay the
+// initialization penalty (or the last side of an open loop), see initializationPenalty.
+double NupackEnergyModel::sideBound(int kind, bool exempt) {
+
+	double bound = exempt ? 0.0 : bound_init;
+
+	if (dangles == DANGLES_NONE)
+		return bound;
+
+	if (kind == SIDE_FIRST)
+		return bound + std::min(0.0, bound_dangle_3);
+
+	if (kind == SIDE_LAST)
+		return bound + std::min(0.0, bound_dangle_5);
+
+	// no dangles, the smaller one (DANGLES_SOME), or both.
+	return bound + min3(0.0, std::min(bound_dangle_3, bound_dangle_5), bound_dangle_3 + bound_dangle_5);
+
+}
+
+// the terms of OpenloopEnergy / MultiloopEnergy that belong to one side.
+double NupackEnergyModel::sideEnergy(bool open, int size, int *sidelen, char **sequences, int side) {
+
+	int sides = open ? size + 1 : size;
+	int len = sidelen[side];
+	int prev = (side + sides - 1) % sides;
+	int next = (side + 1) % sides;
+	double energy = initializationPenalty(len, side, size);
+	double dangle3, dangle5;
+
+	if (dangles == DANGLES_NONE || size == 0)
+		return energy;
+
+	if (open && (side == 0 || side == size)) {
+
+		if (len == 0)
+			return energy;
+
+		if (side == 0)
+			return energy + params->dangle_3_37_dG[pairtypes[(int) sequences[next][0]][(int) sequences[side][len + 1]] - 1][(int) sequences[side][len]];
+
+		return energy + params->dangle_5_37_dG[pairtypes[(int) sequences[side][0]][(int) sequences[prev][sidelen[prev] + 1]] - 1][(int) sequences[side][1]];
+	}
+
+	if (dangles == DANGLES_SOME && len == 0)
+		return energy;
+
+	dangle5 = params->dangle_5_37_dG[pairtypes[(int) sequences[side][0]][(int) sequences[prev][sidelen[prev] + 1]] - 1][(int) sequences[side][1]];
+	dangle3 = params->dangle_3_37_dG[pairtypes[(int) sequences[next][0]][(int) sequences[side][len + 1]] - 1][(int) sequences[side][len]];
+
+	if (dangles == DANGLES_SOME && len == 1)
+		return energy + std::min(dangle3, dangle5);
+
+	return energy + dangle3 + dangle5;
+
+}
+
+double NupackEnergyModel::pairPenalty(int base1, int base2) {
+
+	int pt = pairtypes[base1][base2] - 1;
+	double energy = 0.0;
+
+	if ((pt == 0) || (pt > 2)) // AT penalty applies
+		energy += params->terminal_AU;
+	if (!gtenable && (pt > 3)) // GT penalty applies
+		energy += 100000.0;
+
+	return energy;
+
+}
+
+double NupackEnergyModel::CreationEnergyBound(bool open, int size, int *sidelen, char **sequences, int first, int last, int unpaired) {
+
+	int sides = open ? size + 1 : size;
+	int totallength = 0;
+
+	// the cut sides that stay behind. In a multiloop, only side 0 skips the initialization
+	// penalty; the second cut side is side 0 only for the pair of sides around the end.
+	bool firstEnd = open && first == 0;
+	bool lastEnd = open && last == size;
+	bool firstExempt = (first == 0);
+	bool lastExempt = open ? lastEnd : (last == 0 && first != last);
+
+	double bound = bound_terminal;
+	bound += sideBound(firstEnd ? SIDE_FIRST : SIDE_INNER, firstExempt);
+	bound += sideBound(lastEnd ? SIDE_LAST : SIDE_INNER, lastExempt);
+	bound -= sideEnergy(open, size, sidelen, sequences, first);
+
+	if (!open)
+		for (int loop = 0; loop < sides; loop++)
+			totallength += sidelen[loop];
+
+	if (first == last) {
+
+		// a hairpin; the old loop gains a side.
+		bound += hairpinBound(unpaired);
+
+		if (!open)
+			bound += params->multiloop_internal + multiloopLengthEnergy(totallength - unpaired - 2) - multiloopLengthEnergy(totallength);
+
+	} else if (last == (first + 1) % sides) {
+
+		// a stack, bulge or interior loop; the pair between the two sides leaves.
+		bound += interiorBound(unpaired);
+		bound -= sideEnergy(open, size, sidelen, sequences, last);
+		bound -= pairPenalty(sequences[first][sidelen[first] + 1], sequences[last][0]);
+
+		if (!open)
+			bound += multiloopLengthEnergy(totallength - unpaired - 2) - multiloopLengthEnergy(totallength);
+
+	} else {
+
+		// a multiloop, which takes the sides in between along with their pairs. Those
+		// terms are the same in either loop, so only the new closing pair and cut sides count.
+		int middle = 0;
+		int branches = last - first + 1;
+
+		for (int loop = first + 1; loop < last; loop++)
+			middle += sidelen[loop];
+
+		bound += params->multiloop_closing + branches * params->multiloop_internal + multiloopLengthEnergy(unpaired + middle);
+		bound += bound_terminal + sideBound(SIDE_INNER, true) + sideBound(SIDE_INNER, false);
+		bound -= sideEnergy(open, size, sidelen, sequences, last);
+
+		if (!open)
+			bound += multiloopLengthEnergy(totallength - unpaired - 2 - middle) - multiloopLengthEnergy(totallength) - (branches - 2) * params->multiloop_internal;
+	}
+
+	return bound - CREATION_BOUND_MARGIN;
+
+}
+
 // constructors, internal functions
 
 NupackEnergyModel::NupackEnergyModel(PyObject* energy_options) :
 
-		log_loop_penalty_37(107.856), kinetic_rate_method(RATE_METHOD_KAWASAKI), bimolecular_penalty(1.96), kBoltzmann(.00198717), current_temp(310.15) // Check references for this loop penalty term.
+		params(NULL), parsed(NULL), log_loop_penalty_37(107.856), kinetic_rate_method(RATE_METHOD_KAWASAKI), kBoltzmann(.00198717), current_temp(310.15) // Check references for this loop penalty term.
 {
 
 	simOptions = new PSimOptions(energy_options);
@@ -427,13 +825,49 @@ NupackEnergyModel::NupackEnergyModel(PyObject* energy_options) :
 }
 
 NupackEnergyModel::NupackEnergyModel(SimOptions* options) :
-		log_loop_penalty_37(107.856), kinetic_rate_method(RATE_METHOD_KAWASAKI), bimolecular_penalty(1.96), kBoltzmann(.00198717), current_temp(310.15) // Check references for this loop penalty term.
+		params(NULL), parsed(NULL), log_loop_penalty_37(107.856), kinetic_rate_method(RATE_METHOD_KAWASAKI), kBoltzmann(.00198717), current_temp(310.15) // Check references for this loop penalty term.
 {
 	simOptions = options;
 	processOptions();
 	computeArrheniusRates(current_temp);
 }
 
+// The kernels for the options of this model. DNA and RNA only differ in the
+// parameter tables, so they share kernels.
+void NupackEnergyModel::setupKernels(void) {
+
+	if (dangles == DANGLES_NONE)
+		setupLoopKernels<DANGLES_NONE>();
+	else if (dangles == DANGLES_SOME)
+		setupLoopKernels<DANGLES_SOME>();
+	else
+		setupLoopKernels<DANGLES_ALL>();
+
+	if (kinetic_rate_method == RATE_METHOD_KAWASAKI) {
+		rateKernel = &NupackEnergyModel::unimolecularRate<RATE_METHOD_KAWASAKI>;
+		ratesKernel = &NupackEnergyModel::unimolecularRates<RATE_METHOD_KAWASAKI>;
+	} else if (kinetic_rate_method == RATE_METHOD_METROPOLIS) {
+		rateKernel = &NupackEnergyModel::unimolecularRate<RATE_METHOD_METROPOLIS>;
+		ratesKernel = &NupackEnergyModel::unimolecularRates<RATE_METHOD_METROPOLIS>;
+	} else {
+		rateKernel = &NupackEnergyModel::unimolecularRate<RATE_METHOD_INVALID>;
+		ratesKernel = &NupackEnergyModel::unimolecularRates<RATE_METHOD_INVALID>;
+	}
+
+}
+
+template<long dangleMode>
+void NupackEnergyModel::setupLoopKernels(void) {
+
+	if (arrheniusEnabled) {
+		multiloopKernel = &NupackEnergyModel::computeMultiloopEnergy<dangleMode, true>;
+		openloopKernel = &NupackEnergyModel::computeOpenloopEnergy<dangleMode, true>;
+	} else {
+		multiloopKernel = &NupackEnergyModel::computeMultiloopEnergy<dangleMode, false>;
+		openloopKernel = &NupackEnergyModel::computeOpenloopEnergy<dangleMode, false>;
+	}
+
+}
 
 // returns a FILE pointer or prints an error message.
 FILE* NupackEnergyModel::openFiles(char* nupackhome, string& paramPath, string& fileName){
@@ -472,8 +906,7 @@ FILE* NupackEnergyModel::openFiles(char* nupackhome, string& paramPath, string&
 void NupackEnergyModel::processOptions() {
 
 	// 	This is the tough part, performing all read/input duties.
-	char in_buffer[2048];
-	int loop, loop2, loop3, loop4, loop5, loop6;
+	int loop, loop2;
 	double temperature;
 	FILE *fp = NULL, *fp2 = NULL; // fp is dG energy file, fp2 is dH.
 
@@ -487,6 +920,7 @@ void NupackEnergyModel::processOptions() {
 	logml = myEnergyOptions->getLogml();
 	gtenable = myEnergyOptions->getGtenable();
 	kinetic_rate_method = myEnergyOptions->getKineticRateMethod();
+	arrheniusEnabled = myEnergyOptions->usingArrhenius();
 
 	waterdensity = setWaterDensity(temperature - TEMPERATURE_ZERO_CELSIUS_IN_KELVIN);
 
@@ -545,6 +979,50 @@ void NupackEnergyModel::processOptions() {
 
 	}
 
+	// the processed tables of an earlier run, see ParameterCache
+	ParameterKey key;
+	bool cacheable = ParameterCache::makeKey(key, fp, fp2, temperature, myEnergyOptions->sodium, myEnergyOptions->magnesium);
+
+	params = cacheable ? ParameterCache::find(key) : NULL;
+
+	if (params != NULL) {
+		fclose(fp);
+		fclose(fp2);
+	} else {
+		parsed = new NupackParameters;
+		memset(parsed, 0, sizeof(NupackParameters));
+		parsed->bimolecular_penalty = 1.96;
+
+		readParameters(fp, fp2, temperature);
+
+		const NupackParameters* stored = cacheable ? ParameterCache::store(key, parsed) : NULL;
+
+		if (stored != NULL) {
+			delete parsed;
+			parsed = NULL;
+			params = stored;
+		} else {
+			params = parsed;
+		}
+	}
+
+	_RT = kBoltzmann * temperature;
+	log_loop_penalty = 100.0 * 1.75 * kBoltzmann * temperature;
+
+	if (!  ((temperature < CELSIUS37_IN_KELVIN - .00001) || (temperature > CELSIUS37_IN_KELVIN + .00001))   )
+		current_temp = CELSIUS37_IN_KELVIN;
+
+	setupRates();
+	setupBounds();
+	setupKernels();
+}
+
+// Reads the dG and dH tables into parsed and scales them to the temperature.
+void NupackEnergyModel::readParameters(FILE *fp, FILE *fp2, double temperature) {
+
+	char in_buffer[2048];
+	int loop, loop2, loop3, loop4, loop5, loop6;
+
 	fgets(in_buffer, 2048, fp);
 	while (!feof(fp)) {
 		if (in_buffer[0] == '>') // data area or comment (mfold)
@@ -822,74 +1300,68 @@ void NupackEnergyModel::processOptions() {
 // Temperature change section.
 //  double getDoubleAttr(energy_options, temperature,&temperature);
 
-	_RT = kBoltzmann * current_temp;
-	log_loop_penalty = 100.0 * 1.75 * kBoltzmann * current_temp;
-
-	if (!  ((temperature < CELSIUS37_IN_KELVIN - .00001) || (temperature > CELSIUS37_IN_KELVIN + .00001))   ) {
-		current_temp = CELSIUS37_IN_KELVIN;
-		setupRates();
+	if (!  ((temperature < CELSIUS37_IN_KELVIN - .00001) || (temperature > CELSIUS37_IN_KELVIN + .00001))   )
 		return;
-	}
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++){
 		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++){
 
-			stack_37_dG[loop][loop2] = T_scale(stack_37_dG[loop][loop2], stack_37_dH[loop][loop2], temperature);
+			parsed->stack_37_dG[loop][loop2] = T_scale(parsed->stack_37_dG[loop][loop2], parsed->stack_37_dH[loop][loop2], temperature);
 			// now adjusting for a single salt correction term.
-			stack_37_dG[loop][loop2] += saltCorrection(2)* -temperature / 1000.0;
+			parsed->stack_37_dG[loop][loop2] += saltCorrection(2)* -temperature / 1000.0;
 		}
 	}
 
 
 	for (loop = 0; loop < 31; loop++)
-		hairpin_37_dG[loop] = T_scale(hairpin_37_dG[loop], hairpin_37_dH[loop], temperature);
+		parsed->hairpin_37_dG[loop] = T_scale(parsed->hairpin_37_dG[loop], parsed->hairpin_37_dH[loop], temperature);
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASES; loop3++)
-				hairpin_mismatch_37_dG[loop][loop2][loop3] = T_scale(hairpin_mismatch_37_dG[loop][loop2][loop3], hairpin_mismatch_37_dH[loop][loop2][loop3],
+				parsed->hairpin_mismatch_37_dG[loop][loop2][loop3] = T_scale(parsed->hairpin_mismatch_37_dG[loop][loop2][loop3], parsed->hairpin_mismatch_37_dH[loop][loop2][loop3],
 						temperature);
 
 	for (loop = 0; loop < 4096; loop++)
-		*(double *) (hairpin_tetraloop_37_dG + loop) = T_scale(*(double *) (hairpin_tetraloop_37_dG + loop), *(int *) (hairpin_tetraloop_37_dH + loop),
+		*(double *) (parsed->hairpin_tetraloop_37_dG + loop) = T_scale(*(double *) (parsed->hairpin_tetraloop_37_dG + loop), *(int *) (parsed->hairpin_tetraloop_37_dH + loop),
 				temperature);
 
 	for (loop = 0; loop < 1024; loop++)
-		*(double *) (hairpin_triloop_37_dG + loop) = T_scale(*(double *) (hairpin_triloop_37_dG + loop), *(int *) (hairpin_triloop_37_dH + loop), temperature);
+		*(double *) (parsed->hairpin_triloop_37_dG + loop) = T_scale(*(double *) (parsed->hairpin_triloop_37_dG + loop), *(int *) (parsed->hairpin_triloop_37_dH + loop), temperature);
 
 	for (loop = 0; loop < 31; loop++)
-		bulge_37_dG[loop] = T_scale(bulge_37_dG[loop], bulge_37_dH[loop], temperature);
+		parsed->bulge_37_dG[loop] = T_scale(parsed->bulge_37_dG[loop], parsed->bulge_37_dH[loop], temperature);
 
 	for (loop = 0; loop < 31; loop++)
-		internal_37_dG[loop] = T_scale(internal_37_dG[loop], internal_37_dH[loop], temperature);
+		parsed->internal_37_dG[loop] = T_scale(parsed->internal_37_dG[loop], parsed->internal_37_dH[loop], temperature);
 
 	for (loop = 0; loop < NUM_BASES; loop++)
 		//  for( loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++ )
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASEPAIRS_NUPACK; loop3++)
 				//      for( loop3 = 0; loop3 < NUM_BASES; loop3++ )
-				internal_mismatch_37_dG[loop][loop2][loop3] = T_scale(internal_mismatch_37_dG[loop][loop2][loop3], internal_mismatch_37_dH[loop][loop2][loop3],
+				parsed->internal_mismatch_37_dG[loop][loop2][loop3] = T_scale(parsed->internal_mismatch_37_dG[loop][loop2][loop3], parsed->internal_mismatch_37_dH[loop][loop2][loop3],
 						temperature);
 
-	maximum_NINIO = T_scale(maximum_NINIO, maximum_NINIO_dH, temperature);
+	parsed->maximum_NINIO = T_scale(parsed->maximum_NINIO, parsed->maximum_NINIO_dH, temperature);
 
 	for (loop = 0; loop < 5; loop++)
-		ninio_correction_37[loop] = T_scale(ninio_correction_37[loop], ninio_correction_37_dH[loop], temperature);
+		parsed->ninio_correction_37[loop] = T_scale(parsed->ninio_correction_37[loop], parsed->ninio_correction_37_dH[loop], temperature);
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASES; loop3++)
 				for (loop4 = 0; loop4 < NUM_BASES; loop4++)
-					internal_1_1_37_dG[loop][loop2][loop3][loop4] = T_scale(internal_1_1_37_dG[loop][loop2][loop3][loop4],
-							internal_1_1_37_dH[loop][loop2][loop3][loop4], temperature);
+					parsed->internal_1_1_37_dG[loop][loop2][loop3][loop4] = T_scale(parsed->internal_1_1_37_dG[loop][loop2][loop3][loop4],
+							parsed->internal_1_1_37_dH[loop][loop2][loop3][loop4], temperature);
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop5 = 0; loop5 < NUM_BASES; loop5++)
 			for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
 				for (loop3 = 0; loop3 < NUM_BASES; loop3++)
 					for (loop4 = 0; loop4 < NUM_BASES; loop4++)
-						internal_2_1_37_dG[loop][loop5][loop2][loop3][loop4] = T_scale(internal_2_1_37_dG[loop][loop5][loop2][loop3][loop4],
-								internal_2_1_37_dH[loop][loop5][loop2][loop3][loop4], temperature);
+						parsed->internal_2_1_37_dG[loop][loop5][loop2][loop3][loop4] = T_scale(parsed->internal_2_1_37_dG[loop][loop5][loop2][loop3][loop4],
+								parsed->internal_2_1_37_dH[loop][loop5][loop2][loop3][loop4], temperature);
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
@@ -897,32 +1369,25 @@ void NupackEnergyModel::processOptions() {
 				for (loop4 = 0; loop4 < NUM_BASES; loop4++)
 					for (loop5 = 0; loop5 < NUM_BASES; loop5++)
 						for (loop6 = 0; loop6 < NUM_BASES; loop6++)
-							internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][loop6] = T_scale(internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][loop6],
-									internal_2_2_37_dH[loop][loop2][loop3][loop4][loop5][loop6], temperature);
+							parsed->internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][loop6] = T_scale(parsed->internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][loop6],
+									parsed->internal_2_2_37_dH[loop][loop2][loop3][loop4][loop5][loop6], temperature);
 
-	multiloop_base = T_scale(multiloop_base, multiloop_base_dH, temperature);
-	multiloop_closing = T_scale(multiloop_closing, multiloop_closing_dH, temperature);
-	multiloop_internal = T_scale(multiloop_internal, multiloop_internal_dH, temperature);
+	parsed->multiloop_base = T_scale(parsed->multiloop_base, parsed->multiloop_base_dH, temperature);
+	parsed->multiloop_closing = T_scale(parsed->multiloop_closing, parsed->multiloop_closing_dH, temperature);
+	parsed->multiloop_internal = T_scale(parsed->multiloop_internal, parsed->multiloop_internal_dH, temperature);
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
-			dangle_3_37_dG[loop][loop2] = T_scale(dangle_3_37_dG[loop][loop2], dangle_3_37_dH[loop][loop2], temperature);
+			parsed->dangle_3_37_dG[loop][loop2] = T_scale(parsed->dangle_3_37_dG[loop][loop2], parsed->dangle_3_37_dH[loop][loop2], temperature);
 
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
-			dangle_5_37_dG[loop][loop2] = T_scale(dangle_5_37_dG[loop][loop2], dangle_5_37_dH[loop][loop2], temperature);
+			parsed->dangle_5_37_dG[loop][loop2] = T_scale(parsed->dangle_5_37_dG[loop][loop2], parsed->dangle_5_37_dH[loop][loop2], temperature);
 
-	terminal_AU = T_scale(terminal_AU, terminal_AU_dH, temperature);
+	parsed->terminal_AU = T_scale(parsed->terminal_AU, parsed->terminal_AU_dH, temperature);
 
-	bimolecular_penalty = T_scale(bimolecular_penalty, bimolecular_penalty_dH, temperature);
+	parsed->bimolecular_penalty = T_scale(parsed->bimolecular_penalty, parsed->bimolecular_penalty_dH, temperature);
 // need additional conversion as well
-
-	_RT = kBoltzmann * temperature;
-	current_temp = temperature;
-
-//	cout << "Current Temperature is " << current_temp << "\n";
-
-	setupRates();
 }
 
 /* ------------------------------------------------------------------------
@@ -941,13 +1406,13 @@ void NupackEnergyModel::internal_set_stack_energies(FILE *fp, char *buffer) {
 		fgets(buffer, 2048, fp);
 //      for( loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++ )
 //	{
-//	  stack_37_dG[loop][NUM_BASEPAIRS_NUPACK-1] = 0;
-//	  stack_37_dG[NUM_BASEPAIRS_NUPACK-1][loop] = 0;
+//	  parsed->stack_37_dG[loop][NUM_BASEPAIRS_NUPACK-1] = 0;
+//	  parsed->stack_37_dG[NUM_BASEPAIRS_NUPACK-1][loop] = 0;
 //	}
 //    }
 	cur_bufspot = buffer;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++) {
-		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &stack_37_dG[loop][0], NUM_BASEPAIRS_NUPACK);
+		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->stack_37_dG[loop][0], NUM_BASEPAIRS_NUPACK);
 	}
 }
 
@@ -961,39 +1426,39 @@ void NupackEnergyModel::internal_set_stack_enthalpies(FILE *fp, char *buffer) {
 
 	cur_bufspot = buffer;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++) {
-		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &stack_37_dH[loop][0], NUM_BASEPAIRS_NUPACK);
+		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->stack_37_dH[loop][0], NUM_BASEPAIRS_NUPACK);
 	}
 
 }
 
 void NupackEnergyModel::internal_set_hairpin_energies(FILE *fp, char *buffer) {
-	hairpin_37_dG[0] = 0;
-	internal_read_array_data(fp, buffer, buffer, &hairpin_37_dG[1], 30);
+	parsed->hairpin_37_dG[0] = 0;
+	internal_read_array_data(fp, buffer, buffer, &parsed->hairpin_37_dG[1], 30);
 }
 
 void NupackEnergyModel::internal_set_hairpin_enthalpies(FILE *fp, char *buffer) {
-	hairpin_37_dH[0] = 0;
-	internal_read_array_data(fp, buffer, buffer, &hairpin_37_dH[1], 30);
+	parsed->hairpin_37_dH[0] = 0;
+	internal_read_array_data(fp, buffer, buffer, &parsed->hairpin_37_dH[1], 30);
 }
 
 void NupackEnergyModel::internal_set_bulge_energies(FILE *fp, char *buffer) {
-	bulge_37_dG[0] = 0;
-	internal_read_array_data(fp, buffer, buffer, &bulge_37_dG[1], 30);
+	parsed->bulge_37_dG[0] = 0;
+	internal_read_array_data(fp, buffer, buffer, &parsed->bulge_37_dG[1], 30);
 }
 
 void NupackEnergyModel::internal_set_bulge_enthalpies(FILE *fp, char *buffer) {
-	bulge_37_dH[0] = 0;
-	internal_read_array_data(fp, buffer, buffer, &bulge_37_dH[1], 30);
+	parsed->bulge_37_dH[0] = 0;
+	internal_read_array_data(fp, buffer, buffer, &parsed->bulge_37_dH[1], 30);
 }
 
 void NupackEnergyModel::internal_set_interior_loop_energies(FILE *fp, char *buffer) {
-	internal_37_dG[0] = 0;
-	internal_read_array_data(fp, buffer, buffer, &internal_37_dG[1], 30);
+	parsed->internal_37_dG[0] = 0;
+	internal_read_array_data(fp, buffer, buffer, &parsed->internal_37_dG[1], 30);
 }
 
 void NupackEnergyModel::internal_set_interior_loop_enthalpies(FILE *fp, char *buffer) {
-	internal_37_dH[0] = 0;
-	internal_read_array_data(fp, buffer, buffer, &internal_37_dH[1], 30);
+	parsed->internal_37_dH[0] = 0;
+	internal_read_array_data(fp, buffer, buffer, &parsed->internal_37_dH[1], 30);
 }
 
 void NupackEnergyModel::internal_set_interior_1_1_energies(FILE *fp, char *buffer) {
@@ -1012,12 +1477,12 @@ void NupackEnergyModel::internal_set_interior_1_1_energies(FILE *fp, char *buffe
 				fgets(buffer, 2048, fp); // eat the lines with AT..AT, etc, just in case.
 
 			for (loop3 = 0; loop3 < NUM_BASES; loop3++) {
-				internal_1_1_37_dG[loop][loop2][loop3][0] = 0;
-				internal_1_1_37_dG[loop][loop2][0][loop3] = 0;
+				parsed->internal_1_1_37_dG[loop][loop2][loop3][0] = 0;
+				parsed->internal_1_1_37_dG[loop][loop2][0][loop3] = 0;
 			}
 
 			for (loop3 = 1; loop3 < NUM_BASES; loop3++) {
-				cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_1_1_37_dG[loop][loop2][loop3][1], NUM_BASES - 1);
+				cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_1_1_37_dG[loop][loop2][loop3][1], NUM_BASES - 1);
 			}
 
 		}
@@ -1041,12 +1506,12 @@ void NupackEnergyModel::internal_set_interior_1_1_enthalpies(FILE *fp, char *buf
 			}
 
 			for (loop3 = 0; loop3 < NUM_BASES; loop3++) {
-				internal_1_1_37_dG[loop][loop2][loop3][0] = 0;
-				internal_1_1_37_dG[loop][loop2][0][loop3] = 0;
+				parsed->internal_1_1_37_dG[loop][loop2][loop3][0] = 0;
+				parsed->internal_1_1_37_dG[loop][loop2][0][loop3] = 0;
 			}
 
 			for (loop3 = 1; loop3 < NUM_BASES; loop3++) {
-				cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_1_1_37_dH[loop][loop2][loop3][1], NUM_BASES - 1);
+				cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_1_1_37_dH[loop][loop2][loop3][1], NUM_BASES - 1);
 			}
 
 		}
@@ -1070,7 +1535,7 @@ void NupackEnergyModel::internal_set_interior_2_1_energies(FILE *fp, char *buffe
 
 			for (loop3 = 1; loop3 < NUM_BASES; loop3++) {
 				for (loop4 = 1; loop4 < NUM_BASES; loop4++) {
-					cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_2_1_37_dG[loop][loop3][loop2][loop4][1], (NUM_BASES - 1));
+					cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_2_1_37_dG[loop][loop3][loop2][loop4][1], (NUM_BASES - 1));
 				}
 			}
 		}
@@ -1092,7 +1557,7 @@ void NupackEnergyModel::internal_set_interior_2_1_enthalpies(FILE *fp, char *buf
 
 			for (loop3 = 1; loop3 < NUM_BASES; loop3++) {
 				for (loop4 = 1; loop4 < NUM_BASES; loop4++)
-					cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_2_1_37_dH[loop][loop3][loop2][loop4][1], (NUM_BASES - 1));
+					cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_2_1_37_dH[loop][loop3][loop2][loop4][1], (NUM_BASES - 1));
 			}
 		}
 	}
@@ -1114,7 +1579,7 @@ void NupackEnergyModel::internal_set_interior_2_2_energies(FILE *fp, char *buffe
 			for (loop3 = 1; loop3 < NUM_BASES; loop3++) {
 				for (loop4 = 1; loop4 < NUM_BASES; loop4++) {
 					for (loop5 = 1; loop5 < NUM_BASES; loop5++) {
-						cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][1],
+						cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_2_2_37_dG[loop][loop2][loop3][loop4][loop5][1],
 								NUM_BASES - 1);
 					}
 				}
@@ -1139,7 +1604,7 @@ void NupackEnergyModel::internal_set_interior_2_2_enthalpies(FILE *fp, char *buf
 			for (loop3 = 1; loop3 < NUM_BASES; loop3++) {
 				for (loop4 = 1; loop4 < NUM_BASES; loop4++) {
 					for (loop5 = 1; loop5 < NUM_BASES; loop5++) {
-						cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_2_2_37_dH[loop][loop2][loop3][loop4][loop5][1],
+						cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_2_2_37_dH[loop][loop2][loop3][loop4][loop5][1],
 								NUM_BASES - 1);
 					}
 				}
@@ -1156,11 +1621,11 @@ void NupackEnergyModel::internal_set_dangle_5_energies(FILE *fp, char *buffer) {
 	int loop, loop2;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
-			dangle_5_37_dG[loop][loop2] = 0.0;
+			parsed->dangle_5_37_dG[loop][loop2] = 0.0;
 
 	cur_bufspot = buffer;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
-		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &dangle_5_37_dG[loop][1], NUM_BASES - 1);
+		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->dangle_5_37_dG[loop][1], NUM_BASES - 1);
 }
 
 void NupackEnergyModel::internal_set_dangle_5_enthalpies(FILE *fp, char *buffer) {
@@ -1171,11 +1636,11 @@ void NupackEnergyModel::internal_set_dangle_5_enthalpies(FILE *fp, char *buffer)
 	int loop, loop2;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
-			dangle_5_37_dH[loop][loop2] = 0;
+			parsed->dangle_5_37_dH[loop][loop2] = 0;
 
 	cur_bufspot = buffer;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
-		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &dangle_5_37_dH[loop][1], NUM_BASES - 1);
+		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->dangle_5_37_dH[loop][1], NUM_BASES - 1);
 }
 
 void NupackEnergyModel::internal_set_dangle_3_energies(FILE *fp, char *buffer) {
@@ -1186,11 +1651,11 @@ void NupackEnergyModel::internal_set_dangle_3_energies(FILE *fp, char *buffer) {
 	int loop, loop2;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
-			dangle_3_37_dG[loop][loop2] = 0.0;
+			parsed->dangle_3_37_dG[loop][loop2] = 0.0;
 
 	cur_bufspot = buffer;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
-		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &dangle_3_37_dG[loop][1], NUM_BASES - 1);
+		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->dangle_3_37_dG[loop][1], NUM_BASES - 1);
 }
 
 void NupackEnergyModel::internal_set_dangle_3_enthalpies(FILE *fp, char *buffer) {
@@ -1201,11 +1666,11 @@ void NupackEnergyModel::internal_set_dangle_3_enthalpies(FILE *fp, char *buffer)
 	int loop, loop2;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
-			dangle_3_37_dH[loop][loop2] = 0;
+			parsed->dangle_3_37_dH[loop][loop2] = 0;
 
 	cur_bufspot = buffer;
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
-		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &dangle_3_37_dH[loop][1], NUM_BASES - 1);
+		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->dangle_3_37_dH[loop][1], NUM_BASES - 1);
 }
 
 void NupackEnergyModel::internal_set_multiloop_parameters(FILE *fp, char *buffer) {
@@ -1214,9 +1679,9 @@ void NupackEnergyModel::internal_set_multiloop_parameters(FILE *fp, char *buffer
 		fgets(buffer, 2048, fp);
 
 	internal_read_array_data(fp, buffer, buffer, temp, 3);
-	multiloop_base = temp[2];
-	multiloop_closing = temp[0];
-	multiloop_internal = temp[1];
+	parsed->multiloop_base = temp[2];
+	parsed->multiloop_closing = temp[0];
+	parsed->multiloop_internal = temp[1];
 }
 
 void NupackEnergyModel::internal_set_multiloop_parameters_enthalpies(FILE *fp, char *buffer) {
@@ -1226,23 +1691,23 @@ void NupackEnergyModel::internal_set_multiloop_parameters_enthalpies(FILE *fp, c
 		fgets(buffer, 2048, fp);
 
 	internal_read_array_data(fp, buffer, buffer, temp, 3);
-	multiloop_base_dH = temp[2];
-	multiloop_closing_dH = temp[0];
-	multiloop_internal_dH = temp[1];
+	parsed->multiloop_base_dH = temp[2];
+	parsed->multiloop_closing_dH = temp[0];
+	parsed->multiloop_internal_dH = temp[1];
 }
 
 void NupackEnergyModel::internal_set_at_penalty(FILE *fp, char *buffer) {
 	while (buffer[0] == '>')
 		fgets(buffer, 2048, fp);
 
-	internal_read_array_data(fp, buffer, buffer, &terminal_AU, 1);
+	internal_read_array_data(fp, buffer, buffer, &parsed->terminal_AU, 1);
 }
 
 void NupackEnergyModel::internal_set_at_penalty_enthalpy(FILE *fp, char *buffer) {
 	while (buffer[0] == '>')
 		fgets(buffer, 2048, fp);
 
-	internal_read_array_data(fp, buffer, buffer, &terminal_AU_dH, 1);
+	internal_read_array_data(fp, buffer, buffer, &parsed->terminal_AU_dH, 1);
 }
 
 void NupackEnergyModel::internal_set_bimolecular_penalty(FILE *fp, char *buffer) {
@@ -1250,14 +1715,14 @@ void NupackEnergyModel::internal_set_bimolecular_penalty(FILE *fp, char *buffer)
 	while (buffer[0] == '>')
 		fgets(buffer, 2048, fp);
 
-	internal_read_array_data(fp, buffer, buffer, &bimolecular_penalty, 1);
+	internal_read_array_data(fp, buffer, buffer, &parsed->bimolecular_penalty, 1);
 }
 
 void NupackEnergyModel::internal_set_bimolecular_penalty_dH(FILE *fp, char *buffer) {
 	while (buffer[0] == '>')
 		fgets(buffer, 2048, fp);
 
-	internal_read_array_data(fp, buffer, buffer, &bimolecular_penalty_dH, 1);
+	internal_read_array_data(fp, buffer, buffer, &parsed->bimolecular_penalty_dH, 1);
 }
 
 void NupackEnergyModel::internal_set_ninio_parameters(FILE *fp, char *buffer) {
@@ -1265,11 +1730,11 @@ void NupackEnergyModel::internal_set_ninio_parameters(FILE *fp, char *buffer) {
 	while (buffer[0] == '>')
 		fgets(buffer, 2048, fp);
 	internal_read_array_data(fp, buffer, buffer, temp, 5);
-	maximum_NINIO = temp[4];
-	ninio_correction_37[0] = temp[0];
-	ninio_correction_37[1] = temp[1];
-	ninio_correction_37[2] = temp[2];
-	ninio_correction_37[3] = temp[3];
+	parsed->maximum_NINIO = temp[4];
+	parsed->ninio_correction_37[0] = temp[0];
+	parsed->ninio_correction_37[1] = temp[1];
+	parsed->ninio_correction_37[2] = temp[2];
+	parsed->ninio_correction_37[3] = temp[3];
 }
 
 void NupackEnergyModel::internal_set_ninio_parameters_enthalpy(FILE *fp, char *buffer) {
@@ -1277,11 +1742,11 @@ void NupackEnergyModel::internal_set_ninio_parameters_enthalpy(FILE *fp, char *b
 	while (buffer[0] == '>')
 		fgets(buffer, 2048, fp);
 	internal_read_array_data(fp, buffer, buffer, temp, 5);
-	maximum_NINIO_dH = temp[4];
-	ninio_correction_37_dH[0] = temp[0];
-	ninio_correction_37_dH[1] = temp[1];
-	ninio_correction_37_dH[2] = temp[2];
-	ninio_correction_37_dH[3] = temp[3];
+	parsed->maximum_NINIO_dH = temp[4];
+	parsed->ninio_correction_37_dH[0] = temp[0];
+	parsed->ninio_correction_37_dH[1] = temp[1];
+	parsed->ninio_correction_37_dH[2] = temp[2];
+	parsed->ninio_correction_37_dH[3] = temp[3];
 }
 
 void NupackEnergyModel::internal_set_hairpin_tetraloop_parameters(FILE *fp, char *buffer) {
@@ -1293,7 +1758,7 @@ void NupackEnergyModel::internal_set_hairpin_tetraloop_parameters(FILE *fp, char
 // NOTE:: 4096 = (NUM_BASES-1)^6
 // Initialize the tetraloop parameters to 0.
 	for (int loop = 0; loop < 4096; loop++) {
-		hairpin_tetraloop_37_dG[loop] = 0.0;
+		parsed->hairpin_tetraloop_37_dG[loop] = 0.0;
 	}
 
 	while (strlen(buffer) > 7 && buffer[0] != '>') {
@@ -1304,7 +1769,7 @@ void NupackEnergyModel::internal_set_hairpin_tetraloop_parameters(FILE *fp, char
 		lookup_index = ((baseLookup(buffer[buf_index + 0]) - 1) << 10) + ((baseLookup(buffer[buf_index + 1]) - 1) << 8)
 				+ ((baseLookup(buffer[buf_index + 2]) - 1) << 6) + ((baseLookup(buffer[buf_index + 3]) - 1) << 4)
 				+ ((baseLookup(buffer[buf_index + 4]) - 1) << 2) + (baseLookup(buffer[buf_index + 5]) - 1);
-		hairpin_tetraloop_37_dG[lookup_index] = atof(&buffer[buf_index + 6]) / 100.0;
+		parsed->hairpin_tetraloop_37_dG[lookup_index] = atof(&buffer[buf_index + 6]) / 100.0;
 
 		fgets(buffer, 2048, fp);
 	}
@@ -1322,7 +1787,7 @@ void NupackEnergyModel::internal_set_hairpin_tetraloop_parameters_enthalpy(FILE
 // NOTE:: 4096 = (NUM_BASES-1)^6
 // Initialize the tetraloop parameters to 0.
 	for (int loop = 0; loop < 4096; loop++) {
-		hairpin_tetraloop_37_dH[loop] = 0;
+		parsed->hairpin_tetraloop_37_dH[loop] = 0;
 	}
 
 	while (strlen(buffer) > 7 && buffer[0] != '>') {
@@ -1333,7 +1798,7 @@ void NupackEnergyModel::internal_set_hairpin_tetraloop_parameters_enthalpy(FILE
 		lookup_index = ((baseLookup(buffer[buf_index + 0]) - 1) << 10) + ((baseLookup(buffer[buf_index + 1]) - 1) << 8)
 				+ ((baseLookup(buffer[buf_index + 2]) - 1) << 6) + ((baseLookup(buffer[buf_index + 3]) - 1) << 4)
 				+ ((baseLookup(buffer[buf_index + 4]) - 1) << 2) + (baseLookup(buffer[buf_index + 5]) - 1);
-		hairpin_tetraloop_37_dH[lookup_index] = atoi(&buffer[buf_index + 6]);
+		parsed->hairpin_tetraloop_37_dH[lookup_index] = atoi(&buffer[buf_index + 6]);
 
 		fgets(buffer, 2048, fp);
 	}
@@ -1347,7 +1812,7 @@ void NupackEnergyModel::internal_set_hairpin_triloop_parameters(FILE *fp, char *
 // NOTE:: 1024 = (NUM_BASES-1)^5
 // Initialize the triloop parameters to 0.
 	for (int loop = 0; loop < 1024; loop++) {
-		hairpin_triloop_37_dG[loop] = 0.0;
+		parsed->hairpin_triloop_37_dG[loop] = 0.0;
 	}
 	while (strlen(buffer) > 6 && buffer[0] != '>') {
 		buf_index = 0;
@@ -1355,7 +1820,7 @@ void NupackEnergyModel::internal_set_hairpin_triloop_parameters(FILE *fp, char *
 			buf_index++;
 		lookup_index = ((baseLookup(buffer[buf_index + 0]) - 1) << 8) + ((baseLookup(buffer[buf_index + 1]) - 1) << 6)
 				+ ((baseLookup(buffer[buf_index + 2]) - 1) << 4) + ((baseLookup(buffer[buf_index + 3]) - 1) << 2) + (baseLookup(buffer[buf_index + 4]) - 1);
-		hairpin_triloop_37_dG[lookup_index] = atof(&buffer[buf_index + 5]) / 100.0;
+		parsed->hairpin_triloop_37_dG[lookup_index] = atof(&buffer[buf_index + 5]) / 100.0;
 
 		fgets(buffer, 2048, fp);
 	}
@@ -1372,7 +1837,7 @@ void NupackEnergyModel::internal_set_hairpin_triloop_parameters_enthalpy(FILE *f
 // NOTE:: 1024 = (NUM_BASES-1)^5
 // Initialize the triloop parameters to 0.
 	for (int loop = 0; loop < 1024; loop++) {
-		hairpin_triloop_37_dH[loop] = 0;
+		parsed->hairpin_triloop_37_dH[loop] = 0;
 	}
 
 	while (strlen(buffer) > 6 && buffer[0] != '>') {
@@ -1383,7 +1848,7 @@ void NupackEnergyModel::internal_set_hairpin_triloop_parameters_enthalpy(FILE *f
 		lookup_index = ((baseLookup(buffer[buf_index + 0]) - 1) << 8) + ((baseLookup(buffer[buf_index + 1]) - 1) << 6)
 				+ ((baseLookup(buffer[buf_index + 2]) - 1) << 4) + ((baseLookup(buffer[buf_index + 3]) - 1) << 2) + (baseLookup(buffer[buf_index + 4]) - 1);
 
-		hairpin_triloop_37_dH[lookup_index] = atoi(&buffer[buf_index + 5]);
+		parsed->hairpin_triloop_37_dH[lookup_index] = atoi(&buffer[buf_index + 5]);
 
 		fgets(buffer, 2048, fp);
 	}
@@ -1400,13 +1865,13 @@ void NupackEnergyModel::internal_set_hairpin_mismatch_energies(FILE *fp, char *b
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASES; loop3++)
-				hairpin_mismatch_37_dG[loop][loop2][loop3] = 0;
+				parsed->hairpin_mismatch_37_dG[loop][loop2][loop3] = 0;
 
 	for (loop = 0; loop < (NUM_BASES - 1) * (NUM_BASES - 1); loop++) {
 		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &temp[0], NUM_BASEPAIRS_NUPACK);
 		loop3 = (loop - (loop % (NUM_BASES - 1))) / (NUM_BASES - 1);
 		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
-			hairpin_mismatch_37_dG[loop2][loop3 + 1][(loop % (NUM_BASES - 1)) + 1] = temp[loop2];
+			parsed->hairpin_mismatch_37_dG[loop2][loop3 + 1][(loop % (NUM_BASES - 1)) + 1] = temp[loop2];
 
 	}
 }
@@ -1422,13 +1887,13 @@ void NupackEnergyModel::internal_set_hairpin_mismatch_enthalpies(FILE *fp, char
 	for (loop = 0; loop < NUM_BASEPAIRS_NUPACK; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASES; loop3++)
-				hairpin_mismatch_37_dH[loop][loop2][loop3] = 0;
+				parsed->hairpin_mismatch_37_dH[loop][loop2][loop3] = 0;
 
 	for (loop = 0; loop < (NUM_BASES - 1) * (NUM_BASES - 1); loop++) {
 		cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &temp[0], NUM_BASEPAIRS_NUPACK);
 		loop3 = (loop - (loop % (NUM_BASES - 1))) / (NUM_BASES - 1);
 		for (loop2 = 0; loop2 < NUM_BASEPAIRS_NUPACK; loop2++)
-			hairpin_mismatch_37_dH[loop2][loop3 + 1][(loop % (NUM_BASES - 1)) + 1] = temp[loop2];
+			parsed->hairpin_mismatch_37_dH[loop2][loop3 + 1][(loop % (NUM_BASES - 1)) + 1] = temp[loop2];
 
 	}
 }
@@ -1443,11 +1908,11 @@ void NupackEnergyModel::internal_set_interior_loop_mismatch_energies(FILE *fp, c
 	for (loop = 0; loop < NUM_BASES; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASEPAIRS_NUPACK; loop3++)
-				internal_mismatch_37_dG[loop][loop2][loop3] = 0;
+				parsed->internal_mismatch_37_dG[loop][loop2][loop3] = 0;
 
 	for (loop = 1; loop < NUM_BASES; loop++)
 		for (loop2 = 1; loop2 < NUM_BASES; loop2++) {
-			cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_mismatch_37_dG[loop][loop2][0], NUM_BASEPAIRS_NUPACK);
+			cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_mismatch_37_dG[loop][loop2][0], NUM_BASEPAIRS_NUPACK);
 		}
 
 }
@@ -1462,11 +1927,11 @@ void NupackEnergyModel::internal_set_interior_loop_mismatch_enthalpies(FILE *fp,
 	for (loop = 0; loop < NUM_BASES; loop++)
 		for (loop2 = 0; loop2 < NUM_BASES; loop2++)
 			for (loop3 = 0; loop3 < NUM_BASEPAIRS_NUPACK; loop3++)
-				internal_mismatch_37_dH[loop][loop2][loop3] = 0;
+				parsed->internal_mismatch_37_dH[loop][loop2][loop3] = 0;
 
 	for (loop = 1; loop < NUM_BASES; loop++)
 		for (loop2 = 1; loop2 < NUM_BASES; loop2++) {
-			cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &internal_mismatch_37_dH[loop][loop2][0], NUM_BASEPAIRS_NUPACK);
+			cur_bufspot = internal_read_array_data(fp, buffer, cur_bufspot, &parsed->internal_mismatch_37_dH[loop][loop2][0], NUM_BASEPAIRS_NUPACK);
 		}
 }
 
@@ -1630,7 +2095,7 @@ void NupackEnergyModel::setupRates() {
 	joinrate_volume = joinconc;
 
 // concentration units
-	dG_assoc = bimolecular_penalty; // already computed and scaled for water density.
+	dG_assoc = params->bimolecular_penalty; // already computed and scaled for water density.
 
 	joinrate = biscale * joinrate_volume;
 
@@ -0,0 +1,225 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <mutex>
+#include <vector>
+#include "parametercache.h"
+
+const char PARAMETERCACHE_MAGIC[8] = { 'M', 'S', 'P', 'A', 'R', 'A', 'M', 0 };
+
+struct ParameterFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t size; // of NupackParameters
+	ParameterKey key;
+};
+
+// the tables start after the header, aligned for any of their members.
+const size_t PARAMETERCACHE_OFFSET = (sizeof(ParameterFileHeader) + 63) / 64 * 64;
+const size_t PARAMETERCACHE_FILESIZE = PARAMETERCACHE_OFFSET + sizeof(NupackParameters);
+
+// the tables mapped so far in this process, never unmapped.
+struct MappedParameters {
+	ParameterKey key;
+	const NupackParameters* tables;
+};
+
+static std::mutex mappedLock;
+static std::vector<MappedParameters> mapped;
+
+static const NupackParameters* findMapped(const ParameterKey& key) {
+
+	for (size_t i = 0; i < mapped.size(); i++)
+		if (memcmp(&mapped[i].key, &key, sizeof(ParameterKey)) == 0)
+			return mapped[i].tables;
+
+	return NULL;
+
+}
+
+bool ParameterCache::makeKey(ParameterKey& key, FILE* dG, FILE* dH, double temperature, double sodium, double magnesium) {
+
+	FILE* files[2] = { dG, dH };
+
+	// zeroed first, so padding does not upset the byte comparisons.
+	memset(&key, 0, sizeof(ParameterKey));
+
+	for (int loop = 0; loop < 2; loop++) {
+
+		struct stat info;
+
+		if (files[loop] == NULL || fstat(fileno(files[loop]), &info) != 0)
+			return false;
+
+		key.files[loop][0] = (int64_t) info.st_dev;
+		key.files[loop][1] = (int64_t) info.st_ino;
+		key.files[loop][2] = (int64_t) info.st_size;
+		key.files[loop][3] = (int64_t) info.st_mtime;
+	}
+
+	key.temperature = temperature;
+	key.sodium = sodium;
+	key.magnesium = magnesium;
+
+	return true;
+
+}
+
+// $MULTISTRAND_CACHE/nupack-<hash>.bin, creating ~/.cache/multistrand if that is used.
+bool ParameterCache::makePath(char* path, int length, const ParameterKey& key) {
+
+	char directory[512];
+	const char* cache = getenv("MULTISTRAND_CACHE");
+
+	if (cache != NULL) {
+
+		if (cache[0] == '\0')
+			return false;
+		if (snprintf(directory, sizeof(directory), "%s", cache) >= (int) sizeof(directory))
+			return false;
+
+	} else {
+
+		const char* home = getenv("HOME");
+
+		if (home == NULL || home[0] == '\0')
+			return false;
+		if (snprintf(directory, sizeof(directory), "%s/.cache", home) >= (int) sizeof(directory))
+			return false;
+
+		mkdir(directory, 0755);
+		strcat(directory, "/multistrand");
+		mkdir(directory, 0755);
+	}
+
+	// FNV-1a over the key and the version
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	const unsigned char* bytes = (const unsigned char*) &key;
+
+	for (size_t i = 0; i < sizeof(ParameterKey); i++)
+		hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+	hash = (hash ^ PARAMETERCACHE_VERSION) * 0x100000001B3ULL;
+
+	return snprintf(path, length, "%s/nupack-%016llx.bin", directory, (unsigned long long) hash) < length;
+
+}
+
+const NupackParameters* ParameterCache::map(const char* path, const ParameterKey& key) {
+
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return NULL;
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size != PARAMETERCACHE_FILESIZE) {
+		close(fd);
+		return NULL;
+	}
+
+	void* memory = mmap(NULL, PARAMETERCACHE_FILESIZE, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (memory == MAP_FAILED)
+		return NULL;
+
+	ParameterFileHeader* header = (ParameterFileHeader*) memory;
+
+	if (memcmp(header->magic, PARAMETERCACHE_MAGIC, sizeof(PARAMETERCACHE_MAGIC)) != 0 || header->version != PARAMETERCACHE_VERSION
+			|| header->size != sizeof(NupackParameters) || memcmp(&header->key, &key, sizeof(ParameterKey)) != 0) {
+		munmap(memory, PARAMETERCACHE_FILESIZE);
+		return NULL;
+	}
+
+	return (const NupackParameters*) ((char*) memory + PARAMETERCACHE_OFFSET);
+
+}
+
+const NupackParameters* ParameterCache::find(const ParameterKey& key) {
+
+	std::lock_guard<std::mutex> lock(mappedLock);
+
+	const NupackParameters* tables = findMapped(key);
+
+	if (tables != NULL)
+		return tables;
+
+	char path[600];
+
+	if (!makePath(path, sizeof(path), key))
+		return NULL;
+
+	tables = map(path, key);
+
+	if (tables != NULL) {
+		MappedParameters entry = { key, tables };
+		mapped.push_back(entry);
+	}
+
+	return tables;
+
+}
+
+const NupackParameters* ParameterCache::store(const ParameterKey& key, const NupackParameters* tables) {
+
+	std::lock_guard<std::mutex> lock(mappedLock);
+
+	const NupackParameters* stored = findMapped(key);
+
+	if (stored != NULL)
+		return stored;
+
+	char path[600], temporary[640];
+
+	if (!makePath(path, sizeof(path), key))
+		return NULL;
+
+	// written under a private name and renamed into place, so that other
+	// processes never map a partial file.
+	snprintf(temporary, sizeof(temporary), "%s.%ld", path, (long) getpid());
+
+	FILE* fp = fopen(temporary, "wb");
+
+	if (fp == NULL)
+		return NULL;
+
+	ParameterFileHeader header;
+	char padding[PARAMETERCACHE_OFFSET - sizeof(ParameterFileHeader)];
+
+	memset(&header, 0, sizeof(ParameterFileHeader));
+	memset(padding, 0, sizeof(padding));
+	memcpy(header.magic, PARAMETERCACHE_MAGIC, sizeof(PARAMETERCACHE_MAGIC));
+	header.version = PARAMETERCACHE_VERSION;
+	header.size = sizeof(NupackParameters);
+	header.key = key;
+
+	bool written = fwrite(&header, sizeof(ParameterFileHeader), 1, fp) == 1;
+	written = written && (sizeof(padding) == 0 || fwrite(padding, sizeof(padding), 1, fp) == 1);
+	written = written && fwrite(tables, sizeof(NupackParameters), 1, fp) == 1;
+	written = (fclose(fp) == 0) && written;
+
+	if (!written || rename(temporary, path) != 0) {
+		unlink(temporary);
+		return NULL;
+	}
+
+	stored = map(path, key);
+
+	if (stored != NULL) {
+		MappedParameters entry = { key, stored };
+		mapped.push_back(entry);
+	}
+
+	return stored;
+
+}
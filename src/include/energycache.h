@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* EnergyCache class header. A bounded memo of loop energies, consulted by the energy model. */
+
+#ifndef __ENERGYCACHE_H__
+#define __ENERGYCACHE_H__
+
+#include <stdint.h>
+#include <atomic>
+
+class EnergyModel;
+
+const int ENERGYCACHE_SIZE = 4096; // entries, a power of two
+const int ENERGYCACHE_MAXSIDES = 6; // larger multi and open loops are not cached
+
+const int ENERGYCACHE_HAIRPIN = 1;
+const int ENERGYCACHE_INTERIOR = 2;
+const int ENERGYCACHE_MULTI = 3;
+const int ENERGYCACHE_OPEN = 4;
+
+// A loop is identified by its type and, for each side, where the side starts in
+// the strand sequences and its length. The strand sequences do not change while
+// they exist, so this determines the energy for a given model. The cache is
+// invalidated whenever a strand is deleted (~orderingList) or a model is, as the
+// memory may then be reused for another sequence.
+//
+// The table is direct mapped, one per thread, so lookups take no lock. The generation
+// that invalidates the entries is shared by all threads, as a strand or model may be
+// deleted by another thread than the ones that cached its loops (a worker's complexes
+// are deleted by the main thread, a system may be collected on any Python thread).
+class EnergyCache {
+public:
+	static bool lookup(EnergyModel* model, int type, int sides, int* lengths, char** starts, double* energy);
+	static void store(EnergyModel* model, int type, int sides, int* lengths, char** starts, double energy);
+	static void invalidate(void);
+
+	// counters for this thread
+	static long getHits(void);
+	static long getMisses(void);
+
+private:
+	struct Entry {
+		uint64_t hash;
+		uint64_t generation; // 0 for an empty entry
+		int type;
+		int sides;
+		int lengths[ENERGYCACHE_MAXSIDES];
+		char* starts[ENERGYCACHE_MAXSIDES];
+		EnergyModel* model;
+		double energy;
+	};
+
+	EnergyCache(void);
+	~EnergyCache(void);
+
+	static uint64_t hashKey(EnergyModel* model, int type, int sides, int* lengths, char** starts);
+	static bool matches(Entry& entry, uint64_t hash, uint64_t current, EnergyModel* model, int type, int sides, int* lengths, char** starts);
+
+	Entry* table;
+	long hits;
+	long misses;
+
+	static thread_local EnergyCache local;
+	static std::atomic<uint64_t> generation; // of the valid entries, from 1
+};
+
+#endif
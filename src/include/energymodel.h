@@ -13,6 +13,7 @@ help@multistrand.org
 #include <string>
 #include <moveutil.h>
 #include <sequtil.h>
+#include <parametercache.h>
 
 using std::string;
 
@@ -25,17 +26,13 @@ const int MFOLD = 1;
 
 const int pairs_vienna[5] = { 0, 4, 3, 2, 1 };
 const int pairs_mfold[5] = { 0, 4, 3, 2, 1 };
-extern int pairs[5];
 
 const int pairtypes_vienna[5][5] = { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 5 }, { 0, 0, 0, 1, 0 }, { 0, 0, 2, 0, 3 }, { 0, 6, 0, 4, 0 } };
 const int pairtypes_mfold[5][5] = { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 1 }, { 0, 0, 0, 2, 0 }, { 0, 0, 3, 0, 5 }, { 0, 4, 0, 6, 0 } };
 
-extern int pairtypes[5][5];
-
 const int basepair_sw_vienna[8] = { 0, 2, 1, 4, 3, 6, 5, 7 };
 const int basepair_sw_mfold[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
 const int basepair_sw_mfold_actual[8] = { 0, 4, 3, 2, 1, 6, 5, 7 }; // Why do this? Vienna's parameter file stores pairings in the opposite ordering. So for one of them, we need to swap basepairs to get the correct ordering, in the other one, we don't.
-extern int basepair_sw[8]; // = {0,0,0,0,0,0,0,0};
 
 int baseLookup(char base);
 
@@ -59,14 +56,18 @@ public:
 	EnergyModel(PyObject *options);
 
 	// Implemented methods
-	bool useArrhenius(void);
+	inline bool useArrhenius(void) {
+		return arrheniusEnabled;
+	}
 	double singleStrandedStacking(char* sequence, int length);
 	double initializationPenalty(int , int , int );
 	double arrheniusLoopEnergy(char* seq, int size);
 	double saltCorrection(int size);
 	void setArrheniusRate(double ratesArray[], EnergyOptions* options, double temperature, int left, int right);
 	void computeArrheniusRates(double temperature);
-	double applyPrefactors(double tempRate, MoveType left, MoveType right);
+	inline double applyPrefactors(double tempRate, MoveType left, MoveType right) {
+		return arrheniusEnabled ? tempRate * arrheniusRates[left * MOVETYPE_SIZE + right] : tempRate;
+	}
 	MoveType getPrefactorsMulti(int, int, int[]);
 	MoveType prefactorOpen(int, int, int[]);
 	MoveType prefactorInternal(int, int);
@@ -81,6 +82,8 @@ public:
 	virtual ~EnergyModel(void);
 
 	virtual double returnRate(double start_energy, double end_energy, int enth_entr_toggle) = 0;
+	// returnRate(start_energy, end_energies[i], 0) for count moves at once, see MoveBatch.
+	virtual void returnRates(double start_energy, double *end_energies, double *rates, int count) = 0;
 	virtual double getJoinRate_NoVolumeTerm(void) = 0;
 	virtual double getJoinRate(void) = 0;
 	virtual double getVolumeEnergy(void) =0;
@@ -105,10 +108,24 @@ public:
 	virtual double MultiloopEnergy(int size, int *sidelen, char **sequences) = 0;
 	virtual double OpenloopEnergy(int size, int *sidelen, char **sequences) = 0;
 
+	virtual double CreationEnergyBound(bool open, int size, int *sidelen, char **sequences, int first, int last, int unpaired) = 0;
+	// A lower bound on the energy change of any creation move in an open loop (size as in
+	// OpenloopEnergy) or multiloop (size as in MultiloopEnergy) that pairs a base of side first
+	// with a base of side last (first <= last, or the two sides around the end of a multiloop),
+	// leaving unpaired bases between them on those two sides. For first == last, this is the
+	// size of the resulting hairpin. Used to group creation moves, see LazyMoves.
+
 	SimOptions* simOptions;
 
+	// Base pairing tables, filled in by processOptions. These belong to the model
+	// (rather than being globals) so that models with different options can coexist.
+	int pairs[5];
+	int pairtypes[5][5];
+	int basepair_sw[8];
+
 protected:
 	long dangles;
+	bool arrheniusEnabled; // usingArrhenius() of the energy options, fixed when the model is made
 	double arrheniusRates[MOVETYPE_SIZE * MOVETYPE_SIZE];
 
 };
@@ -125,6 +142,7 @@ public:
 
 	double returnRate(double start_energy, double end_energy, int enth_entr_toggle);
 	double returnRate(energyS &start_energy, energyS &end_energy);
+	void returnRates(double start_energy, double *end_energies, double *rates, int count);
 	double getJoinRate(void);
 	double getJoinRate_NoVolumeTerm(void);
 
@@ -138,85 +156,49 @@ public:
 	double MultiloopEnergy(int size, int *sidelen, char **sequences);
 	double OpenloopEnergy(int size, int *sidelen, char **sequences);
 
+	double CreationEnergyBound(bool open, int size, int *sidelen, char **sequences, int first, int last, int unpaired);
 
 private:
 
-	// All energy units are integers, in units of .01 kcal/mol, as used by ViennaRNA
-
-	// Stacking Info
-	double stack_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK]; // Delta G's for stacks, matrix form, at 37 degrees C.
-	int stack_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK]; // Delta H's for stacks, matrix form, for use comparing to dG at 37 deg C.
-
-	// Hairpin Info
-	double hairpin_37_dG[31];
-	int hairpin_37_dH[31];
-	double hairpin_mismatch_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
-	int hairpin_mismatch_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
-
-	double hairpin_triloop_37_dG[1024];
-	int hairpin_triloop_37_dH[1024];
-	// This needs about 1024 doubles to store the entire matrix.
-	// lookups on this are then 4 shifts, 5adds, 5 dec 1s, but better than a strstr.
-
-	double hairpin_tetraloop_37_dG[4096];
-	int hairpin_tetraloop_37_dH[4096];
-
-	// Bulge Info
-	double bulge_37_dG[31];
-	int bulge_37_dH[31];
-
-	// Internal Loop Info
-	double internal_37_dG[31];
-	double internal_mismatch_37_dG[NUM_BASES][NUM_BASES][NUM_BASEPAIRS_NUPACK];
-	int internal_37_dH[31];
-	int internal_mismatch_37_dH[NUM_BASES][NUM_BASES][NUM_BASEPAIRS_NUPACK];
-
-	double maximum_NINIO;
-	int maximum_NINIO_dH;
-	double ninio_correction_37[5];
-	int ninio_correction_37_dH[5];
-
-	/* special internal loop lookup tables */
-	double internal_1_1_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
-	int internal_1_1_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
-
-	double internal_2_1_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
-	int internal_2_1_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
-
-	double internal_2_2_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES][NUM_BASES][NUM_BASES];
-	int internal_2_2_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES][NUM_BASES][NUM_BASES];
-
-	// Multiloop Info
-	double multiloop_base;
-	double multiloop_closing;
-	double multiloop_internal;
-
-	int multiloop_base_dH;
-	int multiloop_closing_dH;
-	int multiloop_internal_dH;
-
-	// should this really not be tied to one of the others?
-	// it actually appears to be the scaling term for internal, hairpin and (the outdated) multiloop mismatches.
-
-	// Dangle Info for multiloops and open loops
-	double dangle_3_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES];
-	double dangle_5_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES];
-	int dangle_3_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES];
-	int dangle_5_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES];
-
-	// Terminal AU penalty for multiloops and open loops (included in mismatch penalties elsewhere
-	// Appears to be pure dH.
-	double terminal_AU;
-	int terminal_AU_dH;
+	// the uncached loop energies
+	double computeHairpinEnergy(char *seq, int size);
+	double computeInteriorEnergy(char *seq1, char *seq2, int size1, int size2);
+	template<long dangleMode, bool arrhenius> double computeMultiloopEnergy(int size, int *sidelen, char **sequences);
+	template<long dangleMode, bool arrhenius> double computeOpenloopEnergy(int size, int *sidelen, char **sequences);
+	double multiloopLengthEnergy(int totallength);
+
+	// unimolecular rates for dE = end - start energy
+	template<long rateMethod> double unimolecularRate(double dE);
+	template<long rateMethod> void unimolecularRates(double start_energy, double *end_energies, double *rates, int count);
+
+	// The kernels above are specialized on the dangles, Arrhenius and rate method
+	// options; setupKernels picks the ones for this model when it is made, so that
+	// the energy and rate computations do not test the options.
+	double (NupackEnergyModel::*multiloopKernel)(int size, int *sidelen, char **sequences);
+	double (NupackEnergyModel::*openloopKernel)(int size, int *sidelen, char **sequences);
+	double (NupackEnergyModel::*rateKernel)(double dE);
+	void (NupackEnergyModel::*ratesKernel)(double start_energy, double *end_energies, double *rates, int count);
+
+	void setupKernels(void);
+	template<long dangleMode> void setupLoopKernels(void);
+
+	// parts of CreationEnergyBound
+	void setupBounds(void);
+	double hairpinBound(int size);
+	double interiorBound(int size);
+	double sideBound(int kind, bool exempt);
+	double sideEnergy(bool open, int size, int *sidelen, char **sequences, int side);
+	double pairPenalty(int base1, int base2);
+
+	// the tables read from the parameter files, mapped from the ParameterCache or
+	// else pointing at parsed, which is owned by the model.
+	const NupackParameters* params;
+	NupackParameters* parsed;
 
 	// Logarithmic loop penalty. Doesn't seem to change for DNA/RNA?
 	double log_loop_penalty_37;
 	double log_loop_penalty;
 
-	// biomolecular penalty
-	double bimolecular_penalty;
-	int bimolecular_penalty_dH;
-
 	// Kinetic rate toggle. 0 = kawasaki, 1 = metropolis, 2 = entropy/enthalpy, defaults to 2.
 	long kinetic_rate_method;
 	double kBoltzmann;
@@ -234,7 +216,23 @@ private:
 	int internal;
 	long logml;
 
+	// the smallest entry of each table, for CreationEnergyBound (see setupBounds)
+	double bound_stack;
+	double bound_hairpin_mismatch;
+	double bound_triloop;
+	double bound_tetraloop;
+	double bound_internal_mismatch;
+	double bound_internal_1_1;
+	double bound_internal_2_1;
+	double bound_internal_2_2;
+	double bound_ninio;
+	double bound_dangle_3;
+	double bound_dangle_5;
+	double bound_terminal;
+	double bound_init;
+
 	// data loading functions:
+	void readParameters(FILE *fp, FILE *fp2, double temperature);
 	void setupRates();
 
 	void internal_set_stack_energies(FILE *fp, char *buffer);
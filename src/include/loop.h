@@ -13,11 +13,15 @@ help@multistrand.org
 #include "energymodel.h"
 #include "move.h"
 #include "moveutil.h"
+#include "loopindex.h"
 
 using std::vector;
 
 class EnergyOptions;
 
+// sides (or pairs of sides) with fewer possible pairs always get a Move for each.
+const long LAZY_MIN_PAIRS = 1024;
+
 struct RateArr {
 
 	double rate;
@@ -44,9 +48,18 @@ public:
 	char getType(void);
 	Loop(void);
 	virtual ~Loop(void);
+
+	// Loops are created and destroyed with nearly every move (zipping a helix
+	// makes and breaks a loop pair each step), so they come from per-thread free
+	// lists, as do their side arrays (poolArray). See pool.h.
+	static void* operator new(size_t size);
+	static void operator delete(void* memory, size_t size);
 	virtual void calculateEnergy(void) = 0;
 	virtual void generateMoves(void) = 0;
 	virtual void generateDeleteMoves(void) = 0;
+	// For a neighbour of a changed loop: its creation moves only depend on its own
+	// bases, so only the deletion moves (which involve the neighbour) are redone.
+	void regenerateDeleteMoves(void);
 	virtual Move *getChoice(double *randomchoice, Loop *from) = 0;
 	virtual double doChoice(Move *move, Loop **returnLoop) = 0;
 	virtual char *getLocation(Move *move, int index) =0;
@@ -74,6 +87,8 @@ public:
     static std::tuple<int,int> findExternalAdjacent(Loop*, Loop*);
     static std::pair<Loop*, Loop*> orderMyLoops(Loop*, Loop*, char);
 
+	Move *getLocalChoice(double *randomchoice); // choose among this loop's own moves only, NULL for a rejected grouped move
+
 	string toString(void);
 	string toStringShort(void);
 	void printAllMoves(Loop*);
@@ -82,8 +97,31 @@ public:
 	// FD: moving private to public
 	int numAdjacent;
 
+	// Sum of all changes to totalRate (including destroyed loops) since the
+	// last reset. StrandComplex uses this to keep its total flux up to date.
+	// Per thread, as trajectories may run concurrently (see SimulationSystem).
+	static thread_local double fluxChange;
+
+	friend class LoopIndex;
+
 protected:
-	static EnergyModel *energyModel;
+	void setTotalRate(double rate);
+	double getLocalRate(void); // the moves, and the bounds of the grouped moves
+
+	// Grouped creation moves (see LazyMoves), for the sides of open and multi loops with at
+	// least LAZY_MIN_PAIRS possible pairs.
+	bool groupCreationMoves(long pairs);
+	void addCreationGroups(bool open, int *sidelen, char **seqs, int first, int last);
+	void expandGroup(int group); // makes the moves of a group whose bound did not hold exact
+	// adds the creation move pairing base pos1 of side side1 with base pos2 of side side2 to
+	// batch, or returns false if those do not pair. The scratch arrays need numAdjacent + 2
+	// entries, or may be NULL.
+	virtual bool addCreationMove(int side1, int pos1, int side2, int pos2, int *sideLengths, char **sequences, MoveBatch &batch);
+
+	// The energy model of the system running in this thread. Each SimulationSystem
+	// installs its own for the duration of a call, so that systems with different
+	// options can coexist (and run concurrently) in one process.
+	static thread_local EnergyModel *energyModel;
 
 	Loop** adjacentLoops;
 	int curAdjacent;
@@ -93,6 +131,11 @@ protected:
 	MoveContainer *moves;
 	char identity;
 	int add_index;
+
+	LoopIndex *loopIndex = NULL; // the index of the complex this loop belongs to, if any
+	int indexSlot = -1;
+
+	LazyMoves *lazyMoves = NULL;
 };
 
 class StackLoop: public Loop {
@@ -204,6 +247,8 @@ public:
 	string typeInternalsToString(void);
 
 private:
+	bool addCreationMove(int side1, int pos1, int side2, int pos2, int *sideLengths, char **sequences, MoveBatch &batch);
+
 	int *sidelen;
 	char **seqs;
 };
@@ -254,6 +299,7 @@ public:
 	OpenInfo openInfo;
 	bool initial = false; // FD: if true, then the loop is the initial open loop and seqs[0][0] is out of bounds.
 private:
+	bool addCreationMove(int side1, int pos1, int side2, int pos2, int *sideLengths, char **sequences, MoveBatch &batch);
 
 	int *sidelen;
 	char **seqs;
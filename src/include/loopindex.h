@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* LoopIndex class header. A flat table of the loops in a complex, with a Fenwick tree over their rates. */
+
+#ifndef __LOOPINDEX_H__
+#define __LOOPINDEX_H__
+
+#include <vector>
+
+using std::vector;
+
+class Loop;
+
+// Every loop in a complex holds a slot in the complex's LoopIndex, and reports
+// changes to its totalRate (Loop::setTotalRate) and its destruction to it. This
+// lets StrandComplex::getChoice find the loop that owns a move in O(log #loops),
+// instead of recursing over the loop graph.
+class LoopIndex {
+public:
+	LoopIndex(void);
+	~LoopIndex(void);
+
+	void build(Loop *start); // adds all loops reachable from start, taking them from their old index if needed
+	void absorb(LoopIndex *other); // moves all loops from other into this index
+	void insert(Loop *loop);
+	void remove(Loop *loop);
+	void update(Loop *loop);
+	void rebuildTree(void); // recomputes the tree from the stored rates, to clear floating point drift
+
+	Loop *getChoice(double *rnd);
+	double getTotal(void);
+	int getCount(void);
+
+	// New loops that report a rate while this is set are inserted here.
+	// StrandComplex sets it for the duration of a move, in the thread doing the move.
+	static thread_local LoopIndex *active;
+
+private:
+	void addDelta(int slot, double delta);
+	void grow(void);
+
+	vector<Loop*> loops;
+	vector<double> rates;
+	vector<double> tree; // 1-based Fenwick array over rates
+	vector<int> freeSlots;
+	int topbit;
+	int count;
+};
+
+#endif
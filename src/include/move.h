@@ -25,8 +25,14 @@ const int MOVE_1 = 8;
 const int MOVE_2 = 16;
 const int MOVE_3 = 32;
 
+// returned by SComplexList::doBasicChoice when a grouped move was rejected (see LazyMoves).
+const int MOVE_REJECTED = -1;
+
 #include <string>
+#include <vector>
+#include <stdint.h>
 #include <moveutil.h>
+#include "pool.h"
 using std::string;
 
 class Loop;
@@ -56,6 +62,12 @@ public:
 	Move(int mtype, RateEnv mrate, Loop *affected_1, Loop *affected_2, int index1, int index2RateEnv);
 	Move(int mtype, RateEnv mrate, Loop *affected_1, Loop *affected_2, int index1RateEnv);
 	~Move(void);
+
+	// Moves come and go by the thousand with every regenerated loop, so they
+	// are allocated from a per-thread free list instead of the heap.
+	static void* operator new(size_t size);
+	static void operator delete(void* memory, size_t size);
+
 	double getRate(void);
 	int getType(void);
 	int getArrType(void);
@@ -85,33 +97,64 @@ public:
 	MoveContainer(void);
 	virtual ~MoveContainer(void);
 	virtual void addMove(Move *newmove) = 0;
+	virtual void clear(int initial_size) = 0; // deletes all moves, but keeps the arrays for reuse
 	double getRate(void);
-	virtual void resetDeleteMoves(void) = 0;
+	virtual void resetDeleteMoves(void) = 0; // removes the deletion moves, keeping the creation moves
 	virtual Move *getChoice(double *rnd) = 0;
 	virtual Move *getMove(Move *iterator) = 0;
 
 	virtual void printAllMoves(bool) = 0;
 
+	// factory for the loops, returns a MoveTree or a MoveList depending on useMoveTree.
+	static MoveContainer* newContainer(int initial_size);
+	// for regenerating loops: clears and returns the old container, or makes a new one.
+	static MoveContainer* renewContainer(MoveContainer* old, int initial_size);
+	// per thread, installed with the energy model by the running SimulationSystem.
+	static thread_local bool useMoveTree;
+
 protected:
 	double totalrate;
 
 };
 
-//// not using this storage method yet... refer to the list...
-//class MoveTree: public Move {
-//public:
-//	~MoveTree(void);
-//
-//private:
-//	Move *left, *right; // also an uplink?
-//	double totalrate;
-//};
+// Creation moves are held in a Fenwick tree over their rates, so that getChoice
+// is O(log n) instead of the linear scan in MoveList. The (at most a handful of)
+// deletion moves are kept in a plain array, and scanned after the creation moves,
+// so that the selection order matches MoveList.
+class MoveTree: public MoveContainer {
+public:
+	MoveTree(int initial_size);
+	~MoveTree(void);
+	void addMove(Move *newmove);
+	void clear(int initial_size);
+	Move *getChoice(double *rnd);
+	Move *getMove(Move *iterator);
+	void resetDeleteMoves(void);
+
+	void printAllMoves(bool);
+
+private:
+	void growMoves(void);
+
+	Move **moves;
+	double *tree; // 1-based Fenwick array, tree[i] covers moves[i - (i & -i)] to moves[i - 1]
+	double moves_rate;
+	int moves_size;
+	int moves_index;
+	int moves_topbit;
+
+	Move **del_moves;
+	int del_moves_size;
+	int del_moves_index;
+	int int_index;
+};
 
 class MoveList: public MoveContainer {
 public:
 	MoveList(int initial_size);
 	~MoveList(void);
 	void addMove(Move *newmove);
+	void clear(int initial_size);
 	Move *getChoice(double *rnd);
 	Move *getMove(Move *iterator);
 	void resetDeleteMoves(void);
@@ -122,6 +165,7 @@ public:
 private:
 	Move **moves;
 	Move **del_moves;
+	double moves_rate; // the creation moves only, see resetDeleteMoves
 	int moves_size;
 	int moves_index;
 	int del_moves_size;
@@ -129,4 +173,91 @@ private:
 	int int_index;
 };
 
+// The creation moves a loop generates, held as the energies they lead to until the loop
+// has them all. flush then gets all their rates from the energy model in one call, which
+// keeps the exp calls in one tight loop instead of behind a virtual call per move, and
+// makes the Moves in the order they were added.
+//
+// Move generation does not nest, so each thread has one batch (local), emptied by every flush.
+class MoveBatch {
+public:
+	MoveBatch(void);
+	~MoveBatch(void);
+	// a move of the given type and indices (unused ones -1, as in Move) to a state of energy.
+	void add(double energy, MoveType left, MoveType right, int type, int index1, int index2, int index3 = -1, int index4 = -1);
+	int getCount(void);
+	// makes and adds the moves of loop, which has start_energy, to moves; empties the batch.
+	void flush(EnergyModel *model, double start_energy, Loop *loop, MoveContainer *moves);
+	// the only move in the batch, made for loop; empties the batch.
+	Move *take(EnergyModel *model, double start_energy, Loop *loop);
+
+	static thread_local MoveBatch local;
+
+private:
+	struct Pending {
+		MoveType left, right;
+		int type;
+		int index[4];
+	};
+
+	void grow(void);
+	void computeRates(EnergyModel *model, double start_energy);
+	Move *makeMove(EnergyModel *model, Loop *loop, int item);
+
+	Pending *pending;
+	double *energies;
+	double *rates;
+	int size;
+	int count;
+};
+
+// The creation moves of a long side, or of a pair of sides, of an open or multi loop
+// number in the square of their lengths. Instead of a Move each, they are kept here in
+// groups: all moves between the same two sides that leave the same number of bases unpaired
+// between them (for one side, all hairpins of a size). Only the positions that can pair are
+// members, as a bitset along the group. Each group holds an upper bound on the rate of any
+// of its moves, from EnergyModel::CreationEnergyBound.
+//
+// A group is chosen by its bound times its members, then a member uniformly. The loop makes
+// that move, and keeps it with probability rate / bound; otherwise nothing happens. The state
+// then stays the same for another step, and the time spent in it is drawn against the bounded
+// total, as in the thinning of a Poisson process. This keeps the simulation exact, as long as
+// the bound holds. A move above its bound is counted (boundMisses) and its group is replaced
+// by the exact moves, see Loop::getLocalChoice.
+class LazyMoves {
+public:
+	LazyMoves(void);
+	~LazyMoves(void);
+	void clear(void);
+	// the moves pairing (side1, pos1 + k) with (side2, pos2 + k), for the bits k < count set in members.
+	void addGroup(int side1, int pos1, int side2, int pos2, int count, uint64_t *members, double bound);
+	double getRate(void);
+	// picks a move, and leaves *rnd uniform in [0, bound) for the acceptance test.
+	void getChoice(double *rnd, int *side1, int *pos1, int *side2, int *pos2, double *bound, int *group);
+	// the moves of a group, as pairs of positions, and its removal.
+	void getMembers(int group, int *side1, int *side2, std::vector<int> &pos1, std::vector<int> &pos2);
+	void removeGroup(int group);
+	// the move made for the last choice, which this keeps until the next one or its deletion.
+	void keepChoice(Move *move);
+
+	// per thread like MoveContainer::useMoveTree, see SimOptions::usingLazyMoves.
+	static thread_local bool useLazyMoves;
+	static thread_local long boundMisses; // moves found above the bound of their group
+
+private:
+	struct MoveGroup {
+		int side1, pos1, side2, pos2, count;
+		int members; // bits set
+		int offset; // of the first word in bits
+		double bound; // per move
+	};
+
+	MoveGroup *groups;
+	int groups_size;
+	int groups_index;
+	std::vector<uint64_t> bits;
+	double totalrate;
+	Move *chosen;
+};
+
 #endif
@@ -28,6 +28,9 @@ enum QuartContext {
 	endC, strandC, stackC, HALFCONTEXT_SIZE
 };
 
+// the number of distinct (left, right) half contexts
+const int HALFCONTEXT_TOTAL = HALFCONTEXT_SIZE * HALFCONTEXT_SIZE;
+
 namespace moveutil {
 
 MoveType combineBi(QuartContext&, QuartContext&);
@@ -55,6 +58,10 @@ struct HalfContext {
 	bool operator==(const HalfContext& other) const;
 	bool operator<(const HalfContext&) const;
 
+	// flat index into OpenInfo::tally, ordered the same as operator<
+	int getIndex(void) const;
+	static HalfContext fromIndex(int);
+
 	QuartContext left = endC;
 	QuartContext right = endC;
 
@@ -90,9 +97,13 @@ public:
 	void decrement(HalfContext, BaseCount&);
 	void decrement(OpenInfo&);
 
-	double crossRate(OpenInfo&, EnergyModel&);
+	// rates holds the join rate for each pair of half contexts, row-major by getIndex
+	double crossRate(OpenInfo&, const double* rates);
+	void crossCount(OpenInfo&, int* output);
 
-	map<HalfContext, BaseCount> tally;
+	// one slot per half context, indexed by HalfContext::getIndex.
+	// absent half contexts simply have a zero count.
+	BaseCount tally[HALFCONTEXT_TOTAL];
 
 	int numExposedInternal = 0;
 	int numExposed = 0;
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* PairMask class header. Bitsets of the bases of a strand that can pair with each base, for move generation. */
+
+#ifndef __PAIRMASK_H__
+#define __PAIRMASK_H__
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <vector>
+#include "sequtil.h"
+
+class EnergyModel;
+
+// For each base b, bit k of a PairMask is set when base k of the strand can pair with b
+// (EnergyModel::pairtypes, so this follows the GT setting of the model). The creation
+// move loops step through the set bits, instead of looking up every candidate pair; most
+// candidates fail that lookup in AT-rich or low complexity sequences.
+//
+// Each strand (orderingList) holds the mask of its sequence, built the first time one of
+// its loops generates moves. The loops only see their sides as pointers into the strand
+// sequences, so they look up the strand of each side by address and use a Side, which is
+// the strand mask shifted to the indices of the side. The strands are registered with the
+// thread that made them, which is the thread that runs their trajectory.
+class PairMask {
+public:
+	PairMask(void);
+	~PairMask(void);
+
+	void build(EnergyModel *model, char *sequence, int length); // bases 1 .. length, as the loops index their sides
+
+	class Side {
+	public:
+		// the first base in [from, to] of the side that can pair with base, or to + 1 if there is none.
+		inline int next(char base, int from, int to) {
+
+			if (from > to)
+				return to + 1;
+
+			from += offset;
+			to += offset;
+
+			uint64_t *pairs = mask->pairs + base * mask->words;
+			int word = from >> 6;
+			uint64_t bits = pairs[word] & (~0ULL << (from & 63));
+
+			while (bits == 0) {
+				word++;
+				if ((word << 6) > to)
+					return to + 1 - offset;
+				bits = pairs[word];
+			}
+
+			int pos = (word << 6) + __builtin_ctzll(bits);
+			return ((pos <= to) ? pos : to + 1) - offset;
+
+		}
+
+	private:
+		friend class PairMask;
+		PairMask *mask;
+		int offset;
+	};
+
+	// the side of bases 1 .. length after sequence, for model.
+	static Side side(EnergyModel *model, char *sequence, int length);
+
+	// the same for count sides at once; the array is reused by the next call on this thread.
+	static Side *sides(EnergyModel *model, char **sequences, int *lengths, int count);
+
+	// called by orderingList, for the code sequence of size bases that mask covers.
+	static void addStrand(char *sequence, int size, PairMask *mask);
+	static void removeStrand(char *sequence);
+
+private:
+	static Side find(EnergyModel *model, char *sequence, int length, int index);
+
+	uint64_t *pairs; // NUM_BASES masks of words each
+	int words;
+	EnergyModel *built; // the model the mask was built for, NULL until then
+
+	struct Strand {
+		int size;
+		PairMask *mask;
+	};
+
+	static thread_local std::map<char*, Strand> strands; // by the start of the code sequence
+	static thread_local std::vector<Side> sideList;
+	static thread_local std::vector<std::unique_ptr<PairMask>> spares; // built per side, for sides outside the strands of this thread
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* ParameterCache class header. Binary copies of the processed NUPACK parameter tables, shared between processes. */
+
+#ifndef __PARAMETERCACHE_H__
+#define __PARAMETERCACHE_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sequtil.h>
+
+// bump when NupackParameters, the parsing or the temperature scaling changes;
+// older cache files are then ignored and rewritten.
+const uint32_t PARAMETERCACHE_VERSION = 1;
+
+// The tables NupackEnergyModel reads from the parameter files, after scaling to
+// the simulation temperature. Plain data only: it is written to and mapped from
+// the cache file as is.
+struct NupackParameters {
+
+	// All energy units are integers, in units of .01 kcal/mol, as used by ViennaRNA
+
+	// Stacking Info
+	double stack_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK]; // Delta G's for stacks, matrix form, at 37 degrees C.
+	int stack_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK]; // Delta H's for stacks, matrix form, for use comparing to dG at 37 deg C.
+
+	// Hairpin Info
+	double hairpin_37_dG[31];
+	int hairpin_37_dH[31];
+	double hairpin_mismatch_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
+	int hairpin_mismatch_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
+
+	double hairpin_triloop_37_dG[1024];
+	int hairpin_triloop_37_dH[1024];
+	// This needs about 1024 doubles to store the entire matrix.
+	// lookups on this are then 4 shifts, 5adds, 5 dec 1s, but better than a strstr.
+
+	double hairpin_tetraloop_37_dG[4096];
+	int hairpin_tetraloop_37_dH[4096];
+
+	// Bulge Info
+	double bulge_37_dG[31];
+	int bulge_37_dH[31];
+
+	// Internal Loop Info
+	double internal_37_dG[31];
+	double internal_mismatch_37_dG[NUM_BASES][NUM_BASES][NUM_BASEPAIRS_NUPACK];
+	int internal_37_dH[31];
+	int internal_mismatch_37_dH[NUM_BASES][NUM_BASES][NUM_BASEPAIRS_NUPACK];
+
+	double maximum_NINIO;
+	int maximum_NINIO_dH;
+	double ninio_correction_37[5];
+	int ninio_correction_37_dH[5];
+
+	/* special internal loop lookup tables */
+	double internal_1_1_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
+	int internal_1_1_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
+
+	double internal_2_1_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
+	int internal_2_1_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES];
+
+	double internal_2_2_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES][NUM_BASES][NUM_BASES];
+	int internal_2_2_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASEPAIRS_NUPACK][NUM_BASES][NUM_BASES][NUM_BASES][NUM_BASES];
+
+	// Multiloop Info
+	double multiloop_base;
+	double multiloop_closing;
+	double multiloop_internal;
+
+	int multiloop_base_dH;
+	int multiloop_closing_dH;
+	int multiloop_internal_dH;
+
+	// Dangle Info for multiloops and open loops
+	double dangle_3_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES];
+	double dangle_5_37_dG[NUM_BASEPAIRS_NUPACK][NUM_BASES];
+	int dangle_3_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES];
+	int dangle_5_37_dH[NUM_BASEPAIRS_NUPACK][NUM_BASES];
+
+	// Terminal AU penalty for multiloops and open loops (included in mismatch penalties elsewhere
+	// Appears to be pure dH.
+	double terminal_AU;
+	int terminal_AU_dH;
+
+	// biomolecular penalty
+	double bimolecular_penalty;
+	int bimolecular_penalty_dH;
+};
+
+// What the processed tables depend on: the two parameter files, identified by
+// device, inode, size and modification time, and the conditions they are scaled to.
+struct ParameterKey {
+	int64_t files[2][4];
+	double temperature;
+	double sodium;
+	double magnesium;
+};
+
+// Processed tables are kept in files named by a hash of their key, in
+// $MULTISTRAND_CACHE or else ~/.cache/multistrand. A file is mapped read-only
+// the first time its key is asked for in a process, and the mapping is kept
+// for the life of the process; every model with the same key, in any thread,
+// reads the same pages, and so do other processes that map the file.
+//
+// Failures are silent: without a usable cache, models parse the parameter files.
+class ParameterCache {
+public:
+	// fills in a key for the open dG and dH files, false if they cannot be identified.
+	static bool makeKey(ParameterKey& key, FILE* dG, FILE* dH, double temperature, double sodium, double magnesium);
+
+	// the mapped tables for this key, or NULL when there is no valid cache file.
+	static const NupackParameters* find(const ParameterKey& key);
+
+	// writes the tables to the cache file for this key and returns the mapped copy,
+	// or NULL when the file cannot be written.
+	static const NupackParameters* store(const ParameterKey& key, const NupackParameters* tables);
+
+private:
+	static const NupackParameters* map(const char* path, const ParameterKey& key);
+	static bool makePath(char* path, int length, const ParameterKey& key);
+};
+
+#endif
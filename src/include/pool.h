@@ -0,0 +1,178 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* FreeListPool class header, and size-classed allocation on top of it, for the objects and arrays the simulation churns through. */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+#include <new>
+#include <mutex>
+
+// Blocks of BlockSize bytes, carved from slabs and recycled through a free list.
+// Each thread has its own list, so allocation takes no lock. A block may be
+// released by another thread than the one that allocated it (e.g. a worker's
+// complexes are deleted by the main thread); it then joins the list of the
+// releasing thread. Slabs are never returned to the system: when a thread exits,
+// its free blocks are handed to a shared list, from which the next thread to
+// run dry takes them over.
+//
+// Use through poolAllocate / poolArray below.
+template<size_t BlockSize>
+class FreeListPool {
+public:
+	static inline void* allocate(void) {
+
+		Block* block = local.head;
+
+		if (block == NULL)
+			block = local.refill();
+
+		local.head = block->next;
+		return block;
+
+	}
+
+	static inline void release(void* memory) {
+
+		Block* block = (Block*) memory;
+		block->next = local.head;
+		local.head = block;
+
+	}
+
+private:
+	struct Block {
+		Block* next;
+	};
+
+	// blocks hold a pointer while free, and are aligned for any object.
+	static const size_t ALIGN = alignof(max_align_t);
+	static const size_t SIZE = ((BlockSize > sizeof(Block) ? BlockSize : sizeof(Block)) + ALIGN - 1) / ALIGN * ALIGN;
+	static const int SLAB_BLOCKS = 256;
+
+	FreeListPool(void) {
+		head = NULL;
+	}
+
+	~FreeListPool(void) {
+
+		if (head == NULL)
+			return;
+
+		Block* tail = head;
+		while (tail->next != NULL)
+			tail = tail->next;
+
+		std::lock_guard<std::mutex> lock(sharedLock);
+		tail->next = shared;
+		shared = head;
+		head = NULL;
+
+	}
+
+	Block* refill(void) {
+
+		{
+			std::lock_guard<std::mutex> lock(sharedLock);
+			if (shared != NULL) {
+				head = shared;
+				shared = NULL;
+				return head;
+			}
+		}
+
+		char* slab = (char*) ::operator new(SIZE * SLAB_BLOCKS);
+
+		for (int i = 0; i < SLAB_BLOCKS; i++) {
+			Block* block = (Block*) (slab + i * SIZE);
+			block->next = (i + 1 < SLAB_BLOCKS) ? (Block*) (slab + (i + 1) * SIZE) : NULL;
+		}
+
+		head = (Block*) slab;
+		return head;
+
+	}
+
+	Block* head;
+
+	static thread_local FreeListPool local;
+	static std::mutex sharedLock;
+	static Block* shared;
+};
+
+template<size_t BlockSize>
+thread_local FreeListPool<BlockSize> FreeListPool<BlockSize>::local;
+
+template<size_t BlockSize>
+std::mutex FreeListPool<BlockSize>::sharedLock;
+
+template<size_t BlockSize>
+typename FreeListPool<BlockSize>::Block* FreeListPool<BlockSize>::shared = NULL;
+
+// Objects whose size is known when they are released (class-specific operator
+// new / sized operator delete, see Move and Loop) go to the smallest size class
+// that fits; larger ones to the heap.
+inline void* poolAllocate(size_t size) {
+
+	if (size <= 64)
+		return FreeListPool<64>::allocate();
+	if (size <= 128)
+		return FreeListPool<128>::allocate();
+	if (size <= 256)
+		return FreeListPool<256>::allocate();
+	if (size <= 512)
+		return FreeListPool<512>::allocate();
+	return ::operator new(size);
+
+}
+
+inline void poolRelease(void* memory, size_t size) {
+
+	if (memory == NULL)
+		return;
+
+	if (size <= 64)
+		FreeListPool<64>::release(memory);
+	else if (size <= 128)
+		FreeListPool<128>::release(memory);
+	else if (size <= 256)
+		FreeListPool<256>::release(memory);
+	else if (size <= 512)
+		FreeListPool<512>::release(memory);
+	else
+		::operator delete(memory);
+
+}
+
+// Arrays of plain data (the sides and adjacent loops of a loop) are not typed at
+// release, so their size is kept in a header in front of them.
+const size_t POOL_ARRAY_HEADER = alignof(max_align_t);
+
+template<class T>
+inline T* poolArray(int count) {
+
+	size_t size = POOL_ARRAY_HEADER + (count > 0 ? count : 0) * sizeof(T);
+	char* memory = (char*) poolAllocate(size);
+
+	*((size_t*) memory) = size;
+	return (T*) (memory + POOL_ARRAY_HEADER);
+
+}
+
+// releases an array from poolArray; like delete[], accepts NULL.
+inline void releaseArray(void* array) {
+
+	if (array == NULL)
+		return;
+
+	char* memory = (char*) array - POOL_ARRAY_HEADER;
+	poolRelease(memory, *((size_t*) memory));
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* RandomStream class header. Counter-based random numbers for the simulation loops. */
+
+#ifndef __RANDOMSTREAM_H__
+#define __RANDOMSTREAM_H__
+
+#include <stdint.h>
+
+const int RANDOMSTREAM_BATCH = 64; // uniforms generated per refill
+
+// A stream of uniform doubles from the Philox4x32-10 generator (Salmon et al., SC 2011).
+// The n-th number of a stream is a pure function of (seed, n), so streams need no
+// shared state: trajectory k of a run uses the stream of trajectorySeed(initial seed, k),
+// no matter which thread runs it or what ran before it.
+//
+// To use a different generator, replace block(); it maps a 128-bit counter and a
+// 64-bit key to 128 random bits.
+class RandomStream {
+public:
+	RandomStream(void);
+
+	void seed(long seed); // restarts the stream for this seed
+
+	// uniform in [0, 1)
+	inline double uniform(void) {
+
+		if (position == RANDOMSTREAM_BATCH)
+			refill();
+		return buffer[position++];
+
+	}
+
+	// The seed of trajectory index of a run with the given initial seed. Trajectory 0
+	// uses the initial seed itself, so any trajectory can be replayed on its own by
+	// passing its reported seed as the initial seed.
+	static long trajectorySeed(long initialSeed, long index);
+
+private:
+	static void block(const uint32_t counter[4], const uint32_t key[2], uint32_t output[4]);
+	void refill(void);
+
+	uint32_t key[2];
+	uint64_t counter; // the next block to generate
+	double buffer[RANDOMSTREAM_BATCH];
+	int position;
+};
+
+#endif
@@ -14,6 +14,10 @@ help@multistrand.org
 #include "strandordering.h"
 #include "optionlists.h"
 
+// The running total flux is recomputed from the loops after this many moves,
+// to stop floating point drift from accumulating.
+const int FLUX_RECOMPUTE_INTERVAL = 10000;
+
 class StrandComplex {
 public:
 	// Constructors. Still not sure on exactly how I want to do these. For now, they take a character sequence and structure.
@@ -34,9 +38,11 @@ public:
 	char *getSequence(void); // returns char representation of sequence
 	char *getStructure(void); // returns dot-paren notation structure for seq.
 	char *getStrandNames(void); // returns ordered list of strand names
+	uint64_t getStructureHash(void); // hash of strands and base pairs, see StrandOrdering
 	BaseCount& getExteriorBases(HalfContext* = NULL);
 	int checkIDList(class identList *stoplist, int id_count);
-	int checkIDBound(char *id);
+	int checkStructure(class identList *stoplist, int id_count, char *structure);
+	int checkDistance(class complexItem *stopitem);
 
 	// published functions to affect the complex, these being a choice being made on the move set inside the complex, usually.
 	// Once these are working, will need to add functions to merge complexes and perhaps others. Also, performing a choice will need to be able to pop a disassociation event back to the main system. Maybe do this with exceptions?
@@ -56,9 +62,14 @@ public:
 
 	StrandOrdering* ordering;
 private:
+	void recomputeFlux(void);
+
 	Loop *beginLoop;
+	LoopIndex *loopIndex; // all loops of the complex, for getChoice
 
-//	double totalFlux = 0.0; // Total flux contained within this complex.
+	double totalFlux = 0.0; // Total flux contained within this complex, updated from Loop::fluxChange.
+	double fluxScale = 0.0; // Largest totalFlux since the last recompute, to detect cancellation.
+	int fluxSteps = 0; // Moves since the last recompute.
 
 };
 
@@ -9,9 +9,11 @@ help@multistrand.org
 #include "scomplex.h"
 #include "energymodel.h"
 #include "optionlists.h"
+#include "stopmatcher.h"
 #include <stdio.h>
 
 #include <iostream>
+#include <unordered_map>
 
 using std::cout;
 
@@ -33,6 +35,9 @@ public:
 	BaseCount getExposedBases();
 	OpenInfo getOpenInfo();
 
+	void refreshJoinData(void);
+	void addJoinData(SComplexListEntry*, int);
+
 	double getJoinFluxArr(void);
 	double computeArrBiRate(SComplexListEntry*);
 	double cycleCrossRateArr(StrandOrdering*, StrandOrdering*);
@@ -47,14 +52,18 @@ public:
 	int doJoinChoice(double choice);
 	void doJoinChoiceArr(double choice);
 	bool checkStopComplexList(class complexItem *stoplist);
+	bool checkStopCondition(int index, class complexItem *stoplist);
 	string toString(void);
+	uint64_t getStateHash(void); // of all complexes, independent of their order and rotation
 	void updateOpenInfo(void);
 
+	// compiled stop complexes, not owned. Without one every stop complex is checked directly.
+	StopMatcher* stopMatcher = NULL;
+
 private:
 	bool checkStopComplexList_Bound(class complexItem *stoplist);
 	bool checkStopComplexList_Structure_Disassoc(class complexItem *stoplist);
-	bool checkLooseStructure(char *our_struc, char *stop_struc, int count);
-	bool checkCountStructure(char *our_struc, char *stop_struc, int count);
+	bool checkStopComplexList_Disassoc(class complexItem *stopitem, int id_count);
 
 	int numOfComplexes = 0;
 	int idcounter = 0;
@@ -62,8 +71,33 @@ private:
 	SComplexListEntry* first = NULL;
 	EnergyModel* eModel = NULL;
 
+	// every strand in the system, by the nameKey of its tag. Strands are only
+	// moved between orderings, never created or destroyed, so this is built once
+	// by initializeList; each strand knows its ordering and whether it is bound.
+	std::unordered_multimap<uint64_t, orderingList*> strandIndex;
+
+	// the STOPEVENT kind of the last move, and the name mask of the complexes it changed.
+	void setLastEvent(int event, uint64_t names);
+
+	int lastEvent = 0;
+	uint64_t lastNames = 0;
+	long moveCount = 0; // moves that changed the state
+
+	// the result of each stop condition, and the moveCount it was checked at.
+	vector<bool> stopResults;
+	vector<long> stopChecked;
+
 	double joinRate = 0.0;
 
+	// running totals over all complexes, kept up to date by refreshJoinData.
+	// selfMoves and selfCross count the pairs within a single complex, which are not join moves.
+	BaseCount exposedTotal;
+	int selfMoves = 0;
+
+	OpenInfo openTotal;
+	int selfCross[HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL];
+	double crossRates[HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL];
+
 }
 ;
 
@@ -76,6 +110,7 @@ public:
 	void fillData(EnergyModel *em);
 	string toString(EnergyModel *em);
 	void dumpComplexEntryToPython(int *our_id, char **names, char **sequence, char **structure, double *our_energy);
+	bool matchesStop(StopMatcher *matcher, complexItem *item);
 
 	int id;
 	StrandComplex* thisComplex;
@@ -83,6 +118,20 @@ public:
 	double energy;
 	double rate;
 
+	// the join data this complex last contributed to the list totals.
+	// fillData marks it stale, as does any change to the ordering's open version;
+	// the complex is then re-counted on the next refresh.
+	BaseCount exposedBases;
+	OpenInfo openInfo;
+	uint64_t joinDataVersion = 0;
+	bool joinDataCounted = false;
+	bool joinDataStale = true;
+
+	// the compiled stop complexes this complex matched, when it had these hashes.
+	vector<complexItem*> stopItems;
+	uint64_t stopHashes[2] = { 0, 0 };
+	bool stopProbed = false;
+
 	SComplexListEntry *next;
 };
 
@@ -63,7 +63,7 @@ struct BaseCount {
 	int C(void);
 
 	// the actual data structure; rest is convienience
-	vector<int> count = { 0, 0, 0, 0, 0 }; // use baseType as access
+	int count[BASETYPE_SIZE] = { 0, 0, 0, 0, 0 }; // use baseType as access
 };
 
 #endif
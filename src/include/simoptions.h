@@ -50,6 +50,9 @@ public:
 	double getMaxSimTime(void);
 
 	bool usingArrhenius(void);
+	bool usingMoveTree(void);
+	bool usingLazyMoves(void);
+	long getThreadCount(void);
 
 	// Virtual methods
 
@@ -72,6 +75,7 @@ public:
 	EnergyOptions* energyOptions = NULL;
 
 	const static bool countStates = false;
+	const static bool countCacheHits = false; // prints the energy cache counters after a simulation
 
 protected:
 
@@ -84,6 +88,9 @@ protected:
 	double max_sim_time = 0;
 	long seed = 0;
 	bool fixedRandomSeed = false;
+	bool useMoveTree = false;
+	bool useLazyMoves = false;
+	long num_threads = 1;
 	stopComplexes* myStopComplexes = NULL;
 
 };
@@ -13,9 +13,11 @@ help@multistrand.org
 #include <unordered_map>
 #include <iostream>
 #include <string>
+#include <mutex>
 
 #include "energymodel.h"
 #include "scomplexlist.h"
+#include "randomstream.h"
 
 typedef std::vector<bool> boolvector;
 typedef std::vector<bool>::iterator boolvector_iterator;
@@ -39,6 +41,14 @@ public:
 	int isEnergymodelNull(void);
 
 private:
+	// worker for StartSimulation_Threaded, sharing the options and energy model of parent
+	SimulationSystem(SimulationSystem* parent);
+
+	void StartSimulation_Threaded(void);
+	void runWorker(void);
+	bool nextTrajectory(long* index);
+	void failTrajectory(long index);
+
 	void StartSimulation_Standard(void);
 	void StartSimulation_FirstStep(void);
 	void StartSimulation_Trajectory(void);
@@ -52,6 +62,7 @@ private:
 	int InitializeSystem(PyObject *alternate_start = NULL);
 
 	void InitializeRNG(void);
+	void startTrajectory(long index);
 	void generateNextRandom(void);
 	void finalizeRun(void);
 	void finalizeSimulation(void);
@@ -69,6 +80,7 @@ private:
 	void printAllMoves(void);
 
 	EnergyModel* energyModel;
+	bool ownsEnergyModel = false; // false when borrowed from a parent or from initialize_energy_model
 
 	StrandComplex *startState;
 	SComplexList *complexList;
@@ -76,16 +88,35 @@ private:
 	PyObject *system_options;
 	SimOptions *simOptions;
 
+	// stop conditions, read from the options once and shared by all trajectories.
+	stopComplexes *stopConditions = NULL;
+	StopMatcher *stopMatcher = NULL; // the same, compiled
+
 	long current_seed = NULL;
 	long simulation_mode;
 	long simulation_count_remaining;
 
+	// the random stream of the current trajectory; see RandomStream::trajectorySeed.
+	RandomStream rng;
+	long initial_seed = 0;
+	long trajectory_index = 0;
+
+	// threaded mode: the lock on python callbacks, the shared options and the
+	// trajectory counter. Workers point to their parent's lock.
+	SimulationSystem* parent = NULL;
+	std::recursive_mutex* callbackMutex = NULL;
+	bool releasedGIL = false;
+	vector<long> failedTrajectories; // could not be initialized, reported after the join
+
 	//bool triggers for output
 	bool exportStatesTime = false;
 	bool exportStatesInterval = false;
 
 	// some results objects
-	std::unordered_map<std::string, int> countMap;
+	std::unordered_map<uint64_t, int> countMap; // by SComplexList::getStateHash
+	long cacheHits = 0; // energy cache lookups made by this system's threads
+	long cacheMisses = 0;
+	long boundMisses = 0; // see LazyMoves
 
 };
 
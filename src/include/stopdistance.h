@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* StopDistance class header. The base pair distance from a complex to a loose or count stop complex, kept up to date by the moves. */
+
+#ifndef __STOPDISTANCE_H__
+#define __STOPDISTANCE_H__
+
+#include <vector>
+
+using std::vector;
+
+class StrandOrdering;
+class orderingList;
+class complexItem;
+class OpenLoop;
+
+// The distance is the number of bases whose partner, or lack of one, differs
+// from the stop structure; bases marked '*' in a loose structure do not count.
+// A stop complex with repeated strand names can match several rotations of the
+// complex, and each keeps its own distance.
+//
+// A base pair move changes the partners of two bases only, so update() adjusts
+// the distances in constant time. The strands of the complex must not change:
+// StrandOrdering drops its distances on a join or a break, and builds them again
+// when next asked.
+class StopDistance {
+public:
+	StopDistance(complexItem *item, StrandOrdering *ordering);
+
+	// the first strand of a rotation that is within the distance of the stop complex, or NULL.
+	OpenLoop *check(void);
+
+	void update(orderingList *first, int firstIndex, orderingList *second, int secondIndex, bool paired);
+
+	complexItem *item;
+
+private:
+	struct Rotation {
+		int start; // index in strands
+		int distance;
+	};
+
+	int position(Rotation &rotation, orderingList *strand, int index);
+
+	vector<orderingList*> strands; // in the order of the ordering when this was made
+	vector<int> offsets;
+	int length = 0;
+
+	vector<int> stopPartner; // of each base in the stop structure, -1 if unpaired
+	vector<bool> counted; // false for the '*' of a loose structure
+	vector<Rotation> rotations; // those where the strand names match
+};
+
+#endif
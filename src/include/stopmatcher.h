@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* StopMatcher class header. The exact structure stop complexes, compiled into a hash table, and the moves each stop condition depends on. */
+
+#ifndef __STOPMATCHER_H__
+#define __STOPMATCHER_H__
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "optionlists.h"
+
+using std::vector;
+
+class StrandComplex;
+
+// the kinds of moves, see SComplexList::checkStopCondition.
+#define STOPEVENT_PAIR    0x01 // a base pair made, broken or shifted inside one complex
+#define STOPEVENT_JOIN    0x02
+#define STOPEVENT_SPLIT   0x04
+#define STOPEVENT_ALL     0x07
+
+// STOPTYPE_STRUCTURE items are keyed like StrandOrdering::getNameHash, by their
+// strand names and base pairs. The key ignores rotation, so a complex finds its
+// candidates with one lookup. Candidates are confirmed with the exact check,
+// which also rotates the complex as checkIDList does.
+//
+// The other stop types are not compiled, see SComplexList::checkStopComplexList.
+//
+// Each stop condition is also tagged with the moves that can change whether it
+// holds: the STOPEVENT kinds, and the names of the strands it lists. A
+// disassociation condition, for one, cannot change on a base pair move, nor on
+// any move of a complex without its strands. A condition of several complexes
+// also counts the complexes, so every join and split can change it.
+class StopMatcher {
+public:
+	StopMatcher(stopComplexes *conditions);
+
+	static bool isCompiled(complexItem *item);
+
+	// appends the compiled stop complexes that the complex matches.
+	void findItems(StrandComplex *complex, vector<complexItem*> &items);
+
+	// whether a move of this STOPEVENT kind, on complexes with this
+	// StrandOrdering::getNameMask, can change the condition at this position.
+	bool dependsOn(int condition, int event, uint64_t names);
+
+private:
+	struct Entry {
+		complexItem *item;
+		int strandCount;
+	};
+
+	struct Dependency {
+		int events; // on complexes with one of the names
+		uint64_t names;
+		int anywhere; // events that matter on any complex
+	};
+
+	void compile(complexItem *item);
+
+	std::unordered_multimap<uint64_t, Entry> structures;
+	vector<Dependency> dependencies; // by position in the stop conditions
+};
+
+#endif
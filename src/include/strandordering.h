@@ -10,11 +10,16 @@ help@multistrand.org
 #include "loop.h"
 #include "scomplex.h"
 #include "optionlists.h"
+#include "pairmask.h"
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 // needed for the openloop components of a strand ordering
 
 class OpenLoop;
+class StopDistance;
+class StrandOrdering;
 
 class orderingList {
 public:
@@ -25,6 +30,12 @@ public:
 	OpenLoop *thisLoop; // corresponds to the OpenLoop to the 'left' of this strand
 	int size;
 	int uid;
+	int offset; // position of this strand in the flat seq/struc of its ordering, while those exist
+	uint64_t uidHash; // keys of this strand, see structurehash.h
+	uint64_t nameHash;
+	int unpaired; // bases without a partner; the strand is bound when there are none
+	StrandOrdering *ordering; // that currently holds this strand, kept up to date by joins and breaks
+	PairMask mask; // of thisCodeSeq, built when its loops first generate moves
 };
 
 class StrandOrdering {
@@ -42,7 +53,9 @@ public:
 	void breakBasepair(char *first_bp, char *second_bp);
 
 	OpenLoop *checkIDList(class identList *stoplist, int count);
-	int checkIDBound(char *id);
+	OpenLoop *checkStructure(class identList *stoplist, int count, char *structure);
+	OpenLoop *checkDistance(class complexItem *stopitem); // loose and count stop types, see StopDistance
+	int getPartners(vector<orderingList*> &strands, vector<int> &offsets, vector<int> &partner);
 
 	// following three functions are used by SComplex::generateLoops
 	// to generate the loop structure of a given complex, using a flat representation of the starting sequence and structure.
@@ -77,6 +90,25 @@ public:
 	OpenInfo& getOpenInfo();
 	string toString(void);
 
+	// hash of the strands (by uid) and the base pairs between them, which does not
+	// depend on how the ordering is rotated. Kept current by addBasepair,
+	// breakBasepair, joinOrdering and breakOrdering.
+	uint64_t getStructureHash(void);
+
+	// the same with strands keyed by name, as stop conditions give them, so that
+	// strands with equal names are interchangeable.
+	uint64_t getNameHash(void);
+
+	// the nameBit of each strand in the ordering, kept current like the hashes.
+	uint64_t getNameMask(void);
+
+	// counts the changes to the open loops and base pairs. Unlike openInfo.upToDate,
+	// it is not reset by getOpenInfo, so a cached copy of the join data can be checked against it.
+	uint64_t getOpenVersion(void);
+
+	// recomputes the hashes, true if they were up to date.
+	bool verifyHashes(void);
+
 	// replaces the first open loop in the ordering with the second.
 	void replaceOpenLoop(Loop *oldLoop, Loop *newLoop);
 
@@ -89,6 +121,10 @@ public:
 	OpenInfo openInfo;
 
 private:
+	void flatten(void); // builds seq and struc, and the strand offsets into them
+
+	// Flat sequence and structure of the ordering. Base pair moves patch struc in
+	// place; both are rebuilt only after a join, split or reorder.
 	char* seq = NULL;
 	char* struc = NULL;
 	char* strandnames = NULL;
@@ -96,6 +132,19 @@ private:
 	int count = 0;
 	BaseCount exteriorBases;
 
+	void computeHashes(void);
+	void clearDistances(void);
+	void invalidateOpenInfo(void); // every mutator of the open loops calls this
+
+	uint64_t openVersion = 0;
+
+	uint64_t structureHash = 0; // XOR of uid keys
+	uint64_t strandNameHash = 0; // sums of name keys: equal names may repeat
+	uint64_t pairNameHash = 0;
+	uint64_t nameMask = 0;
+
+	vector<StopDistance*> distances; // to the stop complexes checked since the last join or break
+
 };
 
 #endif
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+/* Hash keys for strands, bases and base pairs. Used by StrandOrdering, SComplexList and StopMatcher. */
+
+#ifndef __STRUCTUREHASH_H__
+#define __STRUCTUREHASH_H__
+
+#include <stdint.h>
+
+// Zobrist-style keys, made on the fly by a 64 bit finalizer (splitmix64)
+// instead of read from a table.
+inline uint64_t mixHash(uint64_t x) {
+
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+
+}
+
+// a strand, by its uid
+inline uint64_t uidKey(long uid) {
+
+	return mixHash((uint64_t) uid);
+
+}
+
+// a strand, by its name (FNV-1a)
+inline uint64_t nameKey(const char *name) {
+
+	uint64_t hash = 0xCBF29CE484222325ULL;
+
+	for (const char *c = name; *c != '\0'; c++)
+		hash = (hash ^ (unsigned char) *c) * 0x100000001B3ULL;
+
+	return mixHash(hash);
+
+}
+
+// one of 64 bits for a strand name key, for sets of names that may report
+// names which are not in them, but never miss one.
+inline uint64_t nameBit(uint64_t name) {
+
+	return 1ULL << (name >> 58);
+
+}
+
+// a base, by the key of its strand and its position in the strand
+inline uint64_t baseKey(uint64_t strand, int index) {
+
+	return mixHash(strand + 0x9E3779B97F4A7C15ULL * (uint64_t) (index + 1));
+
+}
+
+// a base pair, by the keys of both bases, in either order
+inline uint64_t pairKey(uint64_t first, uint64_t second) {
+
+	return mixHash(first + second);
+
+}
+
+#endif
@@ -232,6 +232,44 @@ EEnd, ELoop, EStack, EStackStack, ELoopEnd, EStackEnd, EStackLoop (double value)
         self.num_simulations = 1
         """ Total number of trajectories to run. 
         """
+
+        self.num_threads = 1
+        """ Number of threads used to run the trajectories.
+
+        Type         Default
+        int          1
+
+        With more than one thread, trajectories run concurrently inside
+        this process, sharing the energy model. Results are reported in
+        the order the trajectories finish, and trajectory output
+        (output_interval, output_time) of concurrent trajectories is
+        interleaved.
+        """
+
+        self.use_move_tree = False
+        """ Whether the loops keep their creation moves in a Fenwick tree.
+
+        Type         Default
+        bool         False
+
+        A move is then chosen in time logarithmic in the number of moves
+        of a loop, instead of linear. Worth it for long single stranded
+        regions; the trajectories are the same either way.
+        """
+
+        self.use_lazy_moves = False
+        """ Whether long open and multi loops group their creation moves.
+
+        Type         Default
+        bool         False
+
+        Loops with at least 1024 possible base pairs then keep their
+        creation moves in groups with a common upper bound on the rate,
+        and a chosen move is accepted with probability rate / bound.
+        Rejected choices leave the state unchanged, so the simulation
+        stays exact while moves are generated far less often. Ignored
+        with the Arrhenius rate model.
+        """
         
         self.initial_seed = None
         """ Initial random number seed to use.
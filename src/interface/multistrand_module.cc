@@ -79,6 +79,9 @@ static PyObject *SimSystemObject_start(SimSystemObject *self, PyObject *args) {
 	}
 	self->ob_system->StartSimulation();
 
+	if (PyErr_Occurred())
+		return NULL;
+
 	Py_INCREF(Py_None);
 	return Py_None;
 }
@@ -332,9 +335,6 @@ static PyObject *System_calculate_rate(PyObject *self, PyObject *args, PyObject
 
 			return NULL;
 		}
-		if (Loop::GetEnergyModel() == NULL) {
-			Loop::SetEnergyModel(em);
-		}
 	}
 
 	if (joinflag == 1) // join
@@ -378,6 +378,10 @@ static PyObject *System_run_system(PyObject *self, PyObject *args) {
 #endif
 
 	Py_XDECREF(options_object);
+
+	if (PyErr_Occurred())
+		return NULL;
+
 	Py_INCREF(Py_None);
 	return Py_None;
 
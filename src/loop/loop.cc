@@ -10,7 +10,9 @@
 #include <stdio.h>
 #include <assert.h>
 #include "loop.h"
+#include "pairmask.h"
 #include <typeinfo>
+#include <algorithm>
 
 #include "utility.h"
 #include "moveutil.h"
@@ -19,7 +21,7 @@
 
 using std::string;
 
-EnergyModel* Loop::energyModel = NULL;
+thread_local EnergyModel* Loop::energyModel = NULL;
 
 struct RateArr;
 
@@ -84,7 +86,7 @@ double Loop::returnFlux(Loop *comefrom) {
 	double total = 0.0;
 
 	if (moves != NULL) {
-		total = moves->getRate();
+		total = getLocalRate();
 	}
 
 	for (int loop = 0; loop < curAdjacent; loop++) {
@@ -115,6 +117,188 @@ inline double Loop::getTotalRate(void) {
 	return totalRate;
 }
 
+thread_local double Loop::fluxChange = 0.0;
+
+void Loop::setTotalRate(double rate) {
+	fluxChange += rate - totalRate;
+	totalRate = rate;
+
+	if (loopIndex != NULL)
+		loopIndex->update(this);
+	else if (LoopIndex::active != NULL)
+		LoopIndex::active->insert(this);
+}
+
+Move *Loop::getLocalChoice(double *randomchoice) {
+	assert(moves != NULL);
+
+	if (lazyMoves == NULL || lazyMoves->getRate() <= 0.0 || *randomchoice < moves->getRate())
+		return moves->getChoice(randomchoice);
+
+	int side1, pos1, side2, pos2, group;
+	double bound;
+
+	*randomchoice -= moves->getRate();
+	lazyMoves->getChoice(randomchoice, &side1, &pos1, &side2, &pos2, &bound, &group);
+
+	// the remainder is uniform below the bound, so this accepts with probability rate / bound.
+	MoveBatch &batch = MoveBatch::local;
+
+	if (!addCreationMove(side1, pos1, side2, pos2, NULL, NULL, batch))
+		return NULL;
+
+	Move *move = batch.take(energyModel, getEnergy(), this);
+
+	if (move->getRate() > bound) {
+		delete move;
+		expandGroup(group);
+		return NULL;
+	}
+
+	if (*randomchoice >= move->getRate()) {
+		delete move;
+		return NULL;
+	}
+
+	lazyMoves->keepChoice(move);
+	return move;
+}
+
+// A move of the group was above its bound, so its moves are made exact instead: this
+// step is rejected, and the flux of the loop changes to the exact rates from here on.
+void Loop::expandGroup(int group) {
+
+	LazyMoves::boundMisses++;
+
+	int side1, side2;
+	std::vector<int> pos1, pos2;
+	MoveBatch &batch = MoveBatch::local;
+
+	lazyMoves->getMembers(group, &side1, &side2, pos1, pos2);
+
+	for (unsigned int loop = 0; loop < pos1.size(); loop++)
+		addCreationMove(side1, pos1[loop], side2, pos2[loop], NULL, NULL, batch);
+
+	batch.flush(energyModel, getEnergy(), this, moves);
+	lazyMoves->removeGroup(group);
+
+	setTotalRate(getLocalRate());
+
+}
+
+double Loop::getLocalRate(void) {
+
+	if (lazyMoves == NULL)
+		return moves->getRate();
+
+	return moves->getRate() + lazyMoves->getRate();
+
+}
+
+bool Loop::groupCreationMoves(long pairs) {
+
+	// the bounds do not cover the singlestranded stacking of the Arrhenius model.
+	return LazyMoves::useLazyMoves && pairs >= LAZY_MIN_PAIRS && !energyModel->useArrhenius();
+
+}
+
+// bits start .. start + 63 of a bitset of words words, zero past its end.
+static inline uint64_t bitsAt(uint64_t *set, int words, int start) {
+
+	int word = start >> 6;
+	int shift = start & 63;
+
+	if (word >= words)
+		return 0;
+
+	uint64_t result = set[word] >> shift;
+
+	if (shift != 0 && word + 1 < words)
+		result |= set[word + 1] << (64 - shift);
+
+	return result;
+
+}
+
+// bit pos of set[base * words] is set when base pos of the side is base, for pos 1 .. length.
+static void baseBits(char *sequence, int length, std::vector<uint64_t> &set, int *words) {
+
+	*words = (length >> 6) + 1;
+	set.assign(NUM_BASES * *words, 0);
+
+	for (int pos = 1; pos <= length; pos++)
+		set[(int) sequence[pos] * *words + (pos >> 6)] |= 1ULL << (pos & 63);
+
+}
+
+// Groups the creation moves between sides first and last of an open or multi loop by the
+// number of bases they leave unpaired between them, see LazyMoves. A group is a diagonal of
+// positions, (pos1 + k, pos2 + k); its members are the k where the two bases can pair.
+void Loop::addCreationGroups(bool open, int *sidelen, char **seqs, int first, int last) {
+
+	if (lazyMoves == NULL)
+		lazyMoves = new LazyMoves();
+
+	static thread_local std::vector<uint64_t> firstBits, lastBits, members;
+	int firstWords, lastWords;
+
+	baseBits(seqs[first], sidelen[first], firstBits, &firstWords);
+	baseBits(seqs[last], sidelen[last], lastBits, &lastWords);
+
+	double bound;
+	int pos1, pos2, count;
+
+	for (int unpaired = (first == last) ? 3 : 0; unpaired <= sidelen[first] + ((first == last) ? 0 : sidelen[last]) - 2; unpaired++) {
+
+		if (first == last) {
+
+			// hairpins of unpaired bases, closed by (pos, pos + unpaired + 1).
+			pos1 = 1;
+			pos2 = unpaired + 2;
+			count = sidelen[first] - unpaired - 1;
+
+		} else {
+
+			// a bases left on side first, and unpaired - a on side last.
+			int amin = std::max(0, unpaired - (sidelen[last] - 1));
+			int amax = std::min(sidelen[first] - 1, unpaired);
+
+			pos1 = sidelen[first] - amax;
+			pos2 = unpaired - amax + 1;
+			count = amax - amin + 1;
+
+		}
+
+		if (count <= 0)
+			continue;
+
+		int words = (count + 63) >> 6;
+		members.assign(words, 0);
+
+		for (int base1 = 1; base1 < NUM_BASES; base1++)
+			for (int base2 = 1; base2 < NUM_BASES; base2++)
+				if (energyModel->pairtypes[base1][base2] != 0)
+					for (int word = 0; word < words; word++)
+						members[word] |= bitsAt(&firstBits[base1 * firstWords], firstWords, pos1 + (word << 6))
+								& bitsAt(&lastBits[base2 * lastWords], lastWords, pos2 + (word << 6));
+
+		if (count & 63)
+			members[words - 1] &= (1ULL << (count & 63)) - 1;
+
+		bound = energyModel->CreationEnergyBound(open, numAdjacent, sidelen, seqs, first, last, unpaired);
+		bound = energyModel->returnRate(getEnergy(), getEnergy() + bound, 0);
+		lazyMoves->addGroup(first, pos1, last, pos2, count, members.data(), bound);
+
+	}
+
+}
+
+bool Loop::addCreationMove(int, int, int, int, int*, char**, MoveBatch&) {
+
+	return false; // only open and multi loops group their moves
+
+}
+
 Loop::Loop(void) {
 	numAdjacent = 0;
 	curAdjacent = 0;
@@ -132,6 +316,11 @@ Loop::~Loop(void) {
 
 	int counter;
 
+	fluxChange -= totalRate;
+
+	if (loopIndex != NULL)
+		loopIndex->remove(this);
+
 	if (adjacentLoops != NULL) {
 		for (counter = 0; counter < curAdjacent; counter++) {
 			if (adjacentLoops[counter] != NULL) {
@@ -139,13 +328,42 @@ Loop::~Loop(void) {
 				adjacentLoops[counter] = NULL; // Hah, take that!
 			}
 		}
-		delete[] adjacentLoops;
+		releaseArray(adjacentLoops);
 		adjacentLoops = NULL;
 	}
 	if (moves != NULL) {
 		delete moves;
 		moves = NULL;
 	}
+	if (lazyMoves != NULL) {
+		delete lazyMoves;
+		lazyMoves = NULL;
+	}
+}
+
+void* Loop::operator new(size_t size) {
+
+	return poolAllocate(size);
+
+}
+
+// the size is that of the derived loop, as the destructor is virtual.
+void Loop::operator delete(void* memory, size_t size) {
+
+	poolRelease(memory, size);
+
+}
+
+void Loop::regenerateDeleteMoves(void) {
+
+	if (moves == NULL) {
+		generateMoves();
+		return;
+	}
+
+	moves->resetDeleteMoves();
+	generateDeleteMoves();
+
 }
 
 void Loop::initAdjacency(int index) {
@@ -211,8 +429,8 @@ void Loop::performComplexSplit(Move *move, Loop **firstOpen, Loop **secondOpen)
 
 	for (flipflop = 0; flipflop < 2; flipflop++) {
 
-		sidelen = new int[sizes[flipflop] + 1];
-		seqs = new char *[sizes[flipflop] + 1];
+		sidelen = poolArray<int>(sizes[flipflop] + 1);
+		seqs = poolArray<char*>(sizes[flipflop] + 1);
 
 		for (loop = 0; loop < sizes[flipflop] + 1; loop++) {
 			if (loop < index[flipflop]) {
@@ -248,10 +466,9 @@ void Loop::performComplexSplit(Move *move, Loop **firstOpen, Loop **secondOpen)
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < sizes[flipflop]; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		if (flipflop == 0)
 			*firstOpen = newLoop;
@@ -485,8 +702,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		// FD: e_index is the index of the attached loop for multiloop end_
 		// FD: s_index is the index of the attached loop for stackloop start_
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -510,8 +727,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		left = stackMove;
 		right = energyModel->getPrefactorsMulti(e_index, end_->numAdjacent, end_->sidelen);
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 	}
@@ -535,8 +752,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -567,8 +784,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		left = energyModel->prefactorOpen(e_index, (end_->numAdjacent + 1), end_->sidelen);
 		right = stackMove;
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -667,8 +884,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -693,8 +910,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		left = energyModel->getPrefactorsMulti(e_index, end_->numAdjacent, end_->sidelen);
 		right = loopMove;
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -718,8 +935,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -747,8 +964,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 	}
@@ -820,8 +1037,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -849,8 +1066,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 		return RateArr(tempRate / 2.0, left, right);
 
 	}
@@ -873,8 +1090,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -901,8 +1118,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -986,8 +1203,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		else if (end_->numAdjacent > 3)  // multiloop case
 				{
-			int *sidelens = new int[end_->numAdjacent - 1];
-			char **seqs = new char *[end_->numAdjacent - 1];
+			int *sidelens = poolArray<int>(end_->numAdjacent - 1);
+			char **seqs = poolArray<char*>(end_->numAdjacent - 1);
 
 			for (int loop = 0; loop < end_->numAdjacent; loop++) {
 				if (loop != e_index) {
@@ -1022,8 +1239,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 			}
 
-			delete[] sidelens;
-			delete[] seqs;
+			releaseArray(sidelens);
+			releaseArray(seqs);
 
 			return RateArr(tempRate / 2.0, left, right);
 
@@ -1044,8 +1261,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop < e_index) {
@@ -1074,8 +1291,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 		return RateArr(tempRate / 2.0, left, right);
 
 	}
@@ -1105,8 +1322,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 2];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 2];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 2);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 2);
 
 		index = 0;
 		for (int loop = 0; loop < start_->numAdjacent; loop++) {
@@ -1145,8 +1362,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -1172,8 +1389,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 1];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 1);
 
 		index = 0;
 		for (int loop = 0; loop <= start_->numAdjacent; loop++) {
@@ -1221,8 +1438,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		}
 
-		delete[] sidelens;
-		delete[] seqs;
+		releaseArray(sidelens);
+		releaseArray(seqs);
 
 		return RateArr(tempRate / 2.0, left, right);
 
@@ -1260,8 +1477,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 
 		for (flipflop = 0; flipflop < 2; flipflop++) {
 
-			sidelen = new int[sizes[flipflop] + 1];
-			seqs = new char *[sizes[flipflop] + 1];
+			sidelen = poolArray<int>(sizes[flipflop] + 1);
+			seqs = poolArray<char*>(sizes[flipflop] + 1);
 
 			for (loop = 0; loop < sizes[flipflop] + 1; loop++) {
 				if (loop < index[flipflop]) {
@@ -1282,8 +1499,8 @@ RateArr Loop::generateDeleteMoveRate(Loop *start, Loop *end) {
 			//initialize the new openloops, and connect them correctly, then initialize their moves, etc.
 			new_energies[flipflop] = energyModel->OpenloopEnergy(sizes[flipflop], sidelen, seqs);
 
-			delete[] sidelen;
-			delete[] seqs;
+			releaseArray(sidelen);
+			releaseArray(seqs);
 		}
 
 		old_energy = start->getEnergy() + end->getEnergy();
@@ -1387,10 +1604,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
-		end_->adjacentLoops[e_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
+		end_->adjacentLoops[e_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1440,10 +1656,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
-		end_->adjacentLoops[e_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
+		end_->adjacentLoops[e_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1488,10 +1703,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
-		end_->adjacentLoops[e_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
+		end_->adjacentLoops[e_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1525,9 +1739,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1556,8 +1769,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -1589,10 +1802,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < end_->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1632,8 +1844,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		cout << "End is " << endl;
 //		cout << end_->typeInternalsToString() << endl;
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -1667,10 +1879,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < end_->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1717,10 +1928,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
-		end_->adjacentLoops[e_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
+		end_->adjacentLoops[e_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1767,10 +1977,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
-		end_->adjacentLoops[e_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
+		end_->adjacentLoops[e_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1802,9 +2011,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1833,8 +2041,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -1866,10 +2074,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < end_->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1899,8 +2106,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -1932,10 +2139,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < end_->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -1985,10 +2191,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 //		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
-		end_->adjacentLoops[e_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
+		end_->adjacentLoops[e_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2020,9 +2225,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for the two adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
-		start_->adjacentLoops[s_index]->generateMoves();
+		// need to re-generate the deletion moves for the two adjacent loops.
+		start_->adjacentLoops[s_index]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2051,8 +2255,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent; loop++) {
 			if (loop != e_index) {
@@ -2084,10 +2288,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < end_->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2116,8 +2319,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent + 1];
-		char **seqs = new char *[end_->numAdjacent + 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + 1);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop == e_index) {
@@ -2149,10 +2352,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < end_->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2223,10 +2425,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 				newLoop->generateMoves();
 
-				// need to re-generate the moves for all adjacent loops.
-				// TODO: change this to only re-generate the deletion moves.
-				newLoop->adjacentLoops[0]->generateMoves();
-				newLoop->adjacentLoops[1]->generateMoves();
+				// need to re-generate the deletion moves for all adjacent loops.
+				newLoop->adjacentLoops[0]->regenerateDeleteMoves();
+				newLoop->adjacentLoops[1]->regenerateDeleteMoves();
 
 				start_->cleanupAdjacent();
 				delete start_;
@@ -2248,10 +2449,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 				newLoop->generateMoves();
 
-				// need to re-generate the moves for all adjacent loops.
-				// TODO: change this to only re-generate the deletion moves.
-				newLoop->adjacentLoops[0]->generateMoves();
-				newLoop->adjacentLoops[1]->generateMoves();
+				// need to re-generate the deletion moves for all adjacent loops.
+				newLoop->adjacentLoops[0]->regenerateDeleteMoves();
+				newLoop->adjacentLoops[1]->regenerateDeleteMoves();
 				start_->cleanupAdjacent();
 				delete start_;
 				end_->cleanupAdjacent();
@@ -2262,8 +2462,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		else if (end_->numAdjacent > 3)              // multiloop case
 				{
-			int* sidelens = new int[end_->numAdjacent - 1];
-			char** seqs = new char*[end_->numAdjacent - 1];
+			int* sidelens = poolArray<int>(end_->numAdjacent - 1);
+			char** seqs = poolArray<char*>(end_->numAdjacent - 1);
 
 			if (utility::debugTraces) {
 
@@ -2302,10 +2502,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 			newLoop->generateMoves();
 
-			// need to re-generate the moves for all adjacent loops.
-			// TODO: change this to only re-generate the deletion moves.
+			// need to re-generate the deletion moves for all adjacent loops.
 			for (int loop = 0; loop < newLoop->numAdjacent; loop++)
-				newLoop->adjacentLoops[loop]->generateMoves();
+				newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 			start_->cleanupAdjacent();
 			delete start_;
@@ -2332,8 +2531,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for openloops.
 
-		int *sidelens = new int[end_->numAdjacent];
-		char **seqs = new char *[end_->numAdjacent];
+		int *sidelens = poolArray<int>(end_->numAdjacent);
+		char **seqs = poolArray<char*>(end_->numAdjacent);
 
 		for (int loop = 0; loop < end_->numAdjacent + 1; loop++) {
 			if (loop < e_index) {
@@ -2359,10 +2558,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < newLoop->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2396,8 +2594,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 2];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 2];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 2);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 2);
 
 		index = 0;
 		for (int loop = 0; loop < start_->numAdjacent; loop++) {
@@ -2441,10 +2639,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < newLoop->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2473,8 +2670,8 @@ Loop *Loop::performDeleteMove(Move *move) {
 		}
 		// note e_index has different meaning now for multiloops.
 
-		int *sidelens = new int[end_->numAdjacent + start_->numAdjacent - 1];
-		char **seqs = new char *[end_->numAdjacent + start_->numAdjacent - 1];
+		int *sidelens = poolArray<int>(end_->numAdjacent + start_->numAdjacent - 1);
+		char **seqs = poolArray<char*>(end_->numAdjacent + start_->numAdjacent - 1);
 
 		index = 0;
 		for (int loop = 0; loop <= start_->numAdjacent; loop++) {
@@ -2526,10 +2723,9 @@ Loop *Loop::performDeleteMove(Move *move) {
 
 		newLoop->generateMoves();
 
-		// need to re-generate the moves for all adjacent loops.
-		// TODO: change this to only re-generate the deletion moves.
+		// need to re-generate the deletion moves for all adjacent loops.
 		for (int loop = 0; loop < newLoop->numAdjacent; loop++)
-			newLoop->adjacentLoops[loop]->generateMoves();
+			newLoop->adjacentLoops[loop]->regenerateDeleteMoves();
 
 		start_->cleanupAdjacent();
 		delete start_;
@@ -2570,14 +2766,12 @@ void StackLoop::generateMoves(void) {
 
 void StackLoop::generateDeleteMoves(void) {
 	double temprate;
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(0); // always have 2 delete moves, no shift moves and no creation moves.
+	moves = MoveContainer::renewContainer(moves, 0); // always have 2 delete moves, no shift moves and no creation moves.
 
 	generateAndSaveDeleteMove(adjacentLoops[0], 0);
 	generateAndSaveDeleteMove(adjacentLoops[1], 1);
 
-	totalRate = moves->getRate();
+	setTotalRate(moves->getRate());
 }
 
 void StackLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
@@ -2662,7 +2856,7 @@ char *StackLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 
 StackLoop::StackLoop(void) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 	identity = 'S';
 }
 
@@ -2670,7 +2864,7 @@ StackLoop::StackLoop(char *seq1, char *seq2, Loop *left, Loop *right) // left an
 		{
 
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 	adjacentLoops[0] = left;
 	adjacentLoops[1] = right;
 	curAdjacent = (left == NULL ? 0 : 1) + (right == NULL ? 0 : 1);
@@ -2702,7 +2896,7 @@ string StackLoop::typeInternalsToString(void) {
 
 HairpinLoop::HairpinLoop(void) {
 	numAdjacent = 1;
-	adjacentLoops = new Loop *[1];
+	adjacentLoops = poolArray<Loop*>(1);
 
 	hairpinsize = 0;
 	hairpin_seq = NULL;
@@ -2711,7 +2905,7 @@ HairpinLoop::HairpinLoop(void) {
 
 HairpinLoop::HairpinLoop(int size, char *hairpin_sequence, Loop *previous) {
 	numAdjacent = 1;
-	adjacentLoops = new Loop *[1];
+	adjacentLoops = poolArray<Loop*>(1);
 	adjacentLoops[0] = previous;
 	if (previous != NULL)
 		curAdjacent = 1;
@@ -2764,7 +2958,7 @@ double HairpinLoop::doChoice(Move *move, Loop **returnLoop) {
 	if (move->type & MOVE_CREATE) {
 		loop = move->index[0];
 		loop2 = move->index[1];
-		pt = pairtypes[hairpin_seq[loop]][hairpin_seq[loop2]];
+		pt = energyModel->pairtypes[(int) hairpin_seq[loop]][(int) hairpin_seq[loop2]];
 		if (move->type & MOVE_1) // stack and hairpin
 				{
 			newLoop[0] = new StackLoop(hairpin_seq, &hairpin_seq[loop2]);
@@ -2773,7 +2967,7 @@ double HairpinLoop::doChoice(Move *move, Loop **returnLoop) {
 			adjacentLoops[0]->replaceAdjacent(this, newLoop[0]);
 			newLoop[0]->addAdjacent(newLoop[1]);
 			newLoop[1]->addAdjacent(newLoop[0]);
-			adjacentLoops[0]->generateMoves();
+			adjacentLoops[0]->regenerateDeleteMoves();
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
 			*returnLoop = newLoop[0];
@@ -2792,7 +2986,7 @@ double HairpinLoop::doChoice(Move *move, Loop **returnLoop) {
 			newLoop[1]->addAdjacent(newLoop[0]);
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
-			adjacentLoops[0]->generateMoves();
+			adjacentLoops[0]->regenerateDeleteMoves();
 			*returnLoop = newLoop[0];
 			return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 		}
@@ -2806,7 +3000,7 @@ double HairpinLoop::doChoice(Move *move, Loop **returnLoop) {
 			newLoop[1]->addAdjacent(newLoop[0]);
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
-			adjacentLoops[0]->generateMoves();
+			adjacentLoops[0]->regenerateDeleteMoves();
 			*returnLoop = newLoop[0];
 			return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 		}
@@ -2820,29 +3014,25 @@ void HairpinLoop::generateMoves(void) {
 	double energies[2];
 	int pt = 0;
 	int loop, loop2;
-	double tempRate = 0;
-	RateEnv rateEnv;
+	MoveBatch &batch = MoveBatch::local;
 
 // Creation moves
 	if (hairpinsize <= 4) {
 		// We cannot form any creation moves in the hairpin unless it has at least 5 bases.
-		if (moves != NULL)
-			delete moves;
-
-		moves = new MoveList(0);
-		totalRate = 0.0;
+		moves = MoveContainer::renewContainer(moves, 0);
+		setTotalRate(0.0);
 		generateDeleteMoves();
 		return;
 	} else {
-		if (moves != NULL)
-			delete moves;
-		moves = new MoveList(1);
+		moves = MoveContainer::renewContainer(moves, 1);
+
+		PairMask::Side mask = PairMask::side(energyModel, hairpin_seq, hairpinsize);
 
 		// Indice 0 is the starting hairpin base. hairpinsize+1 is the ending hairpin base. Thus we want to start at hairpin indice 1, and go to hairpinsize - 3. (which could pair to indice hairpinsize)
 		for (loop = 1; loop <= hairpinsize - 4; loop++)
-			for (loop2 = loop + 4; loop2 <= hairpinsize; loop2++) {
+			for (loop2 = mask.next(hairpin_seq[loop], loop + 4, hairpinsize); loop2 <= hairpinsize; loop2 = mask.next(hairpin_seq[loop], loop2 + 1, hairpinsize)) {
 
-				pt = pairtypes[hairpin_seq[loop]][hairpin_seq[loop2]];
+				pt = energyModel->pairtypes[(int) hairpin_seq[loop]][(int) hairpin_seq[loop2]];
 
 				if (pt != 0) { // the two could pair. Work out energies of the resulting pair of loops.
 
@@ -2856,11 +3046,9 @@ void HairpinLoop::generateMoves(void) {
 
 						energies[0] = energyModel->StackEnergy(hairpin_seq[0], hairpin_seq[hairpinsize + 1], hairpin_seq[loop], hairpin_seq[loop2]);
 						energies[1] = energyModel->HairpinEnergy(&hairpin_seq[1], hairpinsize - 2);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 						// stack and hairpin, so this is loop and stack
-						rateEnv = RateEnv(tempRate, energyModel, loopMove, stackMove);
-						moves->addMove(new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2));
+						batch.add(energies[0] + energies[1], loopMove, stackMove, MOVE_CREATE | MOVE_1, loop, loop2);
 
 					}
 					// bulge + hairpin
@@ -2873,12 +3061,9 @@ void HairpinLoop::generateMoves(void) {
 
 						energies[1] = energyModel->HairpinEnergy(&hairpin_seq[loop], loop2 - loop - 1);
 
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 						// new bulgeloop + hairpin: this is openMove and stackLoopMove
 
-						rateEnv = RateEnv(tempRate, energyModel, loopMove, stackLoopMove);
-						moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2));
+						batch.add(energies[0] + energies[1], loopMove, stackLoopMove, MOVE_CREATE | MOVE_2, loop, loop2);
 
 					} else // interior loop + hairpin case.
 					{
@@ -2887,17 +3072,15 @@ void HairpinLoop::generateMoves(void) {
 
 						// loop2 - loop - 1 is the new hairpin size.
 						energies[1] = energyModel->HairpinEnergy(&hairpin_seq[loop], loop2 - loop - 1);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 						// interiorLoop + hairpin, so this is open + open
 
-						rateEnv = RateEnv(tempRate, energyModel, loopMove, loopMove);
-
-						moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loop, loop2));
+						batch.add(energies[0] + energies[1], loopMove, loopMove, MOVE_CREATE | MOVE_3, loop, loop2);
 					}
 				}
 			}
-		totalRate = moves->getRate();
+		batch.flush(energyModel, getEnergy(), this, moves);
+		setTotalRate(moves->getRate());
 	}
 
 // Shift moves
@@ -2911,7 +3094,7 @@ void HairpinLoop::generateDeleteMoves(void) {
 
 	generateAndSaveDeleteMove(adjacentLoops[0], 0);
 
-	totalRate = moves->getRate();
+	setTotalRate(moves->getRate());
 }
 
 void HairpinLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
@@ -2959,7 +3142,7 @@ char *HairpinLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 
 BulgeLoop::BulgeLoop(void) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 
 	bulgesize[0] = 0;
 	bulgesize[1] = 0;
@@ -2971,7 +3154,7 @@ BulgeLoop::BulgeLoop(void) {
 BulgeLoop::BulgeLoop(int size1, int size2, char *bulge_sequence1, char *bulge_sequence2, Loop *left, Loop *right) {
 	numAdjacent = 2;
 	curAdjacent = 0;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 	adjacentLoops[0] = left;
 	adjacentLoops[1] = right;
 	if (left != NULL)
@@ -3033,15 +3216,15 @@ double BulgeLoop::doChoice(Move *move, Loop **returnLoop) {
 	Loop *newLoop[2];
 	int pt, loop, loop2;
 
-	int *sidelen = new int[3];
-	char **seqs = new char *[3];
+	int *sidelen = poolArray<int>(3);
+	char **seqs = poolArray<char*>(3);
 	int bsize = bulgesize[0] + bulgesize[1];
 	int bside = (bulgesize[0] == 0) ? 1 : 0;
 
 	if (move->type & MOVE_CREATE) {
 		loop = move->index[0];
 		loop2 = move->index[1];
-		pt = pairtypes[bulge_seq[bside][loop]][bulge_seq[bside][loop2]];
+		pt = energyModel->pairtypes[(int) bulge_seq[bside][loop]][(int) bulge_seq[bside][loop2]];
 		if (bside == 1) {
 			sidelen[0] = 0;
 			sidelen[1] = loop - 1;
@@ -3073,8 +3256,8 @@ double BulgeLoop::doChoice(Move *move, Loop **returnLoop) {
 		newLoop[1]->addAdjacent(newLoop[0]);
 		newLoop[0]->generateMoves();
 		newLoop[1]->generateMoves();
-		adjacentLoops[0]->generateMoves();
-		adjacentLoops[1]->generateMoves();
+		adjacentLoops[0]->regenerateDeleteMoves();
+		adjacentLoops[1]->regenerateDeleteMoves();
 		*returnLoop = newLoop[0];
 		return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 	}
@@ -3084,30 +3267,26 @@ double BulgeLoop::doChoice(Move *move, Loop **returnLoop) {
 void BulgeLoop::generateMoves(void) {
 	double energies[2];
 	int loop, loop2, pt;
-	double tempRate;
-	RateEnv rateEnv;
+	MoveBatch &batch = MoveBatch::local;
 	int bsize = bulgesize[0] + bulgesize[1];
 	int bside = (bulgesize[0] == 0) ? 1 : 0;
 
 // Creation moves
 	if (bsize <= 3) {
-		if (moves != NULL)
-			delete moves;
-
-		moves = new MoveList(0);
-		totalRate = 0.0;
+		moves = MoveContainer::renewContainer(moves, 0);
+		setTotalRate(0.0);
 		generateDeleteMoves();
 		return;
 	} else {
-		if (moves != NULL)
-			delete moves;
-		moves = new MoveList(bsize); // what's the optimal #?
+		moves = MoveContainer::renewContainer(moves, bsize); // what's the optimal #?
+
+		PairMask::Side mask = PairMask::side(energyModel, bulge_seq[bside], bsize);
 
 		// Indice 0 is the starting bulge base. bulgesize+1 is the ending hairpin base. Thus we want to start at hairpin indice 1, and go to hairpinsize - 4. (which could pair to indice hairpinsize)
 		for (loop = 1; loop <= bsize - 4; loop++)
-			for (loop2 = loop + 4; loop2 <= bsize; loop2++) {
+			for (loop2 = mask.next(bulge_seq[bside][loop], loop + 4, bsize); loop2 <= bsize; loop2 = mask.next(bulge_seq[bside][loop], loop2 + 1, bsize)) {
 
-				pt = pairtypes[bulge_seq[bside][loop]][bulge_seq[bside][loop2]];
+				pt = energyModel->pairtypes[(int) bulge_seq[bside][loop]][(int) bulge_seq[bside][loop2]];
 
 				if (pt != 0) { // the two could pair. Work out energies of the resulting pair of loops.
 
@@ -3144,8 +3323,6 @@ void BulgeLoop::generateMoves(void) {
 					// loop2 - loop + 1 is the new hairpin size.
 					energies[1] = energyModel->HairpinEnergy(&bulge_seq[bside][loop], loop2 - loop - 1);
 
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 					// hairpin and multiloop, so this is loopMove and something
 
 					MoveType multiMove = stackMove; // default init value;
@@ -3156,13 +3333,12 @@ void BulgeLoop::generateMoves(void) {
 						multiMove = energyModel->prefactorInternal(sidelen[1], sidelen[2]);
 					}
 
-					rateEnv = RateEnv(tempRate, energyModel, loopMove, multiMove);
-
-					moves->addMove(new Move(MOVE_CREATE, rateEnv, this, loop, loop2));
+					batch.add(energies[0] + energies[1], loopMove, multiMove, MOVE_CREATE, loop, loop2);
 				}
 			}
+		batch.flush(energyModel, getEnergy(), this, moves);
 	}
-	totalRate = moves->getRate();
+	setTotalRate(moves->getRate());
 
 	generateDeleteMoves();
 }
@@ -3176,7 +3352,7 @@ void BulgeLoop::generateDeleteMoves(void) {
 	generateAndSaveDeleteMove(adjacentLoops[0], 0);
 	generateAndSaveDeleteMove(adjacentLoops[1], 1);
 
-	totalRate = moves->getRate();
+	setTotalRate(moves->getRate());
 }
 
 void BulgeLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
@@ -3238,7 +3414,7 @@ char *BulgeLoop::verifyLoop(char *incoming_sequence, Loop *from) {
 
 InteriorLoop::InteriorLoop(void) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 
 	sizes[0] = sizes[1] = 0;
 	int_seq[0] = int_seq[1] = NULL;
@@ -3247,7 +3423,7 @@ InteriorLoop::InteriorLoop(void) {
 
 InteriorLoop::InteriorLoop(int size1, int size2, char *int_seq1, char *int_seq2, Loop *left, Loop *right) {
 	numAdjacent = 2;
-	adjacentLoops = new Loop *[2];
+	adjacentLoops = poolArray<Loop*>(2);
 
 	adjacentLoops[0] = left;
 	adjacentLoops[1] = right;
@@ -3319,8 +3495,8 @@ void InteriorLoop::calculateEnergy(void) {
 double InteriorLoop::doChoice(Move *move, Loop **returnLoop) {
 	Loop *newLoop[2];
 	int loop, loop2;
-	int *sidelen = new int[3];
-	char **seqs = new char *[3];
+	int *sidelen = poolArray<int>(3);
+	char **seqs = poolArray<char*>(3);
 
 	if (move->type & MOVE_CREATE) {
 		if (move->type & MOVE_1) {
@@ -3348,8 +3524,8 @@ double InteriorLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
-			adjacentLoops[0]->generateMoves();
-			adjacentLoops[1]->generateMoves();
+			adjacentLoops[0]->regenerateDeleteMoves();
+			adjacentLoops[1]->regenerateDeleteMoves();
 			*returnLoop = newLoop[0];
 			return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 		}
@@ -3379,8 +3555,8 @@ double InteriorLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
-			adjacentLoops[0]->generateMoves();
-			adjacentLoops[1]->generateMoves();
+			adjacentLoops[0]->regenerateDeleteMoves();
+			adjacentLoops[1]->regenerateDeleteMoves();
 			*returnLoop = newLoop[0];
 			return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 		} else if (move->type & MOVE_3) {
@@ -3421,21 +3597,21 @@ double InteriorLoop::doChoice(Move *move, Loop **returnLoop) {
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
 
-			adjacentLoops[0]->generateMoves();
-			adjacentLoops[1]->generateMoves();
+			adjacentLoops[0]->regenerateDeleteMoves();
+			adjacentLoops[1]->regenerateDeleteMoves();
 
 			*returnLoop = newLoop[0];
 
-			delete[] seqs;
-			delete[] sidelen;
+			releaseArray(seqs);
+			releaseArray(sidelen);
 			return ((newLoop[0]->getTotalRate() + newLoop[1]->getTotalRate()) - totalRate);
 		} else {
-			delete[] seqs;
-			delete[] sidelen;
+			releaseArray(seqs);
+			releaseArray(sidelen);
 		}
 	} else {
-		delete[] seqs;
-		delete[] sidelen;
+		releaseArray(seqs);
+		releaseArray(sidelen);
 	}
 	return -totalRate;
 }
@@ -3444,8 +3620,7 @@ void InteriorLoop::generateMoves(void) {
 	double energies[2];
 	int pt = 0;
 	int loop, loop2;
-	double tempRate = 0;
-	RateEnv rateEnv;
+	MoveBatch &batch = MoveBatch::local;
 
 	int nummoves = sizes[0] * sizes[1];
 	if (sizes[0] > 4)
@@ -3457,9 +3632,9 @@ void InteriorLoop::generateMoves(void) {
 	nummoves = (int) ((sizes[0] * sizes[1]) / 16 + 1);
 
 // Creation moves
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(nummoves);
+	moves = MoveContainer::renewContainer(moves, nummoves);
+
+	PairMask::Side *masks = PairMask::sides(energyModel, int_seq, sizes, 2);
 
 // three loops here, the first is only side 0's possible creation moves
 //                   the second is only side 1's possible creation moves
@@ -3468,9 +3643,9 @@ void InteriorLoop::generateMoves(void) {
 // Loop #1: Side 0 only Creation Moves
 	for (loop = 1; loop <= sizes[0] - 4; loop++) {
 
-		for (loop2 = loop + 4; loop2 <= sizes[0]; loop2++) { // each possibility will always result in a new hairpin + multiloop.
+		for (loop2 = masks[0].next(int_seq[0][loop], loop + 4, sizes[0]); loop2 <= sizes[0]; loop2 = masks[0].next(int_seq[0][loop], loop2 + 1, sizes[0])) { // each possibility will always result in a new hairpin + multiloop.
 
-			pt = pairtypes[int_seq[0][loop]][int_seq[0][loop2]];
+			pt = energyModel->pairtypes[(int) int_seq[0][loop]][(int) int_seq[0][loop2]];
 
 			if (pt != 0) {
 				energies[0] = energyModel->HairpinEnergy(&int_seq[0][loop], loop2 - loop - 1);
@@ -3480,22 +3655,19 @@ void InteriorLoop::generateMoves(void) {
 				char *sequences[3] = { &int_seq[0][0], &int_seq[0][loop2], &int_seq[1][0] };
 
 				energies[1] = energyModel->MultiloopEnergy(3, sidelen, sequences);
-				tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 //				// hairpin and multiloop, so this is loopMove and something
 
 				MoveType multiMove = energyModel->prefactorInternal(sidelen[0], sidelen[1]);
-				rateEnv = RateEnv(tempRate, energyModel, multiMove, loopMove);
-
-				moves->addMove(new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2));
+				batch.add(energies[0] + energies[1], multiMove, loopMove, MOVE_CREATE | MOVE_1, loop, loop2);
 			}
 		}
 	}
 
 // Loop #2: Side 1 only Creation Moves
 	for (loop = 1; loop <= sizes[1] - 4; loop++)
-		for (loop2 = loop + 4; loop2 <= sizes[1]; loop2++) { // each possibility will always result in a new hairpin + multiloop.
-			pt = pairtypes[int_seq[1][loop]][int_seq[1][loop2]];
+		for (loop2 = masks[1].next(int_seq[1][loop], loop + 4, sizes[1]); loop2 <= sizes[1]; loop2 = masks[1].next(int_seq[1][loop], loop2 + 1, sizes[1])) { // each possibility will always result in a new hairpin + multiloop.
+			pt = energyModel->pairtypes[(int) int_seq[1][loop]][(int) int_seq[1][loop2]];
 			if (pt != 0) {
 				energies[0] = energyModel->HairpinEnergy(&int_seq[1][loop], loop2 - loop - 1);
 
@@ -3504,23 +3676,20 @@ void InteriorLoop::generateMoves(void) {
 				char *sequences[3] = { &int_seq[0][0], &int_seq[1][0], &int_seq[1][loop2] };
 
 				energies[1] = energyModel->MultiloopEnergy(3, sidelen, sequences);
-				tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
 
 				// hairpin and multiloop, so this is loopMove and something
 
 				MoveType multiMove = energyModel->prefactorInternal(sidelen[1], sidelen[2]);
-				rateEnv = RateEnv(tempRate, energyModel, loopMove, multiMove);
-
-				moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2));
+				batch.add(energies[0] + energies[1], loopMove, multiMove, MOVE_CREATE | MOVE_2, loop, loop2);
 			}
 		}
 
 // Loop #3: Side 0 to Side 1 crossing moves ONLY
 
 	for (loop = 1; loop <= sizes[0]; loop++)
-		for (loop2 = 1; loop2 <= sizes[1]; loop2++) {
+		for (loop2 = masks[1].next(int_seq[0][loop], 1, sizes[1]); loop2 <= sizes[1]; loop2 = masks[1].next(int_seq[0][loop], loop2 + 1, sizes[1])) {
 
-			pt = pairtypes[int_seq[0][loop]][int_seq[1][loop2]];
+			pt = energyModel->pairtypes[(int) int_seq[0][loop]][(int) int_seq[1][loop2]];
 			if (pt != 0) {
 				// Need to check conditions for each side in order to determine what the two new loops types would be.
 				// adjacent to first pair side:
@@ -3551,17 +3720,14 @@ void InteriorLoop::generateMoves(void) {
 					rightMove = loopMove;
 				}
 
-				tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-
 				// interior loop is closing, so this could be anything.
-				rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-
-				moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loop, loop2));
+				batch.add(energies[0] + energies[1], leftMove, rightMove, MOVE_CREATE | MOVE_3, loop, loop2);
 			}
 		}
 
 // totaling the rate
-	totalRate = moves->getRate();
+	batch.flush(energyModel, getEnergy(), this, moves);
+	setTotalRate(moves->getRate());
 
 // Shift moves
 
@@ -3578,7 +3744,7 @@ void InteriorLoop::generateDeleteMoves(void) {
 	generateAndSaveDeleteMove(adjacentLoops[0], 0);
 	generateAndSaveDeleteMove(adjacentLoops[1], 1);
 
-	totalRate = moves->getRate();
+	setTotalRate(moves->getRate());
 
 }
 
@@ -3652,7 +3818,7 @@ MultiLoop::MultiLoop(void) {
 
 MultiLoop::MultiLoop(int branches, int *sidelengths, char **sequences) {
 	numAdjacent = branches;
-	adjacentLoops = new Loop *[branches];
+	adjacentLoops = poolArray<Loop*>(branches);
 	for (int loop = 0; loop < branches; loop++) {
 		adjacentLoops[loop] = NULL;
 	}
@@ -3663,8 +3829,8 @@ MultiLoop::MultiLoop(int branches, int *sidelengths, char **sequences) {
 
 MultiLoop::~MultiLoop(void) {
 
-	delete[] sidelen;
-	delete[] seqs;
+	releaseArray(sidelen);
+	releaseArray(seqs);
 
 }
 
@@ -3694,7 +3860,7 @@ Move *MultiLoop::getChoice(double* randomchoice, Loop *from) {
 	assert(*randomchoice >= 0.0); // never should see a negative choice value.
 
 	if (*randomchoice < totalRate) // something was chosen, do this
-		return moves->getChoice(randomchoice);
+		return getLocalChoice(randomchoice);
 	else {
 		*randomchoice -= totalRate;
 		for (int loop = 0; loop < curAdjacent; loop++)
@@ -3730,10 +3896,10 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 
 		if (move->type & MOVE_1) {
 			//single side, hairpin + multi with 1 higher mag.
-			sidelengths = new int[numAdjacent + 1];
-			sequences = new char *[numAdjacent + 1];
+			sidelengths = poolArray<int>(numAdjacent + 1);
+			sequences = poolArray<char*>(numAdjacent + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop3][loop2]];
+			pt = energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop3][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop < numAdjacent + 1; temploop++, tempindex++) {
 				if (temploop == loop3) {
@@ -3756,12 +3922,12 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 				if (temploop == loop3) {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 					newLoop[0]->addAdjacent(newLoop[1]);
 				} else {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				}
 			}
 
@@ -3777,11 +3943,11 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 			//adjacent sides, one of: stack    + multi with same mag
 			//                        bulge    + multi with same mag
 			//                        interior + multi with same mag
-			sidelengths = new int[numAdjacent];
-			sequences = new char *[numAdjacent];
+			sidelengths = poolArray<int>(numAdjacent);
+			sequences = poolArray<char*>(numAdjacent);
 
 			loop4 = (loop3 + 1) % numAdjacent;
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			pt = energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop4][loop2]];
 			for (temploop = 0; temploop < numAdjacent; temploop++) {
 				if (temploop == loop3) {
 					sidelengths[temploop] = loop - 1;
@@ -3828,7 +3994,7 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 				} else {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				}
 			}
 
@@ -3840,7 +4006,7 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 				newLoop[1]->addAdjacent(newLoop[0]);
 			}
 			adjacentLoops[loop4]->replaceAdjacent(this, newLoop[1]);
-			adjacentLoops[loop4]->generateMoves();
+			adjacentLoops[loop4]->regenerateDeleteMoves();
 
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
@@ -3852,10 +4018,10 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 		if (move->type & MOVE_3) {
 			//non-adjacent sides, multi + open loop
 
-			sidelengths = new int[loop4 - loop3 + 1];
-			sequences = new char *[loop4 - loop3 + 1];
+			sidelengths = poolArray<int>(loop4 - loop3 + 1);
+			sequences = poolArray<char*>(loop4 - loop3 + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			pt = energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop4][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
 					{
@@ -3878,8 +4044,8 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			newLoop[0] = new MultiLoop(loop4 - loop3 + 1, sidelengths, sequences);
 
-			sidelengths = new int[numAdjacent - (loop4 - loop3 - 1)];
-			sequences = new char *[numAdjacent - (loop4 - loop3 - 1)];
+			sidelengths = poolArray<int>(numAdjacent - (loop4 - loop3 - 1));
+			sequences = poolArray<char*>(numAdjacent - (loop4 - loop3 - 1));
 
 			for (temploop = 0, tempindex = 0; temploop < numAdjacent - (loop4 - loop3 - 1); tempindex++) {
 				if (tempindex == loop3) {
@@ -3904,22 +4070,22 @@ double MultiLoop::doChoice(Move *move, Loop **returnLoop) {
 				if (temploop < loop3) {
 					newLoop[1]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[1]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				} else if (temploop == loop3) {
 					newLoop[1]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[1]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 					newLoop[1]->addAdjacent(newLoop[0]);
 					newLoop[0]->addAdjacent(newLoop[1]);
 
 				} else if (temploop <= loop4) {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				} else {
 					newLoop[1]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[1]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				}
 			}
 
@@ -3939,15 +4105,12 @@ void MultiLoop::generateMoves(void) {
 		cout << "Multiloop generating moves!" << endl;
 	}
 
-	int loop, loop2, loop3, loop4, temploop, tempindex, loops[4];
-	int pt;
-	double tempRate;
-	RateEnv rateEnv;
-	double energies[2];
+	int loop, loop2, loop3, loop4;
+	MoveBatch &batch = MoveBatch::local;
 
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(sidelen[0] + 1);
+	moves = MoveContainer::renewContainer(moves, sidelen[0] + 1);
+	if (lazyMoves != NULL)
+		lazyMoves->clear();
 // This is almost identical to OpenLoop::generateMoves, which was written first.
 //  Several options here:
 //     #1: creation move within a side this results in a hairpin and a multi loop with 1 greater magnitude.
@@ -3956,226 +4119,259 @@ void MultiLoop::generateMoves(void) {
 //     #2c: creation move between sides resulting in a interior loop and multi loop
 //     #3: creation move between sides resulting in two multiloops.
 // #2a-#2c can only happen for adjacent sides, #3 only happens for non-adjacent sides (and is always the case for such). We separate these into cases #2a-#2c and #3 .
+// The moves themselves are made by addCreationMove; as for open loops, sides with many
+// possible pairs keep their moves in groups instead.
 
 // these pointers are needed to set up all of the multiloop energy calls.
 	int *sideLengths = NULL;
 	char **sequences = NULL;
 
 // the most storage we'll need is for case #1, which will have a multiloop of 1 greater magnitude.
-	sideLengths = new int[numAdjacent + 1];
-	sequences = new char *[numAdjacent + 1];
+	sideLengths = poolArray<int>(numAdjacent + 1);
+	sequences = poolArray<char*>(numAdjacent + 1);
+
+	PairMask::Side *masks = PairMask::sides(energyModel, seqs, sidelen, numAdjacent);
 
 // Case #1: Single Side only Creation Moves
 	for (loop3 = 0; loop3 < numAdjacent; loop3++) {
-		for (loop = 1; loop <= sidelen[loop3] - 4; loop++) {
-			for (loop2 = loop + 4; loop2 <= sidelen[loop3]; loop2++) { // each possibility is a hairpin and multiloop, see above.
 
-				//FD: loop3 is the strand that will split.
-				//FD: loop and loop2 are the nucleotide indices.
-				//FD: Loop2 - loop is at least 4, e.g. this is the hairpin length.
-				//FD: the length of the right-side remaining loop is sidelen[loop3]-loop2;
+		if (groupCreationMoves((long) (sidelen[loop3] - 3) * (sidelen[loop3] - 4) / 2)) {
+			addCreationGroups(false, sidelen, seqs, loop3, loop3);
+			continue;
+		}
 
-				pt = pairtypes[seqs[loop3][loop]][seqs[loop3][loop2]];
+		for (loop = 1; loop <= sidelen[loop3] - 4; loop++) {
+			for (loop2 = masks[loop3].next(seqs[loop3][loop], loop + 4, sidelen[loop3]); loop2 <= sidelen[loop3];
+					loop2 = masks[loop3].next(seqs[loop3][loop], loop2 + 1, sidelen[loop3])) { // each possibility is a hairpin and multiloop, see above.
 
-				if (pt != 0) {
+				addCreationMove(loop3, loop, loop3, loop2, sideLengths, sequences, batch);
+			}
+		}
+	}
 
-					energies[0] = energyModel->HairpinEnergy(&seqs[loop3][loop], loop2 - loop - 1);
+// Case #2a-c: adjacent loop creation moves
+	for (loop3 = 0; loop3 <= numAdjacent - 1; loop3++) { // CHECK: is numAdjacent really correct? it could be numAdjacent+1
+		loop4 = (loop3 + 1) % numAdjacent;
 
-					for (temploop = 0, tempindex = 0; temploop < numAdjacent + 1; temploop++, tempindex++) {
-						if (temploop == loop3) {
+		if (groupCreationMoves((long) sidelen[loop3] * sidelen[loop4])) {
+			addCreationGroups(false, sidelen, seqs, loop3, loop4);
+			continue;
+		}
 
-							sideLengths[temploop] = loop - 1;
-							sequences[temploop] = seqs[temploop];
-							sideLengths[temploop + 1] = sidelen[temploop] - loop2;
-							sequences[temploop + 1] = &seqs[temploop][loop2];
+		for (loop = 1; loop <= sidelen[loop3]; loop++) {
+			for (loop2 = masks[loop4].next(seqs[loop3][loop], 1, sidelen[loop4]); loop2 <= sidelen[loop4];
+					loop2 = masks[loop4].next(seqs[loop3][loop], loop2 + 1, sidelen[loop4])) { // each possibility is a hairpin and open loop, see above.
 
-							// FD: This places an additional side to the multiloop.
-							// FD: The left-side retains loop3 location, the right-side is now indexed at loop3+1.
+				addCreationMove(loop3, loop, loop4, loop2, sideLengths, sequences, batch);
+			}
+		}
+	}
 
-							temploop = temploop + 1;
+// FIXME 01/17/05 JS - This appears to be directly copied from the openloop section - the second half always refers to openloops, not multi as should be expected... Needs checking. RESOLVED 01/17/05 This is now updated to be exactly appropriate to the multiloop case.
 
-						} else {
+// Case #3: non-adjacent loop creation moves (2d)
+// Revamped so it actually works. Algorithm follows:
+// This is all connections between non-adjacent sides. Thus we must exclude adjacent sides, and must try all possible combinations which match. This means we have to cover ~n^2 side combinations, where n is the total number of sides. Note that in this data structure, n is numAdjacent+1, and they are labelled 0,1,...,numAdjacent
+// Loop over all sides. Within this loop, cover all sides that are labelled higher that the first, and are non adjacent. For each pair of bases in these two sides, check whether they can pair. For each pair, compute energies and add move to list.
+	for (loop3 = 0; loop3 < numAdjacent - 2; loop3++) { // The last 2 entries are not needed as neither have higher numbered non-adjacent sections.
 
-							sideLengths[temploop] = sidelen[tempindex];
-							sequences[temploop] = seqs[tempindex];
+		for (loop4 = loop3 + 2; (loop4 < numAdjacent) && (loop3 != 0 || loop4 < numAdjacent - 1); loop4++) {
 
-						}
-					}
-					energies[1] = energyModel->MultiloopEnergy(numAdjacent + 1, sideLengths, sequences);
+			// Loop3, loop4 are the selected strands that will form a new base-pair.
 
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
+			if (groupCreationMoves((long) sidelen[loop3] * sidelen[loop4])) {
+				addCreationGroups(false, sidelen, seqs, loop3, loop4);
+				continue;
+			}
 
-					// multiLoop is closing, so this an loopMove and something else
-					MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop3]);
+			for (loop = 1; loop <= sidelen[loop3]; loop++) {
 
-					rateEnv = RateEnv(tempRate, energyModel, loopMove, rightMove);
+				for (loop2 = masks[loop4].next(seqs[loop3][loop], 1, sidelen[loop4]); loop2 <= sidelen[loop4];
+						loop2 = masks[loop4].next(seqs[loop3][loop], loop2 + 1, sidelen[loop4])) {
 
-					moves->addMove(new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2, loop3));
+					addCreationMove(loop3, loop, loop4, loop2, sideLengths, sequences, batch);
 				}
 			}
 		}
 	}
 
-// Case #2a-c: adjacent loop creation moves
-	for (loop3 = 0; loop3 <= numAdjacent - 1; loop3++) { // CHECK: is numAdjacent really correct? it could be numAdjacent+1
-		for (loop = 1; loop <= sidelen[loop3]; loop++) {
-			for (loop2 = 1; loop2 <= sidelen[(loop3 + 1) % numAdjacent]; loop2++) { // each possibility is a hairpin and open loop, see above.
-				loop4 = (loop3 + 1) % numAdjacent;
-
-				pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+	batch.flush(energyModel, getEnergy(), this, moves);
+	setTotalRate(getLocalRate());
+	if (sideLengths != NULL)
+		releaseArray(sideLengths);
+	if (sequences != NULL)
+		releaseArray(sequences);
 
-				if (pt != 0) {
+	generateDeleteMoves();
+}
 
-					MoveType leftMove = stackMove;
+bool MultiLoop::addCreationMove(int side1, int pos1, int side2, int pos2, int *sideLengths, char **sequences, MoveBatch &batch) {
 
-					// three cases for which type of move:
-					// #2a: stack
-					if (loop == sidelen[loop3] && loop2 == 1) {
+	int loop = pos1, loop2 = pos2, loop3 = side1, loop4 = side2;
+	int temploop, tempindex;
+	double energies[2];
 
-						energies[0] = energyModel->StackEnergy(seqs[loop3][loop], seqs[loop4][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop4][0]);
+	if (energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop4][loop2]] == 0)
+		return false;
 
-					} else if (loop == sidelen[loop3] || loop2 == 1) { 			// #2b: bulge
+	bool scratch = (sideLengths == NULL);
 
-						if (loop2 == 1) {
-							energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop4][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop4][0],
-									sidelen[loop3] - loop);
-						} else {
-							energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop4][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop4][0],
-									loop2 - 1);
-						}
+	if (scratch) {
+		sideLengths = poolArray<int>(numAdjacent + 1);
+		sequences = poolArray<char*>(numAdjacent + 1);
+	}
 
-						leftMove = stackLoopMove;
+	if (loop3 == loop4) {
 
-					} else {				 					// #2c: interior
+		// loop3 is the strand that will split.
+		// loop and loop2 are the nucleotide indices.
+		// Loop2 - loop is at least 4, e.g. this is the hairpin length.
+		// the length of the right-side remaining loop is sidelen[loop3]-loop2;
 
-						energies[0] = energyModel->InteriorEnergy(&seqs[loop3][loop], seqs[loop4], sidelen[loop3] - loop, loop2 - 1);
-						leftMove = loopMove;
+		energies[0] = energyModel->HairpinEnergy(&seqs[loop3][loop], loop2 - loop - 1);
 
-					}
+		for (temploop = 0, tempindex = 0; temploop < numAdjacent + 1; temploop++, tempindex++) {
+			if (temploop == loop3) {
 
-					for (temploop = 0; temploop < numAdjacent; temploop++) {
-						if (temploop == loop3) {
-							//FD: This is computing the sideLengths for the remaining loops.
+				sideLengths[temploop] = loop - 1;
+				sequences[temploop] = seqs[temploop];
+				sideLengths[temploop + 1] = sidelen[temploop] - loop2;
+				sequences[temploop + 1] = &seqs[temploop][loop2];
 
-							sideLengths[temploop] = loop - 1;
-							sequences[temploop] = seqs[temploop];
+				// This places an additional side to the multiloop.
+				// The left-side retains loop3 location, the right-side is now indexed at loop3+1.
 
-						} else {
+				temploop = temploop + 1;
 
-							if (temploop == loop4) {
-								sideLengths[temploop] = sidelen[temploop] - loop2;
-								sequences[temploop] = &seqs[temploop][loop2];
-							} else {
-								sideLengths[temploop] = sidelen[temploop];
-								sequences[temploop] = seqs[temploop];
-							}
-						}
-					}
-					energies[1] = energyModel->MultiloopEnergy(numAdjacent, sideLengths, sequences);
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
+			} else {
 
-					// multiLoop is forming an stack/bulge/interior, which is something and something else
-					MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+				sideLengths[temploop] = sidelen[tempindex];
+				sequences[temploop] = seqs[tempindex];
 
-					rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-					moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2, loop3));
-				}
 			}
 		}
-	}
+		energies[1] = energyModel->MultiloopEnergy(numAdjacent + 1, sideLengths, sequences);
 
-// FIXME 01/17/05 JS - This appears to be directly copied from the openloop section - the second half always refers to openloops, not multi as should be expected... Needs checking. RESOLVED 01/17/05 This is now updated to be exactly appropriate to the multiloop case.
+		// multiLoop is closing, so this an loopMove and something else
+		MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop3]);
 
-// Case #3: non-adjacent loop creation moves (2d)
-// Revamped so it actually works. Algorithm follows:
-// This is all connections between non-adjacent sides. Thus we must exclude adjacent sides, and must try all possible combinations which match. This means we have to cover ~n^2 side combinations, where n is the total number of sides. Note that in this data structure, n is numAdjacent+1, and they are labelled 0,1,...,numAdjacent
-// Loop over all sides. Within this loop, cover all sides that are labelled higher that the first, and are non adjacent. For each pair of bases in these two sides, check whether they can pair. For each pair, compute energies and add move to list.
-	for (loop3 = 0; loop3 < numAdjacent - 2; loop3++) { // The last 2 entries are not needed as neither have higher numbered non-adjacent sections.
-
-		for (loop4 = loop3 + 2; (loop4 < numAdjacent) && (loop3 != 0 || loop4 < numAdjacent - 1); loop4++) {
+		batch.add(energies[0] + energies[1], loopMove, rightMove, MOVE_CREATE | MOVE_1, loop, loop2, loop3);
 
-			// FD: Loop3, loop4 are the selected strands that will form a new base-pair.
+	} else if (loop4 == (loop3 + 1) % numAdjacent) {
 
-			for (loop = 1; loop <= sidelen[loop3]; loop++) {
+		MoveType leftMove = stackMove;
 
-				for (loop2 = 1; loop2 <= sidelen[loop4]; loop2++) {
+		// three cases for which type of move:
+		// #2a: stack
+		if (loop == sidelen[loop3] && loop2 == 1) {
 
-					pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			energies[0] = energyModel->StackEnergy(seqs[loop3][loop], seqs[loop4][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop4][0]);
 
-					if (pt != 0) { // result is a multiloop and multi loop.
-								   // Multiloop
+		} else if (loop == sidelen[loop3] || loop2 == 1) { 			// #2b: bulge
 
-						for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
-								{
-							if (tempindex == loop3) {
-								sideLengths[temploop] = sidelen[tempindex] - loop;
-								sequences[temploop] = &seqs[tempindex][loop];
-								temploop++;
-							}
+			if (loop2 == 1) {
+				energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop4][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop4][0],
+						sidelen[loop3] - loop);
+			} else {
+				energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop4][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop4][0],
+						loop2 - 1);
+			}
 
-							if (tempindex > loop3 && tempindex < loop4) {
-								sideLengths[temploop] = sidelen[tempindex];
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							}
+			leftMove = stackLoopMove;
 
-							if (tempindex == loop4) {
-								sideLengths[temploop] = loop2 - 1;
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							}
-						}
+		} else {				 					// #2c: interior
 
-						energies[0] = energyModel->MultiloopEnergy(loop4 - loop3 + 1, sideLengths, sequences);
-						MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
-
-						// Multi loop
-						for (temploop = 0, tempindex = 0; temploop < numAdjacent - (loop4 - loop3 - 1); tempindex++) {
-							if (tempindex == loop3) {
-								sideLengths[temploop] = loop - 1;
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							} else if (tempindex == loop4) {
-								sideLengths[temploop] = sidelen[tempindex] - loop2;
-								sequences[temploop] = &seqs[tempindex][loop2];
-								temploop++;
-							} else if (!((tempindex > loop3) && (tempindex < loop4))) {
-								sideLengths[temploop] = sidelen[tempindex];
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							}
+			energies[0] = energyModel->InteriorEnergy(&seqs[loop3][loop], seqs[loop4], sidelen[loop3] - loop, loop2 - 1);
+			leftMove = loopMove;
 
-						}
-						energies[1] = energyModel->MultiloopEnergy(numAdjacent - (loop4 - loop3 - 1), sideLengths, sequences);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
-						loops[0] = loop;
-						loops[1] = loop2;
-						loops[2] = loop3;
-						loops[3] = loop4;
+		}
 
-						// multiLoop is splitting into two multiLoops. Which is something, and something else
+		for (temploop = 0; temploop < numAdjacent; temploop++) {
+			if (temploop == loop3) {
+				// This is computing the sideLengths for the remaining loops.
 
-						MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+				sideLengths[temploop] = loop - 1;
+				sequences[temploop] = seqs[temploop];
 
-						rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-						moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loops));
-					}
+			} else {
 
+				if (temploop == loop4) {
+					sideLengths[temploop] = sidelen[temploop] - loop2;
+					sequences[temploop] = &seqs[temploop][loop2];
+				} else {
+					sideLengths[temploop] = sidelen[temploop];
+					sequences[temploop] = seqs[temploop];
 				}
+			}
+		}
+		energies[1] = energyModel->MultiloopEnergy(numAdjacent, sideLengths, sequences);
+
+		// multiLoop is forming an stack/bulge/interior, which is something and something else
+		MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+
+		batch.add(energies[0] + energies[1], leftMove, rightMove, MOVE_CREATE | MOVE_2, loop, loop2, loop3);
+
+	} else {
+
+		// result is a multiloop and multi loop.
+		// Multiloop
+
+		for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
+				{
+			if (tempindex == loop3) {
+				sideLengths[temploop] = sidelen[tempindex] - loop;
+				sequences[temploop] = &seqs[tempindex][loop];
+				temploop++;
+			}
 
+			if (tempindex > loop3 && tempindex < loop4) {
+				sideLengths[temploop] = sidelen[tempindex];
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
 			}
 
+			if (tempindex == loop4) {
+				sideLengths[temploop] = loop2 - 1;
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
+			}
 		}
 
+		energies[0] = energyModel->MultiloopEnergy(loop4 - loop3 + 1, sideLengths, sequences);
+		MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+
+		// Multi loop
+		for (temploop = 0, tempindex = 0; temploop < numAdjacent - (loop4 - loop3 - 1); tempindex++) {
+			if (tempindex == loop3) {
+				sideLengths[temploop] = loop - 1;
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
+			} else if (tempindex == loop4) {
+				sideLengths[temploop] = sidelen[tempindex] - loop2;
+				sequences[temploop] = &seqs[tempindex][loop2];
+				temploop++;
+			} else if (!((tempindex > loop3) && (tempindex < loop4))) {
+				sideLengths[temploop] = sidelen[tempindex];
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
+			}
+
+		}
+		energies[1] = energyModel->MultiloopEnergy(numAdjacent - (loop4 - loop3 - 1), sideLengths, sequences);
+
+		// multiLoop is splitting into two multiLoops. Which is something, and something else
+
+		MoveType rightMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+
+		batch.add(energies[0] + energies[1], leftMove, rightMove, MOVE_CREATE | MOVE_3, loop, loop2, loop3, loop4);
 	}
 
-	totalRate = moves->getRate();
-	if (sideLengths != NULL)
-		delete[] sideLengths;
-	if (sequences != NULL)
-		delete[] sequences;
+	if (scratch) {
+		releaseArray(sideLengths);
+		releaseArray(sequences);
+	}
 
-	generateDeleteMoves();
+	return true;
 }
 
 void MultiLoop::generateDeleteMoves(void) {
@@ -4189,7 +4385,7 @@ void MultiLoop::generateDeleteMoves(void) {
 
 	}
 
-	totalRate = moves->getRate();
+	setTotalRate(getLocalRate());
 }
 
 void MultiLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
@@ -4263,8 +4459,8 @@ OpenLoop::OpenLoop(void) {
 }
 
 OpenLoop::~OpenLoop(void) {
-	delete[] sidelen;
-	delete[] seqs;
+	releaseArray(sidelen);
+	releaseArray(seqs);
 }
 
 OpenLoop::OpenLoop(int branches, int *sidelengths, char **sequences) {
@@ -4273,7 +4469,7 @@ OpenLoop::OpenLoop(int branches, int *sidelengths, char **sequences) {
 
 	if (branches > 0) {
 
-		adjacentLoops = new Loop *[branches];
+		adjacentLoops = poolArray<Loop*>(branches);
 		for (int loop = 0; loop < branches; loop++) {
 			adjacentLoops[loop] = NULL;
 		}
@@ -4328,7 +4524,7 @@ Move *OpenLoop::getChoice(double *randomchoice, Loop *from) {
 	assert(*randomchoice >= 0.0); // never should see a negative choice value.
 
 	if (*randomchoice < totalRate) { // something was chosen, do this
-		return moves->getChoice(randomchoice);
+		return getLocalChoice(randomchoice);
 	} else {
 		*randomchoice -= totalRate;
 		for (int loop = 0; loop < curAdjacent; loop++) {
@@ -4356,10 +4552,10 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 
 		if (move->type & MOVE_1) {
 			//single side, hairpin + open with 1 higher mag.
-			sidelengths = new int[numAdjacent + 2];
-			sequences = new char *[numAdjacent + 2];
+			sidelengths = poolArray<int>(numAdjacent + 2);
+			sequences = poolArray<char*>(numAdjacent + 2);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop3][loop2]];
+			pt = energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop3][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop <= numAdjacent + 1; temploop++, tempindex++) {
 				if (temploop == loop3) {
@@ -4383,11 +4579,11 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 					newLoop[0]->addAdjacent(newLoop[1]);
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				} else {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				}
 			}
 			if (temploop == loop3)
@@ -4405,10 +4601,10 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 			//adjacent sides, one of: stack    + open with same mag
 			//                        bulge    + open with same mag
 			//                        interior + open with same mag
-			sidelengths = new int[numAdjacent + 1];
-			sequences = new char *[numAdjacent + 1];
+			sidelengths = poolArray<int>(numAdjacent + 1);
+			sequences = poolArray<char*>(numAdjacent + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop3 + 1][loop2]];
+			pt = energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop3 + 1][loop2]];
 
 			for (temploop = 0; temploop <= numAdjacent; temploop++) {
 				if (temploop == loop3) {
@@ -4450,14 +4646,14 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 				} else {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				}
 			}
 
 			newLoop[1]->addAdjacent(newLoop[0]);
 			newLoop[1]->addAdjacent(adjacentLoops[loop3]);
 			adjacentLoops[loop3]->replaceAdjacent(this, newLoop[1]);
-			adjacentLoops[loop3]->generateMoves();
+			adjacentLoops[loop3]->regenerateDeleteMoves();
 
 			newLoop[0]->generateMoves();
 			newLoop[1]->generateMoves();
@@ -4469,10 +4665,10 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 		if (move->type & MOVE_3) {
 			//non-adjacent sides, multi + open loop
 
-			sidelengths = new int[loop4 - loop3 + 1];
-			sequences = new char *[loop4 - loop3 + 1];
+			sidelengths = poolArray<int>(loop4 - loop3 + 1);
+			sequences = poolArray<char*>(loop4 - loop3 + 1);
 
-			pt = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
+			pt = energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop4][loop2]];
 
 			for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
 					{
@@ -4495,8 +4691,8 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 
 			newLoop[0] = new MultiLoop(loop4 - loop3 + 1, sidelengths, sequences);
 
-			sidelengths = new int[numAdjacent - (loop4 - loop3 - 1) + 1];
-			sequences = new char *[numAdjacent - (loop4 - loop3 - 1) + 1];
+			sidelengths = poolArray<int>(numAdjacent - (loop4 - loop3 - 1) + 1);
+			sequences = poolArray<char*>(numAdjacent - (loop4 - loop3 - 1) + 1);
 
 			for (temploop = 0, tempindex = 0; temploop <= numAdjacent - (loop4 - loop3 - 1); tempindex++) {
 				if (tempindex == loop3) {
@@ -4521,21 +4717,21 @@ double OpenLoop::doChoice(Move *move, Loop **returnLoop) {
 				if (temploop < loop3) {
 					newLoop[1]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[1]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				} else if (temploop == loop3) {
 					newLoop[1]->addAdjacent(newLoop[0]);
 					newLoop[0]->addAdjacent(newLoop[1]);
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				} else if (temploop < loop4) {
 					newLoop[0]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[0]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				} else {
 					newLoop[1]->addAdjacent(adjacentLoops[temploop]);
 					adjacentLoops[temploop]->replaceAdjacent(this, newLoop[1]);
-					adjacentLoops[temploop]->generateMoves();
+					adjacentLoops[temploop]->regenerateDeleteMoves();
 				}
 			}
 
@@ -4556,15 +4752,13 @@ void OpenLoop::generateMoves(void) {
 		cout << this->typeInternalsToString();
 	}
 
-	int loop, loop2, loop3, loop4, temploop, tempindex, loops[4];
-	int pairType;
-	double tempRate;
-	RateEnv rateEnv;
-	double energies[2];
+	int loop, loop2, loop3, loop4;
+	MoveBatch &batch = MoveBatch::local;
+
+	moves = MoveContainer::renewContainer(moves, 1);
+	if (lazyMoves != NULL)
+		lazyMoves->clear();
 
-	if (moves != NULL)
-		delete moves;
-	moves = new MoveList(1);
 //  Several options here:
 //     #1: creation move within a side this results in a hairpin and a open loop with 1 greater magnitude.
 //     #2a: creation move between sides resulting in a stack and open loop
@@ -4572,6 +4766,8 @@ void OpenLoop::generateMoves(void) {
 //     #2c: creation move between sides resulting in a interior loop and open loop
 //     #2d: creation move between sides resulting in a multiloop and open loop. (ICK).
 // #2a-#2c can only happen for adjacent sides, #2d only happens for non-adjacent sides (and is always the case for such). We separate these into cases #2 (#2a-#2c) and #3 (#2d).
+// The moves themselves are made by addCreationMove. Sides (or pairs of sides) with many
+// possible pairs keep their moves in groups instead, see LazyMoves.
 
 // these three pointers are needed to set up the open loop's energy calls.
 // i'd like to optimize so they don't need to be created/deleted very often
@@ -4580,206 +4776,238 @@ void OpenLoop::generateMoves(void) {
 	int *sideLengths = NULL;
 	char **sequences = NULL;
 
-	sideLengths = new int[numAdjacent + 2];
-	sequences = new char *[numAdjacent + 2];
+	sideLengths = poolArray<int>(numAdjacent + 2);
+	sequences = poolArray<char*>(numAdjacent + 2);
+
+	PairMask::Side *masks = PairMask::sides(energyModel, seqs, sidelen, numAdjacent + 1);
 
 // Case #1: Single Side only Creation Moves
 	for (loop3 = 0; loop3 < numAdjacent + 1; loop3++) {
 
-		char* mySequence = seqs[loop3]; // this is the sequence of the strand that we use
+		if (groupCreationMoves((long) (sidelen[loop3] - 3) * (sidelen[loop3] - 4) / 2)) {
+			addCreationGroups(true, sidelen, seqs, loop3, loop3);
+			continue;
+		}
 
 		for (loop = 1; loop < sidelen[loop3] - 3; loop++) {
 
-			for (loop2 = loop + 4; loop2 <= sidelen[loop3]; loop2++) { // each possibility is a hairpin and open loop, see above.
+			for (loop2 = masks[loop3].next(seqs[loop3][loop], loop + 4, sidelen[loop3]); loop2 <= sidelen[loop3];
+					loop2 = masks[loop3].next(seqs[loop3][loop], loop2 + 1, sidelen[loop3])) { // each possibility is a hairpin and open loop, see above.
 
-				pairType = pairtypes[mySequence[loop]][mySequence[loop2]];
+				addCreationMove(loop3, loop, loop3, loop2, sideLengths, sequences, batch);
+			}
+		}
+	}
 
-				if (pairType != 0) { // FD: the NUPACK model puts terms here to be non-zero.    in NUPACK, G-T stacking is a thing. Hairpin loops are size 3 or more.
+// Case #2a-c: adjacent loop creation moves
+	for (loop3 = 0; loop3 < numAdjacent; loop3++) { // CHECK: is numAdjacent really correct? it could be numAdjacent+1
 
-					energies[0] = energyModel->HairpinEnergy(&mySequence[loop], loop2 - loop - 1);
+		if (groupCreationMoves((long) sidelen[loop3] * sidelen[loop3 + 1])) {
+			addCreationGroups(true, sidelen, seqs, loop3, loop3 + 1);
+			continue;
+		}
 
-					for (temploop = 0, tempindex = 0; temploop < numAdjacent + 2; temploop++, tempindex++) {
-						if (temploop == loop3) {
-							sideLengths[temploop] = loop - 1;
-							sequences[temploop] = seqs[temploop];
-							sideLengths[temploop + 1] = sidelen[temploop] - loop2;
-							sequences[temploop + 1] = seqs[temploop] + loop2;
-							temploop = temploop + 1;
-						} else {
-							sideLengths[temploop] = sidelen[tempindex];
-							sequences[temploop] = seqs[tempindex];
-						}
-					}
-					energies[1] = energyModel->OpenloopEnergy(numAdjacent + 1, sideLengths, sequences);
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
+		for (loop = 1; loop <= sidelen[loop3]; loop++)
+			for (loop2 = masks[loop3 + 1].next(seqs[loop3][loop], 1, sidelen[loop3 + 1]); loop2 <= sidelen[loop3 + 1];
+					loop2 = masks[loop3 + 1].next(seqs[loop3][loop], loop2 + 1, sidelen[loop3 + 1])) {
+
+				addCreationMove(loop3, loop, loop3 + 1, loop2, sideLengths, sequences, batch);
+			}
+	}
+
+// Case #3: non-adjacent loop creation moves (2d)
+// Revamped so it actually works. Algorithm follows:
+// This is all connections between non-adjacent sides. Thus we must exclude adjacent sides, and must try all possible combinations which match. This means we have to cover ~n^2 side combinations, where n is the total number of sides. Note that in this data structure, n is numAdjacent+1, and they are labelled 0,1,...,numAdjacent
+// Loop over all sides. Within this loop, cover all sides that are labelled higher that the first, and are non adjacent. For each pair of bases in these two sides, check whether they can pair. For each pair, compute energies and add move to list.
+	for (loop3 = 0; loop3 <= numAdjacent - 2; loop3++) // The last 2 entries are not needed as neither have higher numbered non-adjacent sections.
+		for (loop4 = loop3 + 2; loop4 <= numAdjacent; loop4++) {
 
-					// if the new Arrhenius model is used, modify the existing rate based on the local context.
-					// to start, we need to learn what the local context is, AFTER the nucleotide is put in place.
+			if (groupCreationMoves((long) sidelen[loop3] * sidelen[loop4])) {
+				addCreationGroups(true, sidelen, seqs, loop3, loop4);
+				continue;
+			}
 
-					// OpenLoop is splitting off an hairpin. Which is loopMove, and something else
+			for (loop = 1; loop <= sidelen[loop3]; loop++) { // new version with all sequences in openloop starting at 1.
 
-					MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent + 2, sideLengths);
-					rateEnv = RateEnv(tempRate, energyModel, loopMove, rightMove);
+				for (loop2 = masks[loop4].next(seqs[loop3][loop], 1, sidelen[loop4]); loop2 <= sidelen[loop4];
+						loop2 = masks[loop4].next(seqs[loop3][loop], loop2 + 1, sidelen[loop4])) {
 
-					Move *tmove = new Move(MOVE_CREATE | MOVE_1, rateEnv, this, loop, loop2, loop3);
-					moves->addMove(tmove);
+					addCreationMove(loop3, loop, loop4, loop2, sideLengths, sequences, batch);
 				}
 			}
 		}
-	}
 
-// Case #2a-c: adjacent loop creation moves
-	for (loop3 = 0; loop3 < numAdjacent; loop3++) // CHECK: is numAdjacent really correct? it could be numAdjacent+1
-		for (loop = 1; loop <= sidelen[loop3]; loop++)
-			for (loop2 = 1; loop2 <= sidelen[loop3 + 1]; loop2++) { // each possibility is a hairpin and open loop, see above.
+	batch.flush(energyModel, getEnergy(), this, moves);
+	setTotalRate(getLocalRate());
 
-				pairType = pairtypes[seqs[loop3][loop]][seqs[loop3 + 1][loop2]];
+	if (sideLengths != NULL)
+		releaseArray(sideLengths);
+	if (sequences != NULL)
+		releaseArray(sequences);
 
-				if (pairType != 0) {
+	generateDeleteMoves();
+}
 
-					// three cases for which type of move:
-					MoveType leftMove = stackMove;
+bool OpenLoop::addCreationMove(int side1, int pos1, int side2, int pos2, int *sideLengths, char **sequences, MoveBatch &batch) {
 
-					if (loop == sidelen[loop3] && loop2 == 1) { 					// #2a: stack
+	int loop = pos1, loop2 = pos2, loop3 = side1, loop4 = side2;
+	int temploop, tempindex;
+	double energies[2];
 
-						energies[0] = energyModel->StackEnergy(seqs[loop3][loop], seqs[loop3 + 1][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop3 + 1][0]);
+	if (energyModel->pairtypes[(int) seqs[loop3][loop]][(int) seqs[loop4][loop2]] == 0) // the NUPACK model puts terms here to be non-zero.    in NUPACK, G-T stacking is a thing. Hairpin loops are size 3 or more.
+		return false;
 
-					} else if (loop == sidelen[loop3] || loop2 == 1) { 			// #2b: bulge
+	bool scratch = (sideLengths == NULL);
 
-						if (loop2 == 1) {
+	if (scratch) {
+		sideLengths = poolArray<int>(numAdjacent + 2);
+		sequences = poolArray<char*>(numAdjacent + 2);
+	}
 
-							energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop3 + 1][loop2], seqs[loop3][sidelen[loop3] + 1],
-									seqs[loop3 + 1][0], sidelen[loop3] - loop);
+	if (loop3 == loop4) {
 
-						} else {
+		// Case #1: a hairpin and an open loop
+		char* mySequence = seqs[loop3]; // this is the sequence of the strand that we use
 
-							energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop3 + 1][loop2], seqs[loop3][sidelen[loop3] + 1],
-									seqs[loop3 + 1][0], loop2 - 1);
+		energies[0] = energyModel->HairpinEnergy(&mySequence[loop], loop2 - loop - 1);
 
-						}
+		for (temploop = 0, tempindex = 0; temploop < numAdjacent + 2; temploop++, tempindex++) {
+			if (temploop == loop3) {
+				sideLengths[temploop] = loop - 1;
+				sequences[temploop] = seqs[temploop];
+				sideLengths[temploop + 1] = sidelen[temploop] - loop2;
+				sequences[temploop + 1] = seqs[temploop] + loop2;
+				temploop = temploop + 1;
+			} else {
+				sideLengths[temploop] = sidelen[tempindex];
+				sequences[temploop] = seqs[tempindex];
+			}
+		}
+		energies[1] = energyModel->OpenloopEnergy(numAdjacent + 1, sideLengths, sequences);
 
-						leftMove = stackLoopMove;
+		// if the new Arrhenius model is used, modify the existing rate based on the local context.
+		// to start, we need to learn what the local context is, AFTER the nucleotide is put in place.
 
-					} else { 					// #2c: interior
+		// OpenLoop is splitting off an hairpin. Which is loopMove, and something else
 
-						energies[0] = energyModel->InteriorEnergy(&seqs[loop3][loop], seqs[loop3 + 1], sidelen[loop3] - loop, loop2 - 1);
+		MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent + 2, sideLengths);
+		batch.add(energies[0] + energies[1], loopMove, rightMove, MOVE_CREATE | MOVE_1, loop, loop2, loop3);
 
-						leftMove = loopMove;
+	} else if (loop4 == loop3 + 1) {
 
-					}
+		// Case #2a-c: a stack, bulge or interior loop and an open loop
+		// three cases for which type of move:
+		MoveType leftMove = stackMove;
 
-					for (temploop = 0; temploop < numAdjacent + 1; temploop++) {
-						if (temploop == loop3) {
-							sideLengths[temploop] = loop - 1;
-							sequences[temploop] = seqs[temploop];
-						} else {
-							if (temploop == loop3 + 1) {
-								sideLengths[temploop] = sidelen[temploop] - loop2;
-								sequences[temploop] = &seqs[temploop][loop2];
-							} else {
-								sideLengths[temploop] = sidelen[temploop];
-								sequences[temploop] = seqs[temploop];
-							}
-						}
-					}
-					energies[1] = energyModel->OpenloopEnergy(numAdjacent, sideLengths, sequences);
+		if (loop == sidelen[loop3] && loop2 == 1) { 					// #2a: stack
 
-					tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
+			energies[0] = energyModel->StackEnergy(seqs[loop3][loop], seqs[loop3 + 1][loop2], seqs[loop3][sidelen[loop3] + 1], seqs[loop3 + 1][0]);
 
-					// openLoop is splitting off an stack/bulge/interior, and another openloop.
-					// Which is something, and something else
+		} else if (loop == sidelen[loop3] || loop2 == 1) { 			// #2b: bulge
 
-					// the new stack/bulge/interior is the LeftMove (see above);
-					// the new Openloop:
-					MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent + 1, sideLengths);
+			if (loop2 == 1) {
+
+				energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop3 + 1][loop2], seqs[loop3][sidelen[loop3] + 1],
+						seqs[loop3 + 1][0], sidelen[loop3] - loop);
+
+			} else {
+
+				energies[0] = energyModel->BulgeEnergy(seqs[loop3][loop], seqs[loop3 + 1][loop2], seqs[loop3][sidelen[loop3] + 1],
+						seqs[loop3 + 1][0], loop2 - 1);
 
-					rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
-					moves->addMove(new Move(MOVE_CREATE | MOVE_2, rateEnv, this, loop, loop2, loop3));
-				}
 			}
 
-// Case #3: non-adjacent loop creation moves (2d)
-// Revamped so it actually works. Algorithm follows:
-// This is all connections between non-adjacent sides. Thus we must exclude adjacent sides, and must try all possible combinations which match. This means we have to cover ~n^2 side combinations, where n is the total number of sides. Note that in this data structure, n is numAdjacent+1, and they are labelled 0,1,...,numAdjacent
-// Loop over all sides. Within this loop, cover all sides that are labelled higher that the first, and are non adjacent. For each pair of bases in these two sides, check whether they can pair. For each pair, compute energies and add move to list.
-	for (loop3 = 0; loop3 <= numAdjacent - 2; loop3++) // The last 2 entries are not needed as neither have higher numbered non-adjacent sections.
-		for (loop4 = loop3 + 2; loop4 <= numAdjacent; loop4++) {
+			leftMove = stackLoopMove;
 
-			for (loop = 1; loop <= sidelen[loop3]; loop++) { // new version with all sequences in openloop starting at 1.
+		} else { 					// #2c: interior
 
-				for (loop2 = 1; loop2 <= sidelen[loop4]; loop2++) {
-
-					pairType = pairtypes[seqs[loop3][loop]][seqs[loop4][loop2]];
-
-					if (pairType != 0) { // result is a multiloop and open loop.
-
-						for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) { // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
-
-							if (tempindex == loop3) {
-								sideLengths[temploop] = sidelen[tempindex] - loop;
-								sequences[temploop] = &seqs[tempindex][loop];
-								temploop++;
-							}
-							if (tempindex > loop3 && tempindex < loop4) {
-								sideLengths[temploop] = sidelen[tempindex];
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							}
-							if (tempindex == loop4) {
-								sideLengths[temploop] = loop2 - 1;
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							}
-						}
+			energies[0] = energyModel->InteriorEnergy(&seqs[loop3][loop], seqs[loop3 + 1], sidelen[loop3] - loop, loop2 - 1);
 
-						energies[0] = energyModel->MultiloopEnergy(loop4 - loop3 + 1, sideLengths, sequences);
-						MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
-
-						// Open loop
-						for (temploop = 0, tempindex = 0; temploop <= numAdjacent - (loop4 - loop3 - 1); tempindex++) {
-							if (tempindex == loop3) {
-								sideLengths[temploop] = loop - 1;
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							} else if (tempindex == loop4) {
-								sideLengths[temploop] = sidelen[tempindex] - loop2;
-								sequences[temploop] = &seqs[tempindex][loop2];
-								temploop++;
-							} else if (!((tempindex > loop3) && (tempindex < loop4))) {
-								sideLengths[temploop] = sidelen[tempindex];
-								sequences[temploop] = seqs[tempindex];
-								temploop++;
-							}
-						}
-						energies[1] = energyModel->OpenloopEnergy(numAdjacent - (loop4 - loop3 - 1), sideLengths, sequences);
-						tempRate = energyModel->returnRate(getEnergy(), (energies[0] + energies[1]), 0);
+			leftMove = loopMove;
+
+		}
+
+		for (temploop = 0; temploop < numAdjacent + 1; temploop++) {
+			if (temploop == loop3) {
+				sideLengths[temploop] = loop - 1;
+				sequences[temploop] = seqs[temploop];
+			} else {
+				if (temploop == loop3 + 1) {
+					sideLengths[temploop] = sidelen[temploop] - loop2;
+					sequences[temploop] = &seqs[temploop][loop2];
+				} else {
+					sideLengths[temploop] = sidelen[temploop];
+					sequences[temploop] = seqs[temploop];
+				}
+			}
+		}
+		energies[1] = energyModel->OpenloopEnergy(numAdjacent, sideLengths, sequences);
 
-						// openLoop is splitting off . Which is something, and something else
+		// openLoop is splitting off an stack/bulge/interior, and another openloop.
+		// Which is something, and something else
 
-						MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent - (loop4 - loop3) + 2, sideLengths);
+		// the new stack/bulge/interior is the LeftMove (see above);
+		// the new Openloop:
+		MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent + 1, sideLengths);
 
-						loops[0] = loop;
-						loops[1] = loop2;
-						loops[2] = loop3;
-						loops[3] = loop4;
+		batch.add(energies[0] + energies[1], leftMove, rightMove, MOVE_CREATE | MOVE_2, loop, loop2, loop3);
 
-						rateEnv = RateEnv(tempRate, energyModel, leftMove, rightMove);
+	} else {
 
-						moves->addMove(new Move(MOVE_CREATE | MOVE_3, rateEnv, this, loops));
-					}
+		// Case #3: a multiloop and an open loop
+		for (temploop = 0, tempindex = 0; temploop < (loop4 - loop3 + 1); tempindex++) { // note that loop4 - loop3 is the number of pairings that got included in the multiloop. The extra closing pair makes the +1.
 
-				}
+			if (tempindex == loop3) {
+				sideLengths[temploop] = sidelen[tempindex] - loop;
+				sequences[temploop] = &seqs[tempindex][loop];
+				temploop++;
+			}
+			if (tempindex > loop3 && tempindex < loop4) {
+				sideLengths[temploop] = sidelen[tempindex];
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
+			}
+			if (tempindex == loop4) {
+				sideLengths[temploop] = loop2 - 1;
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
+			}
+		}
+
+		energies[0] = energyModel->MultiloopEnergy(loop4 - loop3 + 1, sideLengths, sequences);
+		MoveType leftMove = energyModel->prefactorInternal(sideLengths[loop3], sideLengths[loop4]);
+
+		// Open loop
+		for (temploop = 0, tempindex = 0; temploop <= numAdjacent - (loop4 - loop3 - 1); tempindex++) {
+			if (tempindex == loop3) {
+				sideLengths[temploop] = loop - 1;
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
+			} else if (tempindex == loop4) {
+				sideLengths[temploop] = sidelen[tempindex] - loop2;
+				sequences[temploop] = &seqs[tempindex][loop2];
+				temploop++;
+			} else if (!((tempindex > loop3) && (tempindex < loop4))) {
+				sideLengths[temploop] = sidelen[tempindex];
+				sequences[temploop] = seqs[tempindex];
+				temploop++;
 			}
 		}
+		energies[1] = energyModel->OpenloopEnergy(numAdjacent - (loop4 - loop3 - 1), sideLengths, sequences);
 
-	totalRate = moves->getRate();
+		// openLoop is splitting off . Which is something, and something else
 
-	if (sideLengths != NULL)
-		delete[] sideLengths;
-	if (sequences != NULL)
-		delete[] sequences;
+		MoveType rightMove = energyModel->prefactorOpen(loop3, numAdjacent - (loop4 - loop3) + 2, sideLengths);
 
-	generateDeleteMoves();
+		batch.add(energies[0] + energies[1], leftMove, rightMove, MOVE_CREATE | MOVE_3, loop, loop2, loop3, loop4);
+	}
+
+	if (scratch) {
+		releaseArray(sideLengths);
+		releaseArray(sequences);
+	}
+
+	return true;
 }
 
 void OpenLoop::generateDeleteMoves(void) {
@@ -4792,7 +5020,7 @@ void OpenLoop::generateDeleteMoves(void) {
 
 	}
 
-	totalRate = moves->getRate();
+	setTotalRate(getLocalRate());
 }
 
 void OpenLoop::printMove(Loop *comefrom, char *structure_p, char *seq_p) {
@@ -5068,8 +5296,8 @@ void OpenLoop::performComplexJoin(OpenLoop **oldLoops, OpenLoop **newLoops, char
 	sizes[1] = seqnum[1] + 1 + (oldLoops[0]->numAdjacent - seqnum[0]);
 
 	for (toggle = 0; toggle <= 1; toggle++) {
-		sidelen = new int[sizes[toggle] + 1];
-		seqs = new char *[sizes[toggle] + 1];
+		sidelen = poolArray<int>(sizes[toggle] + 1);
+		seqs = poolArray<char*>(sizes[toggle] + 1);
 
 		for (loop = 0; loop < sizes[toggle] + 1; loop++) {
 			if (loop < seqnum[toggle]) {
@@ -5119,12 +5347,11 @@ void OpenLoop::performComplexJoin(OpenLoop **oldLoops, OpenLoop **newLoops, char
 	newLoops[0]->generateMoves();
 	newLoops[1]->generateMoves();
 
-// need to re-generate the moves for all adjacent loops.
-// TODO: change this to only re-generate the deletion moves.
+// need to re-generate the deletion moves for all adjacent loops.
 	for (toggle = 0; toggle <= 1; toggle++)
 		for (loop = 0; loop < sizes[toggle]; loop++)
 			if (loop != seqnum[toggle])
-				newLoops[toggle]->adjacentLoops[loop]->generateMoves();
+				newLoops[toggle]->adjacentLoops[loop]->regenerateDeleteMoves();
 
 }
 
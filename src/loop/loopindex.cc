@@ -0,0 +1,245 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include <assert.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "loopindex.h"
+#include "loop.h"
+
+using std::vector;
+using std::pair;
+
+thread_local LoopIndex *LoopIndex::active = NULL;
+
+LoopIndex::LoopIndex(void) {
+
+	topbit = 0;
+	count = 0;
+	tree.push_back(0.0); // tree[0] is unused
+
+}
+
+LoopIndex::~LoopIndex(void) {
+
+	// the loops may outlive the index (they are deleted by the ordering), so detach them.
+	for (unsigned int slot = 0; slot < loops.size(); slot++) {
+		if (loops[slot] != NULL) {
+			loops[slot]->loopIndex = NULL;
+			loops[slot]->indexSlot = -1;
+			loops[slot] = NULL;
+		}
+	}
+
+	if (active == this)
+		active = NULL;
+
+}
+
+void LoopIndex::build(Loop *start) {
+
+	vector<pair<Loop*, Loop*> > todo; // (loop, the loop we came from)
+	todo.push_back(pair<Loop*, Loop*>(start, NULL));
+
+	while (todo.size() > 0) {
+
+		Loop *current = todo.back().first;
+		Loop *from = todo.back().second;
+		todo.pop_back();
+
+		if (current->loopIndex == this) {
+			update(current);
+		} else {
+			if (current->loopIndex != NULL)
+				current->loopIndex->remove(current);
+			insert(current);
+		}
+
+		for (int i = 0; i < current->getCurAdjacent(); i++) {
+			Loop *next = current->getAdjacent(i);
+			if (next != NULL && next != from)
+				todo.push_back(pair<Loop*, Loop*>(next, current));
+		}
+	}
+
+}
+
+void LoopIndex::absorb(LoopIndex *other) {
+
+	for (unsigned int slot = 0; slot < other->loops.size(); slot++) {
+
+		Loop *loop = other->loops[slot];
+
+		if (loop != NULL) {
+			loop->loopIndex = NULL;
+			loop->indexSlot = -1;
+			insert(loop);
+		}
+	}
+
+	other->loops.clear();
+	other->rates.clear();
+	other->freeSlots.clear();
+	other->tree.assign(1, 0.0);
+	other->topbit = 0;
+	other->count = 0;
+
+}
+
+void LoopIndex::grow(void) {
+
+	// Appending a node: it covers the slots to its left, which are all present already.
+	int node = loops.size() + 1;
+	double sum = 0.0;
+
+	for (int child = node - 1; child > node - (node & -node); child -= (child & -child))
+		sum += tree[child];
+
+	loops.push_back(NULL);
+	rates.push_back(0.0);
+	tree.push_back(sum);
+
+	if (topbit == 0)
+		topbit = 1;
+	else if (topbit * 2 <= node)
+		topbit = topbit * 2;
+
+}
+
+void LoopIndex::insert(Loop *loop) {
+
+	assert(loop->loopIndex == NULL);
+
+	int slot;
+
+	if (freeSlots.size() > 0) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		grow();
+		slot = loops.size() - 1;
+	}
+
+	loops[slot] = loop;
+	loop->loopIndex = this;
+	loop->indexSlot = slot;
+	count++;
+
+	rates[slot] = loop->totalRate;
+	addDelta(slot, loop->totalRate);
+
+}
+
+void LoopIndex::remove(Loop *loop) {
+
+	int slot = loop->indexSlot;
+
+	assert(loop->loopIndex == this);
+	assert(loops[slot] == loop);
+
+	addDelta(slot, -rates[slot]);
+	rates[slot] = 0.0;
+	loops[slot] = NULL;
+	freeSlots.push_back(slot);
+	count--;
+
+	loop->loopIndex = NULL;
+	loop->indexSlot = -1;
+
+}
+
+void LoopIndex::update(Loop *loop) {
+
+	int slot = loop->indexSlot;
+	double delta = loop->totalRate - rates[slot];
+
+	if (delta != 0.0) {
+		addDelta(slot, delta);
+		rates[slot] = loop->totalRate;
+	}
+
+}
+
+void LoopIndex::addDelta(int slot, double delta) {
+
+	for (unsigned int node = slot + 1; node < tree.size(); node += (node & -node))
+		tree[node] += delta;
+
+}
+
+void LoopIndex::rebuildTree(void) {
+
+	for (unsigned int node = 1; node < tree.size(); node++)
+		tree[node] = rates[node - 1];
+
+	for (unsigned int node = 1; node < tree.size(); node++) {
+		unsigned int parent = node + (node & -node);
+		if (parent < tree.size())
+			tree[parent] += tree[node];
+	}
+
+}
+
+Loop *LoopIndex::getChoice(double *rnd) {
+
+	int size = loops.size();
+	int pos = 0;
+
+	assert(count > 0);
+
+	for (int step = topbit; step > 0; step = step / 2) {
+		if (pos + step <= size && tree[pos + step] <= *rnd) {
+			pos += step;
+			*rnd -= tree[pos];
+		}
+	}
+
+	// Falling off the end, or onto an empty slot, only happens by rounding;
+	// take the next loop that has moves, or failing that the last one before.
+	if (pos >= size || loops[pos] == NULL || rates[pos] <= 0.0) {
+
+		int next = pos;
+
+		while (next < size && (loops[next] == NULL || rates[next] <= 0.0))
+			next++;
+
+		if (next >= size) {
+			next = std::min(pos, size - 1);
+
+			while (next > 0 && (loops[next] == NULL || rates[next] <= 0.0))
+				next--;
+		}
+
+		pos = next;
+	}
+
+	// the same goes for the remainder, which the loop's own container must accept.
+	if (*rnd >= rates[pos])
+		*rnd = rates[pos] * (1.0 - 1.0e-12);
+	if (*rnd < 0.0)
+		*rnd = 0.0;
+
+	return loops[pos];
+
+}
+
+double LoopIndex::getTotal(void) {
+
+	double total = 0.0;
+
+	for (int node = loops.size(); node > 0; node -= (node & -node))
+		total += tree[node];
+
+	return total;
+
+}
+
+int LoopIndex::getCount(void) {
+
+	return count;
+
+}
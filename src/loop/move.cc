@@ -151,6 +151,18 @@ Move::~Move(void) {
 	affected[0] = affected[1] = NULL;
 }
 
+void* Move::operator new(size_t size) {
+
+	return poolAllocate(size);
+
+}
+
+void Move::operator delete(void* memory, size_t size) {
+
+	poolRelease(memory, size);
+
+}
+
 double Move::getRate(void) {
 	return rate.rate;
 }
@@ -210,19 +222,11 @@ string Move::toString(bool useArr) {
 
 }
 
-///* MoveTree info */
-//MoveTree::~MoveTree(void) {
-//	/* destruction of a move tree node does imply destruction of all subnodes */
-//	if (left != NULL)
-//		delete left;
-//	if (right != NULL)
-//		delete right;
-//}
-//
-///* MoveList */
+/* MoveList */
 
 MoveList::MoveList(int initial_size) {
 	totalrate = 0.0;
+	moves_rate = 0.0;
 	moves_size = initial_size;
 	if (moves_size >= 1) {
 		moves = new Move *[moves_size];
@@ -277,14 +281,38 @@ void MoveList::resetDeleteMoves(void) {
 		}
 		iter++;
 	}
-	if (del_moves != NULL)
-		delete[] del_moves;
+	del_moves_index = 0;
+
+	// the creation moves were added first, so this is the total as it was
+	// before the deletion moves came in, to the bit.
+	totalrate = moves_rate;
+}
+
+void MoveList::clear(int initial_size) {
+
+	for (int loop = 0; loop < moves_index; loop++) {
+		delete moves[loop];
+		moves[loop] = NULL;
+	}
 
-	if (del_moves == NULL) {
-		del_moves = new Move *[2];
-		del_moves_size = 2;
+	for (int loop = 0; loop < del_moves_index; loop++) {
+		delete del_moves[loop];
+		del_moves[loop] = NULL;
 	}
+
+	// addMove needs room for at least one creation move, if there are any.
+	if (moves_size == 0 && initial_size >= 1) {
+		moves_size = initial_size;
+		moves = new Move *[moves_size];
+		for (int loop = 0; loop < moves_size; loop++)
+			moves[loop] = NULL;
+	}
+
+	totalrate = 0.0;
+	moves_rate = 0.0;
+	moves_index = 0;
 	del_moves_index = 0;
+	int_index = 0;
 }
 
 void MoveList::printAllMoves(bool useArr) {
@@ -313,6 +341,7 @@ void MoveList::addMove(Move *newmove) {
 
 		moves[moves_index] = newmove;
 		totalrate += newmove->getRate();
+		moves_rate += newmove->getRate();
 		moves_index++;
 		// next add would be an overflow.
 		if (moves_index == moves_size) {
@@ -393,12 +422,285 @@ Move *MoveList::getChoice(double *rnd) {
 	assert(0); // should never call for a move from a container unless it will get one.
 	return NULL;
 }
+
+/* MoveTree */
+
+MoveTree::MoveTree(int initial_size) {
+
+	totalrate = 0.0;
+	moves_rate = 0.0;
+	moves_size = (initial_size >= 1) ? initial_size : 1;
+	moves_index = 0;
+	moves_topbit = 0;
+
+	moves = new Move *[moves_size];
+	tree = new double[moves_size + 1];
+
+	for (int loop = 0; loop < moves_size; loop++) {
+		moves[loop] = NULL;
+		tree[loop + 1] = 0.0;
+	}
+	tree[0] = 0.0;
+
+	del_moves = NULL;
+	del_moves_size = 0;
+	del_moves_index = 0;
+	int_index = 0;
+
+}
+
+MoveTree::~MoveTree(void) {
+
+	for (int loop = 0; loop < moves_index; loop++) {
+		if (moves[loop] != NULL) {
+			delete moves[loop];
+			moves[loop] = NULL;
+		}
+	}
+
+	delete[] moves;
+	delete[] tree;
+
+	for (int loop = 0; loop < del_moves_index; loop++) {
+		if (del_moves[loop] != NULL) {
+			delete del_moves[loop];
+			del_moves[loop] = NULL;
+		}
+	}
+
+	if (del_moves != NULL)
+		delete[] del_moves;
+
+}
+
+void MoveTree::resetDeleteMoves(void) {
+
+	for (int loop = 0; loop < del_moves_index; loop++) {
+		if (del_moves[loop] != NULL) {
+			delete del_moves[loop];
+			del_moves[loop] = NULL;
+		}
+	}
+
+	del_moves_index = 0;
+
+	// as in MoveList, the creation moves were summed first.
+	totalrate = moves_rate;
+
+}
+
+// unlike MoveList, the arrays always have room for a move (see the constructor), so no size is needed.
+void MoveTree::clear(int) {
+
+	// the tree entries are rewritten as moves are appended, so only the moves need clearing.
+	for (int loop = 0; loop < moves_index; loop++) {
+		delete moves[loop];
+		moves[loop] = NULL;
+	}
+
+	for (int loop = 0; loop < del_moves_index; loop++) {
+		delete del_moves[loop];
+		del_moves[loop] = NULL;
+	}
+
+	totalrate = 0.0;
+	moves_rate = 0.0;
+	moves_index = 0;
+	moves_topbit = 0;
+	del_moves_index = 0;
+	int_index = 0;
+
+}
+
+void MoveTree::printAllMoves(bool useArr) {
+
+	for (int i = 0; i < moves_index; i++) {
+
+		cout << "Move" << i << " ";
+		cout << moves[i]->toString(useArr);
+
+	}
+
+	for (int i = 0; i < del_moves_index; i++) {
+
+		cout << "Move" << i + moves_index << " ";
+		cout << del_moves[i]->toString(useArr);
+
+	}
+
+}
+
+void MoveTree::growMoves(void) {
+
+	Move **temp = moves;
+	double *temptree = tree;
+
+	moves = new Move *[moves_size * 2];
+	tree = new double[moves_size * 2 + 1];
+
+	tree[0] = 0.0;
+	for (int loop = 0; loop < moves_size * 2; loop++) {
+		if (loop < moves_size) {
+			moves[loop] = temp[loop];
+			tree[loop + 1] = temptree[loop + 1];
+		} else {
+			moves[loop] = NULL;
+			tree[loop + 1] = 0.0;
+		}
+	}
+
+	moves_size = moves_size * 2;
+
+	delete[] temp;
+	delete[] temptree;
+
+}
+
+void MoveTree::addMove(Move *newmove) {
+
+	int type = newmove->getType();
+	double rate = newmove->getRate();
+
+	totalrate += rate;
+
+	if (!(type & MOVE_DELETE)) {
+
+		if (moves_index == moves_size)
+			growMoves();
+
+		// Moves are only ever appended, so the new node is the sum of its own
+		// rate and the nodes that it covers, which are all to its left.
+		int node = moves_index + 1;
+		double sum = rate;
+
+		for (int child = node - 1; child > node - (node & -node); child -= (child & -child))
+			sum += tree[child];
+
+		tree[node] = sum;
+		moves[moves_index] = newmove;
+		moves_index++;
+		moves_rate += rate;
+
+		if (moves_topbit == 0)
+			moves_topbit = 1;
+		else if (moves_topbit * 2 <= moves_index)
+			moves_topbit = moves_topbit * 2;
+
+	} else {
+
+		if (del_moves == NULL) {
+			del_moves = new Move *[2];
+			del_moves_size = 2;
+			del_moves_index = 0;
+		}
+
+		if (del_moves_index == del_moves_size) {
+			Move **temp = del_moves;
+			del_moves = new Move *[del_moves_size * 2];
+			for (int loop = 0; loop < del_moves_size; loop++)
+				del_moves[loop] = temp[loop];
+			del_moves_size = del_moves_size * 2;
+			delete[] temp;
+		}
+
+		del_moves[del_moves_index] = newmove;
+		del_moves_index++;
+	}
+
+}
+
+Move *MoveTree::getMove(Move *iterator) {
+
+	if (iterator == NULL)
+		int_index = 0;
+
+	if (int_index == moves_index)
+		return NULL;
+
+	return moves[int_index++];
+
+}
+
+Move *MoveTree::getChoice(double *rnd) {
+
+	if (*rnd < moves_rate && moves_index > 0) {
+
+		// Descend the Fenwick tree: find the first move whose prefix sum exceeds rnd.
+		int pos = 0;
+
+		for (int step = moves_topbit; step > 0; step = step / 2) {
+			if (pos + step <= moves_index && tree[pos + step] <= *rnd) {
+				pos += step;
+				*rnd -= tree[pos];
+			}
+		}
+
+		// The tree sums can differ from moves_rate by rounding, in which case we
+		// fall off the end; take the last move that can actually fire.
+		while (pos >= moves_index || moves[pos]->getRate() <= 0.0) {
+			assert(pos > 0);
+			pos--;
+		}
+
+		return moves[pos];
+
+	}
+
+	*rnd -= moves_rate;
+
+	for (int loop = 0; loop < del_moves_index; loop++) {
+
+		double tmp = del_moves[loop]->getRate();
+
+		if (*rnd < tmp)
+			return del_moves[loop];
+		else
+			*rnd -= tmp;
+	}
+
+	// again the rounding, take the last move in line that can fire.
+	for (int loop = del_moves_index - 1; loop >= 0; loop--) {
+		if (del_moves[loop]->getRate() > 0.0)
+			return del_moves[loop];
+	}
+
+	for (int loop = moves_index - 1; loop >= 0; loop--) {
+		if (moves[loop]->getRate() > 0.0)
+			return moves[loop];
+	}
+
+	assert(0); // should never call for a move from a container unless it will get one.
+	return NULL;
+
+}
+
 /*
 
  MoveContainer
 
  */
 
+thread_local bool MoveContainer::useMoveTree = false;
+
+MoveContainer* MoveContainer::newContainer(int initial_size) {
+
+	if (useMoveTree)
+		return new MoveTree(initial_size);
+	else
+		return new MoveList(initial_size);
+
+}
+
+MoveContainer* MoveContainer::renewContainer(MoveContainer* old, int initial_size) {
+
+	if (old == NULL)
+		return newContainer(initial_size);
+
+	old->clear(initial_size);
+	return old;
+
+}
+
 MoveContainer::MoveContainer(void) {
 	totalrate = 0.0;
 }
@@ -411,3 +713,292 @@ double MoveContainer::getRate(void) {
 	return totalrate;
 }
 
+
+/*
+
+ MoveBatch
+
+ */
+
+thread_local MoveBatch MoveBatch::local;
+
+MoveBatch::MoveBatch(void) {
+
+	size = 0;
+	count = 0;
+	pending = NULL;
+	energies = NULL;
+	rates = NULL;
+
+}
+
+MoveBatch::~MoveBatch(void) {
+
+	if (pending != NULL)
+		delete[] pending;
+	if (energies != NULL)
+		delete[] energies;
+	if (rates != NULL)
+		delete[] rates;
+
+}
+
+void MoveBatch::grow(void) {
+
+	int newsize = (size == 0) ? 64 : size * 2;
+
+	Pending *newpending = new Pending[newsize];
+	double *newenergies = new double[newsize];
+
+	for (int loop = 0; loop < count; loop++) {
+		newpending[loop] = pending[loop];
+		newenergies[loop] = energies[loop];
+	}
+
+	if (pending != NULL)
+		delete[] pending;
+	if (energies != NULL)
+		delete[] energies;
+	if (rates != NULL)
+		delete[] rates;
+
+	pending = newpending;
+	energies = newenergies;
+	rates = new double[newsize];
+	size = newsize;
+
+}
+
+void MoveBatch::add(double energy, MoveType left, MoveType right, int type, int index1, int index2, int index3, int index4) {
+
+	if (count == size)
+		grow();
+
+	Pending& item = pending[count];
+
+	item.left = left;
+	item.right = right;
+	item.type = type;
+	item.index[0] = index1;
+	item.index[1] = index2;
+	item.index[2] = index3;
+	item.index[3] = index4;
+	energies[count] = energy;
+	count++;
+
+}
+
+int MoveBatch::getCount(void) {
+
+	return count;
+
+}
+
+void MoveBatch::computeRates(EnergyModel *model, double start_energy) {
+
+	if (count > 0)
+		model->returnRates(start_energy, energies, rates, count);
+
+}
+
+Move *MoveBatch::makeMove(EnergyModel *model, Loop *loop, int item) {
+
+	Pending& move = pending[item];
+	RateEnv rateEnv(rates[item], model, move.left, move.right);
+
+	return new Move(move.type, rateEnv, loop, move.index[0], move.index[1], move.index[2], move.index[3]);
+
+}
+
+void MoveBatch::flush(EnergyModel *model, double start_energy, Loop *loop, MoveContainer *moves) {
+
+	computeRates(model, start_energy);
+
+	for (int item = 0; item < count; item++)
+		moves->addMove(makeMove(model, loop, item));
+
+	count = 0;
+
+}
+
+Move *MoveBatch::take(EnergyModel *model, double start_energy, Loop *loop) {
+
+	assert(count == 1);
+
+	computeRates(model, start_energy);
+	Move *move = makeMove(model, loop, 0);
+
+	count = 0;
+	return move;
+
+}
+
+
+/*
+
+ LazyMoves
+
+ */
+
+thread_local bool LazyMoves::useLazyMoves = false;
+thread_local long LazyMoves::boundMisses = 0;
+
+LazyMoves::LazyMoves(void) {
+
+	groups_size = 16;
+	groups_index = 0;
+	groups = new MoveGroup[groups_size];
+	totalrate = 0.0;
+	chosen = NULL;
+
+}
+
+LazyMoves::~LazyMoves(void) {
+
+	delete[] groups;
+
+	if (chosen != NULL)
+		delete chosen;
+
+}
+
+void LazyMoves::clear(void) {
+
+	groups_index = 0;
+	bits.clear();
+	totalrate = 0.0;
+
+	if (chosen != NULL)
+		delete chosen;
+	chosen = NULL;
+
+}
+
+void LazyMoves::addGroup(int side1, int pos1, int side2, int pos2, int count, uint64_t *members, double bound) {
+
+	if (count <= 0 || !(bound > 0.0))
+		return;
+
+	int words = (count + 63) >> 6;
+	int set = 0;
+
+	for (int loop = 0; loop < words; loop++)
+		set += __builtin_popcountll(members[loop]);
+
+	if (set == 0)
+		return;
+
+	if (groups_index == groups_size) {
+		MoveGroup *temp = groups;
+		groups = new MoveGroup[groups_size * 2];
+		for (int loop = 0; loop < groups_size; loop++)
+			groups[loop] = temp[loop];
+		groups_size = groups_size * 2;
+		delete[] temp;
+	}
+
+	MoveGroup& group = groups[groups_index++];
+
+	group.side1 = side1;
+	group.pos1 = pos1;
+	group.side2 = side2;
+	group.pos2 = pos2;
+	group.count = count;
+	group.members = set;
+	group.offset = (int) bits.size();
+	group.bound = bound;
+
+	bits.insert(bits.end(), members, members + words);
+
+	totalrate += set * bound;
+
+}
+
+double LazyMoves::getRate(void) {
+
+	return totalrate;
+
+}
+
+void LazyMoves::getChoice(double *rnd, int *side1, int *pos1, int *side2, int *pos2, double *bound, int *group) {
+
+	assert(groups_index > 0);
+
+	int index = 0;
+
+	// rounding can leave *rnd past the last group; it then gets the last one.
+	while (index < groups_index - 1 && *rnd >= groups[index].members * groups[index].bound) {
+		*rnd -= groups[index].members * groups[index].bound;
+		index++;
+	}
+
+	MoveGroup& chosenGroup = groups[index];
+
+	int member = (int) (*rnd / chosenGroup.bound);
+	if (member >= chosenGroup.members)
+		member = chosenGroup.members - 1;
+	if (member < 0)
+		member = 0;
+
+	*rnd -= member * chosenGroup.bound;
+
+	// the member-th set bit of the group.
+	uint64_t *word = &bits[chosenGroup.offset];
+	int count;
+
+	while ((count = __builtin_popcountll(*word)) <= member) {
+		member -= count;
+		word++;
+	}
+
+	uint64_t value = *word;
+	for (; member > 0; member--)
+		value &= value - 1;
+
+	int k = (int) ((word - &bits[chosenGroup.offset]) << 6) + __builtin_ctzll(value);
+
+	*side1 = chosenGroup.side1;
+	*pos1 = chosenGroup.pos1 + k;
+	*side2 = chosenGroup.side2;
+	*pos2 = chosenGroup.pos2 + k;
+	*bound = chosenGroup.bound;
+	*group = index;
+
+}
+
+void LazyMoves::getMembers(int group, int *side1, int *side2, std::vector<int> &pos1, std::vector<int> &pos2) {
+
+	MoveGroup& thisGroup = groups[group];
+
+	*side1 = thisGroup.side1;
+	*side2 = thisGroup.side2;
+
+	for (int k = 0; k < thisGroup.count; k++)
+		if (bits[thisGroup.offset + (k >> 6)] & (1ULL << (k & 63))) {
+			pos1.push_back(thisGroup.pos1 + k);
+			pos2.push_back(thisGroup.pos2 + k);
+		}
+
+}
+
+// the bits of the group stay behind, unused, until the next clear.
+void LazyMoves::removeGroup(int group) {
+
+	totalrate -= groups[group].members * groups[group].bound;
+
+	for (int loop = group; loop < groups_index - 1; loop++)
+		groups[loop] = groups[loop + 1];
+	groups_index--;
+
+	if (groups_index == 0)
+		totalrate = 0.0;
+
+}
+
+void LazyMoves::keepChoice(Move *move) {
+
+	if (chosen != NULL)
+		delete chosen;
+	chosen = move;
+
+}
@@ -76,10 +76,18 @@ string moveutil::primeToDesc(int input) {
 
 std::ostream& operator<<(std::ostream &ss, OpenInfo& m) {
 
-	for (std::pair<HalfContext, BaseCount> value : m.tally) {
+	for (int i = 0; i < HALFCONTEXT_TOTAL; i++) {
 
-		ss << value.first << " ";
-		ss << value.second << "   --   ";
+		BaseCount& count = m.tally[i];
+
+		if (count.count[baseA] || count.count[baseC] || count.count[baseG] || count.count[baseT]) {
+
+			HalfContext con = HalfContext::fromIndex(i);
+
+			ss << con << " ";
+			ss << count << "   --   ";
+
+		}
 
 	}
 
@@ -94,7 +102,10 @@ std::ostream& operator<<(std::ostream &ss, OpenInfo& m) {
 
 void OpenInfo::clear(void) {
 
-	tally.clear();
+	for (int i = 0; i < HALFCONTEXT_TOTAL; i++) {
+		tally[i].clear();
+	}
+
 	numExposedInternal = 0;
 	numExposed = 0;
 
@@ -103,57 +114,26 @@ void OpenInfo::clear(void) {
 // simply store the vector of halfContext onto the list we already have
 void OpenInfo::increment(QuartContext left, char base, QuartContext right) {
 
-	HalfContext con = HalfContext(left, right);
-
-	if (tally.count(con)) { // if count > 0 then proceed
-
-		tally.find(con)->second.count[base]++;
-
-	} else {
-
-		BaseCount count = BaseCount();
-		count.count[base]++;
-		tally.insert(std::pair<HalfContext, BaseCount>(con, count));
-
-	}
+	tally[HalfContext(left, right).getIndex()].count[(int) base]++;
 
 }
 
 void OpenInfo::increment(HalfContext con, BaseCount& count) {
 
-	if (tally.count(con)) {
-
-		// if found, increment from the reference
-
-		tally.find(con)->second.increment(count);
-
-	} else { // if not found, don't store the reference, make a new object.
-
-		BaseCount countNew = BaseCount();
-		countNew.increment(count);
-
-		tally.insert(std::pair<HalfContext, BaseCount>(con, countNew));
-
-	}
+	tally[con.getIndex()].increment(count);
 
 }
 
 void OpenInfo::decrement(HalfContext con, BaseCount& count) {
 
-	assert(tally.count(con));
-
-	tally.find(con)->second.decrement(count);
+	tally[con.getIndex()].decrement(count);
 
 }
 
 void OpenInfo::increment(OpenInfo& other) {
 
-	map<HalfContext, BaseCount> tally;
-
-	for (std::pair<HalfContext, BaseCount> myPair : other.tally) {
-
-		increment(myPair.first, myPair.second);
-
+	for (int i = 0; i < HALFCONTEXT_TOTAL; i++) {
+		tally[i].increment(other.tally[i]);
 	}
 
 	numExposedInternal += other.numExposedInternal;
@@ -163,12 +143,8 @@ void OpenInfo::increment(OpenInfo& other) {
 
 void OpenInfo::decrement(OpenInfo& other) {
 
-	map<HalfContext, BaseCount> tally;
-
-	for (std::pair<HalfContext, BaseCount> myPair : other.tally) {
-
-		decrement(myPair.first, myPair.second);
-
+	for (int i = 0; i < HALFCONTEXT_TOTAL; i++) {
+		tally[i].decrement(other.tally[i]);
 	}
 
 	numExposedInternal -= other.numExposedInternal;
@@ -176,39 +152,39 @@ void OpenInfo::decrement(OpenInfo& other) {
 
 }
 
-// simply compute the crossed-rate between these exposed nucleotides.
-
-double OpenInfo::crossRate(OpenInfo& other, EnergyModel& eModel) {
+// the number of complementary pairs between the two tallies, for each pair of half contexts.
+// output is row-major, HALFCONTEXT_TOTAL x HALFCONTEXT_TOTAL. The loops are branch-free
+// over fixed-size int arrays so the compiler can vectorize them.
+void OpenInfo::crossCount(OpenInfo& other, int* output) {
 
-	double output = 0.0;
+	for (int i = 0; i < HALFCONTEXT_TOTAL; i++) {
 
-	for (std::pair<HalfContext, BaseCount> here : tally) {
+		const int* top = tally[i].count;
 
-		HalfContext& top = here.first;
-		BaseCount& countTop = here.second;
+		for (int j = 0; j < HALFCONTEXT_TOTAL; j++) {
 
-		for (std::pair<HalfContext, BaseCount> there : other.tally) {
+			const int* bot = other.tally[j].count;
 
-			HalfContext& bot = there.first;
-			BaseCount& countBot = there.second;
+			output[i * HALFCONTEXT_TOTAL + j] = top[baseA] * bot[baseT] + top[baseC] * bot[baseG] + top[baseG] * bot[baseC] + top[baseT] * bot[baseA];
 
-			int crossings = countTop.multiCount(countBot);
+		}
 
-			if (crossings > 0) {
+	}
 
-				MoveType left = moveutil::combineBi(top.left, bot.right);
-				MoveType right = moveutil::combineBi(top.right, bot.left);
+}
 
+// simply compute the crossed-rate between these exposed nucleotides.
+double OpenInfo::crossRate(OpenInfo& other, const double* rates) {
 
-				double joinRate = eModel.applyPrefactors(eModel.getJoinRate(), left, right);
+	int crossings[HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL];
 
-				double rate = crossings * joinRate;
+	crossCount(other, crossings);
 
-				output += rate;
+	double output = 0.0;
 
-			}
+	for (int i = 0; i < HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL; i++) {
 
-		}
+		output += crossings[i] * rates[i];
 
 	}
 
@@ -341,6 +317,18 @@ bool HalfContext::operator==(const HalfContext& other) const {
 
 }
 
+int HalfContext::getIndex(void) const {
+
+	return left * HALFCONTEXT_SIZE + right;
+
+}
+
+HalfContext HalfContext::fromIndex(int index) {
+
+	return HalfContext((QuartContext) (index / HALFCONTEXT_SIZE), (QuartContext) (index % HALFCONTEXT_SIZE));
+
+}
+
 // c++ expects partial ordering instead of equality for mapping
 bool HalfContext::operator<(const HalfContext& other) const {
 
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include <string.h>
+#include "pairmask.h"
+#include "energymodel.h"
+#include "pool.h"
+
+thread_local std::map<char*, PairMask::Strand> PairMask::strands;
+thread_local std::vector<PairMask::Side> PairMask::sideList;
+thread_local std::vector<std::unique_ptr<PairMask>> PairMask::spares;
+
+PairMask::PairMask(void) {
+
+	pairs = NULL;
+	words = 0;
+	built = NULL;
+
+}
+
+PairMask::~PairMask(void) {
+
+	releaseArray(pairs);
+
+}
+
+void PairMask::build(EnergyModel *model, char *sequence, int length) {
+
+	releaseArray(pairs);
+
+	words = (length >> 6) + 1;
+	pairs = poolArray<uint64_t>(NUM_BASES * words);
+	memset(pairs, 0, NUM_BASES * words * sizeof(uint64_t));
+
+	for (int loop = 1; loop <= length; loop++)
+		for (int base = 0; base < NUM_BASES; base++)
+			if (model->pairtypes[base][(int) sequence[loop]] != 0)
+				pairs[base * words + (loop >> 6)] |= 1ULL << (loop & 63);
+
+	built = model;
+
+}
+
+void PairMask::addStrand(char *sequence, int size, PairMask *mask) {
+
+	Strand strand = { size, mask };
+	strands[sequence] = strand;
+
+}
+
+// the strand may have been made on another thread (a worker's complexes are deleted
+// by the main thread), which does not know it; the worker has exited by then.
+void PairMask::removeStrand(char *sequence) {
+
+	strands.erase(sequence);
+
+}
+
+// the side holds bases sequence[1 .. length], so it lies in the strand that holds sequence[1].
+PairMask::Side PairMask::find(EnergyModel *model, char *sequence, int length, int index) {
+
+	Side result;
+
+	std::map<char*, Strand>::iterator it = strands.upper_bound(sequence + 1);
+
+	if (it != strands.begin()) {
+
+		--it;
+		char *start = it->first;
+
+		if (sequence + length < start + it->second.size) {
+
+			// the strand mask counts the bases from 1, as the sides do.
+			if (it->second.mask->built != model)
+				it->second.mask->build(model, start - 1, it->second.size);
+
+			result.mask = it->second.mask;
+			result.offset = (int) (sequence - start) + 1;
+			return result;
+		}
+	}
+
+	while ((int) spares.size() <= index)
+		spares.push_back(std::unique_ptr<PairMask>(new PairMask()));
+
+	spares[index]->build(model, sequence, length);
+
+	result.mask = spares[index].get();
+	result.offset = 0;
+	return result;
+
+}
+
+PairMask::Side PairMask::side(EnergyModel *model, char *sequence, int length) {
+
+	return find(model, sequence, length, 0);
+
+}
+
+PairMask::Side *PairMask::sides(EnergyModel *model, char **sequences, int *lengths, int count) {
+
+	if ((int) sideList.size() < count)
+		sideList.resize(count);
+
+	for (int loop = 0; loop < count; loop++)
+		sideList[loop] = find(model, sequences[loop], lengths[loop], loop);
+
+	return sideList.data();
+
+}
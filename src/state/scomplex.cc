@@ -10,13 +10,13 @@
 #include <vector>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #include "scomplex.h"
 
 #include <utility.h>
 
 using std::cout;
 
-BaseCount emptyBaseCount;
 
 // JS: i'd like to optimize this lookup. It really should be just a bitwise
 //  or, and an array lookup, the extra function call annoys me.
@@ -34,6 +34,7 @@ StrandComplex::StrandComplex(char *seq, char *struc) {
 		tempcseq[loop] = baseLookup(tempcseq[loop]);
 
 	beginLoop = NULL;
+	loopIndex = new LoopIndex();
 	ordering = new StrandOrdering(tempseq, tempstruct, tempcseq);
 	delete[] tempseq;
 	delete[] tempstruct;
@@ -54,6 +55,7 @@ StrandComplex::StrandComplex(char *seq, char *struc, class identList *id_list) {
 	}
 
 	beginLoop = NULL;
+	loopIndex = new LoopIndex();
 	ordering = new StrandOrdering(tempseq, tempstruct, tempcseq, id_list);
 	delete[] tempseq;
 	delete[] tempstruct;
@@ -64,10 +66,18 @@ StrandComplex::StrandComplex(char *seq, char *struc, class identList *id_list) {
 StrandComplex::StrandComplex(StrandOrdering *newOrdering) {
 	ordering = newOrdering;
 	beginLoop = ordering->getLoop();
+	loopIndex = new LoopIndex();
+
+	// take our loops over from the index of the complex we split off from.
+	if (beginLoop != NULL) {
+		loopIndex->build(beginLoop);
+		recomputeFlux();
+	}
 
 }
 
 StrandComplex::~StrandComplex(void) {
+	delete loopIndex;
 	// we cannot delete this here now, as they could be associated with a strandordering that will live on when the complex dies.
 	if (ordering != NULL)
 		delete ordering;
@@ -77,7 +87,8 @@ typedef std::vector<Loop*> LoopVector;
 
 void StrandComplex::cleanup(void) {
 	LoopVector loops;
-	loops.push_back(beginLoop);
+	if (beginLoop != NULL) // the loops are not generated before initializeList
+		loops.push_back(beginLoop);
 	while (loops.size() > 0) {
 		Loop* current = loops.back();
 		loops.pop_back();
@@ -108,8 +119,28 @@ int StrandComplex::checkIDList(class identList *stoplist, int id_count) {
 	return 1;
 }
 
-int StrandComplex::checkIDBound(char *id) {
-	return ordering->checkIDBound(id);
+// as checkIDList, for a stop complex that also gives the structure.
+int StrandComplex::checkStructure(class identList *stoplist, int id_count, char *structure) {
+	OpenLoop *temp;
+	temp = ordering->checkStructure(stoplist, id_count, structure);
+	if (temp == NULL)
+		return 0;
+
+	ordering->reorder(temp);
+
+	return 1;
+}
+
+// as checkIDList, for the loose and count stop types.
+int StrandComplex::checkDistance(class complexItem *stopitem) {
+	OpenLoop *temp;
+	temp = ordering->checkDistance(stopitem);
+	if (temp == NULL)
+		return 0;
+
+	ordering->reorder(temp);
+
+	return 1;
 }
 
 StrandComplex *StrandComplex::performComplexJoin(JoinCriteria crit, bool useArr) {
@@ -122,6 +153,9 @@ StrandComplex *StrandComplex::performComplexJoin(JoinCriteria crit, bool useArr)
 	}
 
 	StrandComplex** complexes = crit.complexes;
+
+	Loop::fluxChange = 0.0;
+	LoopIndex::active = complexes[0]->loopIndex;
 	char* types = crit.types;
 	int* index = crit.index;
 
@@ -161,13 +195,28 @@ StrandComplex *StrandComplex::performComplexJoin(JoinCriteria crit, bool useArr)
 
 	complexes[0]->beginLoop = new_ordering->getLoop();
 
-	complexes[0]->beginLoop->verifyLoop(NULL, NULL);
+	if (utility::debugTraces) {
+		complexes[0]->beginLoop->verifyLoop(NULL, NULL);
+	}
 
 	loops[0]->cleanupAdjacent();
 	delete loops[0];
 	loops[1]->cleanupAdjacent();
 	delete loops[1];
 
+	// merge the smaller loop index into the larger one.
+	if (complexes[0]->loopIndex->getCount() < complexes[1]->loopIndex->getCount()) {
+		LoopIndex *temp = complexes[0]->loopIndex;
+		complexes[0]->loopIndex = complexes[1]->loopIndex;
+		complexes[1]->loopIndex = temp;
+	}
+	complexes[0]->loopIndex->absorb(complexes[1]->loopIndex);
+	LoopIndex::active = NULL;
+
+	complexes[0]->totalFlux += complexes[1]->totalFlux + Loop::fluxChange;
+	complexes[0]->fluxScale = std::max(complexes[0]->fluxScale + complexes[1]->fluxScale, complexes[0]->totalFlux);
+	complexes[0]->fluxSteps += complexes[1]->fluxSteps + 1;
+
 	delete complexes[1]->ordering;
 	complexes[1]->ordering = NULL;
 	return complexes[1];
@@ -202,10 +251,14 @@ StrandComplex * StrandComplex::doChoice(Move * move) {
 	else
 		id3 = 0;
 
+	Loop::fluxChange = 0.0;
+	LoopIndex::active = loopIndex;
+
 	if (id2 == 'O' && id3 == 'O') { // Break the complex.
 
 		Loop *newLoop[2] = { NULL, NULL };
 		StrandOrdering *newOrdering = NULL;
+		StrandComplex *newComplex = NULL;
 
 		ordering->breakBasepair(move->getAffected(0)->getLocation(move, 0), move->getAffected(1)->getLocation(move, 1));
 		Loop::performComplexSplit(move, &newLoop[0], &newLoop[1]);
@@ -221,7 +274,13 @@ StrandComplex * StrandComplex::doChoice(Move * move) {
 			cout << "Going to break the complex!! 3/3 ********************** " << std::endl;
 		}
 
-		return (new StrandComplex(newOrdering)); // newComplex
+		// the new complex walks its own loops, we keep the remainder.
+		LoopIndex::active = NULL;
+		newComplex = new StrandComplex(newOrdering);
+		totalFlux += Loop::fluxChange - newComplex->totalFlux;
+		fluxSteps++;
+
+		return newComplex;
 
 	} else {
 		if (move->getType() & MOVE_CREATE)	 // FD: test if we have a create-basepair move
@@ -231,6 +290,12 @@ StrandComplex * StrandComplex::doChoice(Move * move) {
 
 		temp = move->doChoice();
 
+		LoopIndex::active = NULL;
+
+		totalFlux += Loop::fluxChange;
+		fluxScale = std::max(fluxScale, totalFlux);
+		fluxSteps++;
+
 		if (id2 == 'O')
 			ordering->replaceOpenLoop(temp2, temp);
 		if (temp3 != NULL && id3 == 'O')
@@ -242,7 +307,12 @@ StrandComplex * StrandComplex::doChoice(Move * move) {
 			else
 				assert(0);
 		}
-		beginLoop->verifyLoop( NULL, NULL);
+
+		// this walks the whole complex, so only when debugging.
+		if (utility::debugTraces) {
+			beginLoop->verifyLoop( NULL, NULL);
+			assert(ordering->verifyHashes());
+		}
 	}
 	return NULL;
 }
@@ -432,8 +502,8 @@ int StrandComplex::generateLoops(void) {
 
 			openloopcount = 0;
 			// listlength is at least one.
-			OL_sidelengths = (int *) new int[listlength + 1];
-			OL_sequences = (char **) new char *[listlength + 1];
+			OL_sidelengths = poolArray<int>(listlength + 1);
+			OL_sequences = poolArray<char*>(listlength + 1);
 			// deletion for these is handled in the OpenLoop destructor.
 			temp_intlist = templist;
 
@@ -503,8 +573,8 @@ int StrandComplex::generateLoops(void) {
 
 			if (listlength != 0) {
 
-				OL_sidelengths = (int *) new int[listlength + 1];
-				OL_sequences = (char **) new char *[listlength + 1];
+				OL_sidelengths = poolArray<int>(listlength + 1);
+				OL_sequences = poolArray<char*>(listlength + 1);
 				// deletion for these is handled in the OpenLoop destructor.
 				temp_intlist = templist;
 				/*	      OL_pairtypes[0] = stacklist->pairtype;
@@ -526,8 +596,8 @@ int StrandComplex::generateLoops(void) {
 
 			} else {
 
-				OL_sidelengths = (int *) new int[listlength + 1];
-				OL_sequences = (char **) new char *[listlength + 1];
+				OL_sidelengths = poolArray<int>(listlength + 1);
+				OL_sequences = poolArray<char*>(listlength + 1);
 				OL_sidelengths[0] = seqlen;
 				OL_sequences[0] = ordering->convertIndex(-1);
 				newLoop = new OpenLoop(0, OL_sidelengths, OL_sequences); // open chain
@@ -537,8 +607,8 @@ int StrandComplex::generateLoops(void) {
 				{
 			int *ML_sidelengths;
 			char **ML_sequences;
-			ML_sidelengths = (int *) new int[listlength];
-			ML_sequences = (char **) new char *[listlength];
+			ML_sidelengths = poolArray<int>(listlength);
+			ML_sequences = poolArray<char*>(listlength);
 			// deletion for these is handled in the OpenLoop destructor.
 			temp_intlist = templist;
 			// JS: Possibly a problem here, need to make sure sequences get paired correctly with lengths. FIXME
@@ -669,7 +739,29 @@ StrandOrdering * StrandComplex::getOrdering() {
 }
 
 double StrandComplex::getTotalFlux(void) {
-	return beginLoop->returnFlux(NULL);
+
+	// a large drop in flux means we cancelled most of the digits, so recompute then too.
+	if (fluxSteps >= FLUX_RECOMPUTE_INTERVAL || totalFlux < 1.0e-6 * fluxScale) {
+		recomputeFlux();
+	}
+
+	return totalFlux;
+}
+
+void StrandComplex::recomputeFlux(void) {
+
+	double flux = beginLoop->returnFlux(NULL);
+
+	if (utility::debugTraces) {
+		cout << "Recomputing flux, running total " << totalFlux << " actual " << flux << std::endl;
+	}
+
+	totalFlux = flux;
+	fluxScale = flux;
+	fluxSteps = 0;
+
+	loopIndex->rebuildTree();
+
 }
 
 char *StrandComplex::getSequence(void) {
@@ -683,6 +775,12 @@ char *StrandComplex::getStructure(void) {
 
 }
 
+uint64_t StrandComplex::getStructureHash(void) {
+
+	return ordering->getStructureHash();
+
+}
+
 char *StrandComplex::getStrandNames(void) {
 	return ordering->getStrandNames();
 }
@@ -697,15 +795,7 @@ BaseCount& StrandComplex::getExteriorBases(HalfContext* lowerHalf) {
 
 		OpenInfo& info = ordering->getOpenInfo();
 
-		if (info.tally.count(*lowerHalf)) {
-
-			return info.tally.find(*lowerHalf)->second;
-
-		} else {
-
-			return emptyBaseCount;
-
-		}
+		return info.tally[lowerHalf->getIndex()];
 
 	}
 
@@ -719,10 +809,19 @@ double StrandComplex::getEnergy(void) {
 
 void StrandComplex::generateMoves(void) {
 	beginLoop->firstGen( NULL);
+	loopIndex->build(beginLoop);
+	recomputeFlux();
 }
 
 Move *StrandComplex::getChoice(double *rand_choice) {
-	return beginLoop->getChoice(rand_choice, NULL);
+	Loop *chosen = loopIndex->getChoice(rand_choice);
+
+	// the flux only changes here when a group of moves is made exact, see Loop::expandGroup.
+	Loop::fluxChange = 0.0;
+	Move *move = chosen->getLocalChoice(rand_choice);
+	totalFlux += Loop::fluxChange;
+
+	return move;
 }
 
 int StrandComplex::getStrandCount(void) {
@@ -9,19 +9,18 @@ help@multistrand.org
 
 
 #include "scomplexlist.h"
+#include "structurehash.h"
 #include <assert.h>
 #include <math.h>
 
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <simoptions.h>
 #include <utility.h>
 #include <moveutil.h>
 #include <assert.h>
 
-typedef std::vector<int> intvec;
-typedef std::vector<int>::iterator intvec_it;
-
 /*
 
  SComplexListEntry Constructor/Destructor
@@ -44,6 +43,26 @@ SComplexListEntry::~SComplexListEntry(void) {
 		delete next;
 }
 
+// the matcher is only asked again once the complex has changed.
+bool SComplexListEntry::matchesStop(StopMatcher *matcher, complexItem *item) {
+
+	StrandOrdering *ordering = thisComplex->getOrdering();
+	uint64_t hashes[2] = { ordering->getStructureHash(), ordering->getNameHash() };
+
+	if (!stopProbed || hashes[0] != stopHashes[0] || hashes[1] != stopHashes[1]) {
+
+		stopItems.clear();
+		matcher->findItems(thisComplex, stopItems);
+
+		stopHashes[0] = hashes[0];
+		stopHashes[1] = hashes[1];
+		stopProbed = true;
+	}
+
+	return std::find(stopItems.begin(), stopItems.end(), item) != stopItems.end();
+
+}
+
 /*
 
  SComplexListEntry - InitializeComplex and FillData
@@ -73,6 +92,7 @@ void SComplexListEntry::fillData(EnergyModel *em) {
 
 	energy = thisComplex->getEnergy() + (em->getVolumeEnergy() + em->getAssocEnergy()) * (thisComplex->getStrandCount() - 1);
 	rate = thisComplex->getTotalFlux();
+	joinDataStale = true;
 
 }
 
@@ -129,6 +149,22 @@ SComplexList::SComplexList(EnergyModel *energyModel) {
 
 	eModel = energyModel;
 
+	// the bimolecular rate only depends on the pair of half contexts, so tabulate it once.
+	for (int i = 0; i < HALFCONTEXT_TOTAL; i++) {
+		for (int j = 0; j < HALFCONTEXT_TOTAL; j++) {
+
+			HalfContext top = HalfContext::fromIndex(i);
+			HalfContext bot = HalfContext::fromIndex(j);
+
+			MoveType left = moveutil::combineBi(top.left, bot.right);
+			MoveType right = moveutil::combineBi(top.right, bot.left);
+
+			crossRates[i * HALFCONTEXT_TOTAL + j] = eModel->applyPrefactors(eModel->getJoinRate(), left, right);
+			selfCross[i * HALFCONTEXT_TOTAL + j] = 0;
+
+		}
+	}
+
 }
 
 SComplexList::~SComplexList(void) {
@@ -166,8 +202,13 @@ SComplexListEntry *SComplexList::addComplex(StrandComplex *newComplex) {
 
 void SComplexList::initializeList(void) {
 
+	strandIndex.clear();
+
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
+		for (orderingList *strand = temp->thisComplex->getOrdering()->first; strand != NULL; strand = strand->next)
+			strandIndex.insert(std::make_pair(strand->nameHash, strand));
+
 		temp->initializeComplex();
 
 		if(utility::debugTraces){
@@ -218,30 +259,72 @@ double SComplexList::getTotalFlux(void) {
 
 BaseCount SComplexList::getExposedBases() {
 
-	BaseCount output;
+	refreshJoinData();
 
-	for (SComplexListEntry* it = first; it != NULL; it = it->next) {
+	return exposedTotal;
+}
 
-		BaseCount& ext_bases = it->thisComplex->getExteriorBases();
-		output.increment(ext_bases);
+OpenInfo SComplexList::getOpenInfo() {
+
+	refreshJoinData();
+
+	return openTotal;
+}
+
+/*
+ SComplexList::refreshJoinData
+
+ Re-counts the exposed bases of complexes that changed since the last call,
+ either because fillData was called on them or because their ordering
+ changed its open version. All other complexes keep their contribution to the totals.
+ */
+
+void SComplexList::refreshJoinData(void) {
+
+	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
+
+		StrandOrdering* ordering = temp->thisComplex->getOrdering();
+
+		if (!temp->joinDataStale && temp->joinDataVersion == ordering->getOpenVersion()) {
+			continue;
+		}
+
+		if (temp->joinDataCounted) {
+			addJoinData(temp, -1);
+		}
+
+		temp->exposedBases = temp->thisComplex->getExteriorBases();
+		temp->openInfo = temp->thisComplex->getOpenInfo();
+		temp->joinDataVersion = ordering->getOpenVersion();
+		temp->joinDataCounted = true;
+		temp->joinDataStale = false;
+
+		addJoinData(temp, +1);
 
 	}
 
-	return output;
 }
 
-OpenInfo SComplexList::getOpenInfo() {
+// adds (sign = +1) or removes (sign = -1) the cached join data of this entry from the totals.
+void SComplexList::addJoinData(SComplexListEntry* entry, int sign) {
 
-	OpenInfo output;
+	if (sign > 0) {
+		exposedTotal.increment(entry->exposedBases);
+		openTotal.increment(entry->openInfo);
+	} else {
+		exposedTotal.decrement(entry->exposedBases);
+		openTotal.decrement(entry->openInfo);
+	}
 
-	for (SComplexListEntry* it = first; it != NULL; it = it->next) {
+	selfMoves += sign * entry->exposedBases.multiCount(entry->exposedBases);
 
-		OpenInfo& ext_bases = it->thisComplex->ordering->getOpenInfo();
-		output.increment(ext_bases);
+	int crossings[HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL];
+	entry->openInfo.crossCount(entry->openInfo, crossings);
 
+	for (int i = 0; i < HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL; i++) {
+		selfCross[i] += sign * crossings[i];
 	}
 
-	return output;
 }
 
 /*
@@ -270,18 +353,11 @@ double SComplexList::getJoinFlux(void) {
 	}
 
 	double output = 0.0;
-	int moveCount = 0;
-
-	BaseCount totalBases = getExposedBases();
 
-	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
-
-		BaseCount& ext_bases = temp->thisComplex->getExteriorBases();
-		totalBases.decrement(ext_bases);
+	refreshJoinData();
 
-		moveCount += totalBases.multiCount(ext_bases);
-
-	}
+	// every pair of complementary bases, minus those within the same complex.
+	int moveCount = (exposedTotal.multiCount(exposedTotal) - selfMoves) / 2;
 
 // There are plenty of multi-complex structures with no moves.
 	if (moveCount > 0) {
@@ -303,19 +379,25 @@ double SComplexList::getJoinFlux(void) {
 // always have the same structure
 double SComplexList::getJoinFluxArr(void) {
 
-// The trick is to compute all rates between the first complex,
-// and the remaining complexes. Then, compute the rate between the second complex,
-// and the remaining complexes (set minus first and second), and so on.
+// The crossings between two half contexts summed over all pairs of complexes are
+// the crossings in the totals, minus those within each complex. These are integer
+// counts, so they are exact, and only complexes that changed need to be re-counted.
+
+	refreshJoinData();
+
+	int crossings[HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL];
+	openTotal.crossCount(openTotal, crossings);
 
 	double rate = 0.0;
 
-	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
+	for (int i = 0; i < HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL; i++) {
 
-		rate += computeArrBiRate(temp);
+		rate += (crossings[i] - selfCross[i]) * crossRates[i];
 
 	}
 
-	return rate;
+	// each pair of complexes was counted in both orders.
+	return 0.5 * rate;
 
 }
 
@@ -348,7 +430,7 @@ double SComplexList::cycleCrossRateArr(StrandOrdering* input1, StrandOrdering* i
 	OpenInfo& info1 = input1->getOpenInfo();
 	OpenInfo& info2 = input2->getOpenInfo();
 
-	return info1.crossRate(info2, *eModel);
+	return info1.crossRate(info2, crossRates);
 
 }
 
@@ -444,6 +526,14 @@ int SComplexList::doBasicChoice(double choice, double newtime) {
 	assert(pickedComplex != NULL);
 
 	tempmove = pickedComplex->getChoice(&rchoice);
+
+	if (tempmove == NULL) {
+		// a grouped creation move that was thinned out, nothing changes but, when its
+		// group was made exact, the flux of the complex.
+		temp2->rate = pickedComplex->getTotalFlux();
+		return MOVE_REJECTED;
+	}
+
 	moverate = tempmove->getRate();
 	type = tempmove->getType();
 	arrType = tempmove->getArrType();
@@ -454,6 +544,11 @@ int SComplexList::doBasicChoice(double choice, double newtime) {
 
 		temp = addComplex(newComplex);
 		temp->fillData(eModel);
+		setLastEvent(STOPEVENT_SPLIT, pickedComplex->getOrdering()->getNameMask() | newComplex->getOrdering()->getNameMask());
+
+	} else {
+
+		setLastEvent(STOPEVENT_PAIR, pickedComplex->getOrdering()->getNameMask());
 
 	}
 
@@ -511,6 +606,8 @@ int SComplexList::doJoinChoice(double choice) {
 	StrandComplex *deleted;
 
 	deleted = StrandComplex::performComplexJoin(crit, eModel->useArrhenius());
+	setLastEvent(STOPEVENT_JOIN, crit.complexes[0]->getOrdering()->getNameMask());
+
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
 		if (temp->thisComplex == crit.complexes[0]) {
@@ -521,6 +618,8 @@ int SComplexList::doJoinChoice(double choice) {
 
 			if (temp->next->thisComplex == deleted) {
 				temp2 = temp->next;
+				if (temp2->joinDataCounted)
+					addJoinData(temp2, -1);
 				temp->next = temp2->next;
 				temp2->next = NULL;
 				delete temp2;
@@ -532,6 +631,8 @@ int SComplexList::doJoinChoice(double choice) {
 
 	if (first->thisComplex == deleted) {
 		temp2 = first;
+		if (temp2->joinDataCounted)
+			addJoinData(temp2, -1);
 		first = first->next;
 		temp2->next = NULL;
 		delete temp2;
@@ -550,7 +651,7 @@ JoinCriteria SComplexList::cycleForJoinChoice(double choice) {
 
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
-		BaseCount& external = temp->thisComplex->getExteriorBases();
+		BaseCount& external = temp->exposedBases;
 		baseSum.decrement(external);
 
 		for (BaseType base : { baseA, baseT, baseG, baseC }) {
@@ -625,7 +726,7 @@ JoinCriteria SComplexList::cycleForJoinChoiceArr(double choice) {
 
 	for (SComplexListEntry* temp = first; temp != NULL; temp = temp->next) {
 
-		OpenInfo& external = temp->thisComplex->ordering->getOpenInfo();
+		OpenInfo& external = temp->openInfo;
 
 //		cout << "external= \n";
 //		cout << external;
@@ -634,79 +735,58 @@ JoinCriteria SComplexList::cycleForJoinChoiceArr(double choice) {
 
 		if (baseSum.numExposed > 0) {
 
-			for (std::pair<HalfContext, BaseCount> con : baseSum.tally) {
+			// crossings between the remaining complexes (con) and this one (ton), per pair of half contexts.
+			int crossings[HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL];
+			baseSum.crossCount(external, crossings);
 
-				for (std::pair<HalfContext, BaseCount> ton : external.tally) {
+			for (int i = 0; i < HALFCONTEXT_TOTAL * HALFCONTEXT_TOTAL; i++) {
 
-					int combinations = con.second.multiCount(ton.second);
+				int combinations = crossings[i];
 
-//					cout << combinations << "\n";
+				if (combinations > 0) {
 
-					if (combinations > 0) {
+					double joinRate = crossRates[i];
+					double rate = joinRate * combinations;
 
-						MoveType left = moveutil::combineBi(con.first.left, ton.first.right);
-						MoveType right = moveutil::combineBi(con.first.right, ton.first.left);
+					if (choice < rate) {
 
-						double joinRate = eModel->applyPrefactors(eModel->getJoinRate(), left, right);
+						// we have determined the HalfContexts for the upper and lower strand.
+						HalfContext con = HalfContext::fromIndex(i / HALFCONTEXT_TOTAL);
+						HalfContext ton = HalfContext::fromIndex(i % HALFCONTEXT_TOTAL);
 
-						double rate = joinRate * combinations;
+						BaseCount& conCount = baseSum.tally[con.getIndex()];
+						BaseCount& tonCount = external.tally[ton.getIndex()];
 
-//						cout << "choice  = " << choice << "\n";
-//						cout << "rate  = " << rate << "\n";
+						MoveType left = moveutil::combineBi(con.left, ton.right);
+						MoveType right = moveutil::combineBi(con.right, ton.left);
 
-						if (choice < rate) {
+						int choice_int = floor(choice / joinRate);
 
-//							cout << "trying to combine con - ton HalfEnv.: \n";
-//							cout << con.first << "\n";
-//							cout << ton.first << "\n";
+						for (BaseType base : { baseA, baseT, baseG, baseC }) {
 
-							// we have determined the HalfContexts for the upper and lower strand.
-							int choice_int = floor(choice / joinRate);
+							int combinations = conCount.count[base] * tonCount.count[5 - base];
 
-//							cout << "The baseCounts are con: \n";
-//							cout << con.second << "\n";
-//							cout << "The baseCounts are ton: \n";
-//							cout << ton.second << "\n";
+							if (choice_int < combinations) {
 
-//							cout << "choice_int = " << choice_int << "\n";
+								// return the joining criteria;
+								JoinCriteria crit = findJoinNucleotides(base, choice_int, tonCount, temp, &con);
 
-							for (BaseType base : { baseA, baseT, baseG, baseC }) {
+								crit.half[0] = ton;
+								crit.half[1] = con;
 
-								int combinations = con.second.count[base] * ton.second.count[5 - base];
+								crit.arrType = moveutil::getPrimeCode(left, right);
 
-//								cout << "For base " << baseA << " combinations= " << combinations << "\n";
-//
-
-								if (choice_int < combinations) {
-
-									// return the joining criteria;
-
-//									cout << "choice_int= " << choice_int << "\n";
-
-									JoinCriteria crit = findJoinNucleotides(base, choice_int, ton.second, temp, &con.first);
-
-//									cout << "Found rate contexts left: " << moveutil::MoveToString[left] << " right:" << moveutil::MoveToString[right] << "\n";
-
-//									crit.half[0] = con.first;
-//									crit.half[1] = ton.first;
-									crit.half[0] = ton.first;
-									crit.half[1] = con.first;
-
-									crit.arrType = moveutil::getPrimeCode(left, right);
-
-									return crit;
-
-								} else {
-									choice_int -= combinations;
-								}
+								return crit;
 
+							} else {
+								choice_int -= combinations;
 							}
 
-						} else {
+						}
 
-							choice = choice - rate;
+					} else {
 
-						}
+						choice = choice - rate;
 
 					}
 
@@ -784,6 +864,32 @@ bool SComplexList::checkStopComplexList(class complexItem *stoplist) {
 
 }
 
+// as checkStopComplexList, for the stop condition at this position in the
+// list. If it was checked after the previous move, and the last move cannot
+// change it (see StopMatcher::dependsOn), its result is kept.
+bool SComplexList::checkStopCondition(int index, class complexItem *stoplist) {
+
+	if (stopMatcher == NULL)
+		return checkStopComplexList(stoplist);
+
+	if ((int) stopResults.size() <= index) {
+		stopResults.resize(index + 1, false);
+		stopChecked.resize(index + 1, -2);
+	}
+
+	bool current = stopChecked[index] == moveCount;
+
+	if (stopChecked[index] == moveCount - 1)
+		current = !stopMatcher->dependsOn(index, lastEvent, lastNames);
+
+	if (!current)
+		stopResults[index] = checkStopComplexList(stoplist);
+
+	stopChecked[index] = moveCount;
+	return stopResults[index];
+
+}
+
 string SComplexList::toString() {
 
 	string output = "";
@@ -798,6 +904,25 @@ string SComplexList::toString() {
 
 }
 
+void SComplexList::setLastEvent(int event, uint64_t names) {
+
+	lastEvent = event;
+	lastNames = names;
+	moveCount++;
+
+}
+
+uint64_t SComplexList::getStateHash(void) {
+
+	uint64_t hash = 0;
+
+	for (SComplexListEntry *temp = first; temp != NULL; temp = temp->next)
+		hash ^= temp->thisComplex->getStructureHash();
+
+	return hash;
+
+}
+
 void SComplexList::updateOpenInfo(void) {
 
 	SComplexListEntry *temp = first;
@@ -818,25 +943,20 @@ void SComplexList::updateOpenInfo(void) {
  */
 bool SComplexList::checkStopComplexList_Bound(class complexItem *stoplist) {
 	class identList *id_traverse = stoplist->strand_ids;
-	class SComplexListEntry *entry_traverse = first;
-	int k_flag;
 	if (stoplist->next != NULL) {
 		fprintf(stderr, "ERROR: (scomplexlist.cc) Attempting to check for multiple complexes being bound, not currently supported.\n");
 		return false;  // ERROR: can only check for a single complex/group being bound in current version.
 	}
 
-// Check for each listed strand ID, and whether it's bound.
-// Note that we iterate through each complex in the list until we
-// find one where it's bound, and then move on to the next.
+// Check for each listed strand ID, and whether it's bound, ie has no unpaired bases.
+// Several strands can share the ID; any one of them being bound is enough.
 //
 	while (id_traverse != NULL) {
-		entry_traverse = first;
-		k_flag = 0;
-		while (entry_traverse != NULL && k_flag == 0) {
-			k_flag += entry_traverse->thisComplex->checkIDBound(id_traverse->id);
-			entry_traverse = entry_traverse->next;
-		}
-		if (k_flag == 0)
+		bool bound = false;
+		auto strands = strandIndex.equal_range(nameKey(id_traverse->id));
+		for (auto it = strands.first; it != strands.second && !bound; it++)
+			bound = it->second->unpaired == 0 && strcmp(it->second->thisTag, id_traverse->id) == 0;
+		if (!bound)
 			return false;
 		id_traverse = id_traverse->next;
 	}
@@ -844,6 +964,62 @@ bool SComplexList::checkStopComplexList_Bound(class complexItem *stoplist) {
 	return true;
 }
 
+// a DISASSOC stop complex is matched by the ordering of any strand with its
+// first ID, so only those orderings are checked. Reorders on a match, as
+// StrandComplex::checkIDList does.
+bool SComplexList::checkStopComplexList_Disassoc(class complexItem *stopitem, int id_count) {
+
+	if (stopitem->strand_ids == NULL)
+		return false;
+
+	// the orderings holding a strand with the first name, that have the listed strands.
+	vector<StrandOrdering*> matches;
+	vector<OpenLoop*> loops;
+
+	auto strands = strandIndex.equal_range(nameKey(stopitem->strand_ids->id));
+
+	for (auto it = strands.first; it != strands.second; it++) {
+
+		StrandOrdering *ordering = it->second->ordering;
+
+		if (strcmp(it->second->thisTag, stopitem->strand_ids->id) != 0)
+			continue;
+
+		if (std::find(matches.begin(), matches.end(), ordering) != matches.end())
+			continue;
+
+		OpenLoop *loop = ordering->checkIDList(stopitem->strand_ids, id_count);
+
+		if (loop != NULL) {
+			matches.push_back(ordering);
+			loops.push_back(loop);
+		}
+	}
+
+	if (matches.empty())
+		return false;
+
+	// as the scan over the list did, reorder the first matching complex in list order.
+	int choice = 0;
+
+	if (matches.size() > 1) {
+
+		for (SComplexListEntry *entry = first; entry != NULL; entry = entry->next) {
+
+			auto found = std::find(matches.begin(), matches.end(), entry->thisComplex->getOrdering());
+
+			if (found != matches.end()) {
+				choice = found - matches.begin();
+				break;
+			}
+		}
+	}
+
+	matches[choice]->reorder(loops[choice]);
+	return true;
+
+}
+
 bool SComplexList::checkStopComplexList_Structure_Disassoc(class complexItem *stoplist) {
 	class SComplexListEntry *entry_traverse = first;
 	class complexItem *traverse = stoplist;
@@ -874,26 +1050,28 @@ bool SComplexList::checkStopComplexList_Structure_Disassoc(class complexItem *st
 			id_traverse = id_traverse->next;
 		}
 
-		entry_traverse = first;
 		successflag = false;
+		if (traverse->type == STOPTYPE_DISASSOC) {
+			// for DISASSOC type checking, we only need the strand id lists to match correctly; see strandIndex.
+			successflag = checkStopComplexList_Disassoc(traverse, id_count);
+		}
+		entry_traverse = (traverse->type == STOPTYPE_DISASSOC) ? NULL : first;
 		while (entry_traverse != NULL && successflag == 0) {
 			// iterate check for current stop complex (traverse) in our list of system complexes (entry_traverse)
-			if (entry_traverse->thisComplex->checkIDList(traverse->strand_ids, id_count) > 0) {
+			if (stopMatcher != NULL && StopMatcher::isCompiled(traverse)) {
+				// the exact structure type, by hash.
+				successflag = entry_traverse->matchesStop(stopMatcher, traverse);
+			} else if (traverse->type == STOPTYPE_LOOSE_STRUCTURE || traverse->type == STOPTYPE_PERCENT_OR_COUNT_STRUCTURE) {
+				// the distance to the stop structure is kept up to date by the moves, see StopDistance.
+				// loose structures (see definitions) ignore the '*' bases; %'s are converted to raw base counts by the IO system.
+				successflag = entry_traverse->thisComplex->checkDistance(traverse) > 0;
+			} else if (entry_traverse->thisComplex->checkIDList(traverse->strand_ids, id_count) > 0) {
 				// if the system complex being checked has the correct circular permutation of strand ids, continue with our checks, otherwise it doesn't match.
 				if (traverse->type == STOPTYPE_STRUCTURE) {
 					if (strcmp(entry_traverse->thisComplex->getStructure(), traverse->structure) == 0) {
 						// if the structures match exactly, we have a successful match.
 						successflag = true;
 					}
-				} else if (traverse->type == STOPTYPE_DISASSOC) {
-					// for DISASSOC type checking, we only need the strand id lists to match correctly.
-					successflag = true;
-				} else if (traverse->type == STOPTYPE_LOOSE_STRUCTURE) {
-					successflag = checkLooseStructure(entry_traverse->thisComplex->getStructure(), traverse->structure, traverse->count);
-					// the structure matches loosely (see definitions)
-				} else if (traverse->type == STOPTYPE_PERCENT_OR_COUNT_STRUCTURE) {
-					successflag = checkCountStructure(entry_traverse->thisComplex->getStructure(), traverse->structure, traverse->count);
-					// this structure matches to within a % of the correct base pairs, note that %'s are converted to raw base counts by the IO system.
 				}
 			}
 			entry_traverse = entry_traverse->next;
@@ -907,125 +1085,3 @@ bool SComplexList::checkStopComplexList_Structure_Disassoc(class complexItem *st
 	}
 	return true;
 }
-
-/*
- Methods used for checking loose structure definitions and counting structure defs.
-
- int SComplexList::checkLooseStructure( char *our_struc, char *stop_struc, int count );
- int SComplexList::checkCountStructure( char *our_struc, char *stop_struc, int count );
-
- */
-
-bool SComplexList::checkLooseStructure(char *our_struc, char *stop_struc, int count) {
-	int loop, len;
-	intvec our_pairs, stop_pairs;
-	int remaining_distance = count;
-
-	len = strlen(our_struc);
-	if (len != strlen(stop_struc))
-		return false;  // something weird happened, as it should have the
-// same ID list...
-
-	for (loop = 0; loop < len; loop++) {
-		if (stop_struc[loop] != '*')
-			if (our_struc[loop] != stop_struc[loop]) {
-				remaining_distance--;
-			}
-
-		if (our_struc[loop] == '(')
-			our_pairs.push_back(loop);
-		if (stop_struc[loop] == '(')
-			stop_pairs.push_back(loop);
-
-		if (our_struc[loop] == ')' && stop_struc[loop] == ')') {
-			if (our_pairs.back() != stop_pairs.back()) {
-				remaining_distance--; // for position loop, which had
-									  // ),) but they were paired wrong
-				if (our_struc[stop_pairs.back()] == '(')
-					remaining_distance--; // for the position we were
-										  // paired with in stop_struc,
-										  // because it was ( in our_struc
-										  // as well, but paired wrong
-			}
-			our_pairs.pop_back();
-			stop_pairs.pop_back();
-		} else {
-			if (our_struc[loop] == ')')
-				our_pairs.pop_back();
-			if (stop_struc[loop] == ')') {
-				if (our_struc[stop_pairs.back()] == '(')
-					remaining_distance--;  // for the position we were
-										   // paired with in stop_struc,
-										   // because it was ( in our
-										   // struc but paired wrong. Note
-										   // we have already subtracted
-										   // for current position loop,
-										   // as our_struc[loop] !=
-										   // stop_struc[loop] in this
-										   // conditional block.
-				stop_pairs.pop_back();
-			}
-		}
-
-		if (remaining_distance < 0)
-			return false;
-	}
-	return true;
-}
-
-bool SComplexList::checkCountStructure(char *our_struc, char *stop_struc, int count) {
-
-	int loop, len;
-	intvec our_pairs, stop_pairs;
-	int remaining_distance = count;
-
-	len = strlen(our_struc);
-	if (len != strlen(stop_struc))
-		return false;  // something weird happened, as it should have the
-// same ID list...
-
-	for (loop = 0; loop < len; loop++) {
-		if (our_struc[loop] != stop_struc[loop]) {
-			remaining_distance--;
-		}
-
-		if (our_struc[loop] == '(')
-			our_pairs.push_back(loop);
-		if (stop_struc[loop] == '(')
-			stop_pairs.push_back(loop);
-
-		if (our_struc[loop] == ')' && stop_struc[loop] == ')') {
-			if (our_pairs.back() != stop_pairs.back()) {
-				remaining_distance--; // for position loop, which had
-									  // ),) but they were paired wrong
-				if (our_struc[stop_pairs.back()] == '(')
-					remaining_distance--; // for the position we were
-										  // paired with in stop_struc,
-										  // because it was ( in our_struc
-										  // as well, but paired wrong
-			}
-			our_pairs.pop_back();
-			stop_pairs.pop_back();
-		} else {
-			if (our_struc[loop] == ')')
-				our_pairs.pop_back();
-			if (stop_struc[loop] == ')') {
-				if (our_struc[stop_pairs.back()] == '(')
-					remaining_distance--;  // for the position we were
-										   // paired with in stop_struc,
-										   // because it was ( in our
-										   // struc but paired wrong. Note
-										   // we have already subtracted
-										   // for current position loop,
-										   // as our_struc[loop] !=
-										   // stop_struc[loop] in this
-										   // conditional block.
-				stop_pairs.pop_back();
-			}
-		}
-
-		if (remaining_distance < 0)
-			return false;
-	}
-	return true;
-}
@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include <Python.h>
+
+#include <string.h>
+#include "stopdistance.h"
+#include "scomplex.h"
+
+StopDistance::StopDistance(complexItem *item, StrandOrdering *ordering) {
+
+	this->item = item;
+
+	vector<int> partner;
+	length = ordering->getPartners(strands, offsets, partner);
+	int count = strands.size();
+
+	// the stop structure without the breaks, and where each of its strands starts.
+	vector<int> stopOffsets, open;
+	int stopLength = 0;
+
+	stopOffsets.push_back(0);
+
+	for (char *c = item->structure; *c != '\0'; c++) {
+
+		if (*c == '+') {
+			stopOffsets.push_back(stopLength);
+			continue;
+		}
+
+		stopPartner.push_back(-1);
+		counted.push_back(item->type != STOPTYPE_LOOSE_STRUCTURE || *c != '*');
+
+		if (*c == '(') {
+			open.push_back(stopLength);
+		} else if (*c == ')' && open.size() > 0) {
+			stopPartner[stopLength] = open.back();
+			stopPartner[open.back()] = stopLength;
+			open.pop_back();
+		}
+
+		stopLength++;
+	}
+
+	if (stopLength != length || (int) stopOffsets.size() != count)
+		return;
+
+	for (int start = 0; start < count; start++) {
+
+		identList *id_traverse = item->strand_ids;
+		bool same = true;
+
+		for (int loop = 0; same && loop < count; loop++, id_traverse = id_traverse->next) {
+
+			orderingList *strand = strands[(start + loop) % count];
+			int end = (loop + 1 < count) ? stopOffsets[loop + 1] : stopLength;
+
+			same = id_traverse != NULL && strcmp(strand->thisTag, id_traverse->id) == 0 && strand->size == end - stopOffsets[loop];
+		}
+
+		if (!same || id_traverse != NULL)
+			continue;
+
+		Rotation rotation = { start, 0 };
+
+		for (int base = 0; base < length; base++) {
+
+			int target = (base - offsets[start] + length) % length;
+			int other = (partner[base] < 0) ? -1 : (partner[base] - offsets[start] + length) % length;
+
+			if (counted[target] && other != stopPartner[target])
+				rotation.distance++;
+		}
+
+		rotations.push_back(rotation);
+	}
+
+}
+
+// the position of a base in the stop structure, for this rotation.
+int StopDistance::position(Rotation &rotation, orderingList *strand, int index) {
+
+	int loop = 0;
+
+	while (strands[loop] != strand)
+		loop++;
+
+	return (offsets[loop] + index - offsets[rotation.start] + length) % length;
+
+}
+
+OpenLoop *StopDistance::check(void) {
+
+	for (unsigned int loop = 0; loop < rotations.size(); loop++)
+		if (rotations[loop].distance <= item->count)
+			return strands[rotations[loop].start]->thisLoop;
+
+	return NULL;
+
+}
+
+void StopDistance::update(orderingList *first, int firstIndex, orderingList *second, int secondIndex, bool paired) {
+
+	for (unsigned int loop = 0; loop < rotations.size(); loop++) {
+
+		Rotation &rotation = rotations[loop];
+		int bases[2] = { position(rotation, first, firstIndex), position(rotation, second, secondIndex) };
+
+		for (int side = 0; side < 2; side++) {
+
+			int base = bases[side], other = bases[1 - side];
+
+			if (!counted[base])
+				continue;
+
+			// the partner goes from -1 to other when paired, and back when not.
+			int before = paired ? -1 : other;
+			int after = paired ? other : -1;
+
+			rotation.distance += (after != stopPartner[base]) - (before != stopPartner[base]);
+		}
+	}
+
+}
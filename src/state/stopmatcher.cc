@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include <Python.h>
+
+#include <utility>
+#include "stopmatcher.h"
+#include "structurehash.h"
+#include "scomplex.h"
+
+using std::pair;
+
+StopMatcher::StopMatcher(stopComplexes *conditions) {
+
+	for (stopComplexes *traverse = conditions; traverse != NULL; traverse = traverse->next) {
+
+		Dependency dependency = { 0, 0, 0 };
+
+		for (complexItem *item = traverse->citem; item != NULL; item = item->next) {
+
+			if (isCompiled(item))
+				compile(item);
+
+			// the strands of a disassociation condition only change complex on a join or a split.
+			dependency.events |= (item->type == STOPTYPE_DISASSOC) ? (STOPEVENT_JOIN | STOPEVENT_SPLIT) : STOPEVENT_ALL;
+
+			for (identList *id_traverse = item->strand_ids; id_traverse != NULL; id_traverse = id_traverse->next)
+				dependency.names |= nameBit(nameKey(id_traverse->id));
+		}
+
+		if (traverse->citem != NULL && traverse->citem->next != NULL)
+			dependency.anywhere = STOPEVENT_JOIN | STOPEVENT_SPLIT;
+
+		dependencies.push_back(dependency);
+	}
+
+}
+
+bool StopMatcher::isCompiled(complexItem *item) {
+
+	return item->type == STOPTYPE_STRUCTURE;
+
+}
+
+// the same sums as StrandOrdering::computeHashes, over the flat stop structure.
+void StopMatcher::compile(complexItem *item) {
+
+	uint64_t strandHash = 0, pairHash = 0;
+	Entry entry = { item, 0 };
+
+	for (identList *id_traverse = item->strand_ids; id_traverse != NULL; id_traverse = id_traverse->next) {
+		strandHash += nameKey(id_traverse->id);
+		entry.strandCount++;
+	}
+
+	vector<pair<uint64_t, int> > open;
+	identList *id_traverse = item->strand_ids;
+	uint64_t strand = (id_traverse != NULL) ? nameKey(id_traverse->id) : 0;
+	int index = 0;
+
+	for (char *c = item->structure; *c != '\0' && id_traverse != NULL; c++) {
+
+		if (*c == '+') {
+			id_traverse = id_traverse->next;
+			strand = (id_traverse != NULL) ? nameKey(id_traverse->id) : 0;
+			index = 0;
+			continue;
+		}
+
+		if (*c == '(') {
+			open.push_back(pair<uint64_t, int>(strand, index));
+		} else if (*c == ')' && open.size() > 0) {
+			pairHash += pairKey(baseKey(open.back().first, open.back().second), baseKey(strand, index));
+			open.pop_back();
+		}
+
+		index++;
+	}
+
+	structures.insert(pair<uint64_t, Entry>(mixHash(strandHash) + pairHash, entry));
+
+}
+
+bool StopMatcher::dependsOn(int condition, int event, uint64_t names) {
+
+	Dependency &dependency = dependencies[condition];
+
+	return (dependency.anywhere & event) || ((dependency.events & event) && (dependency.names & names));
+
+}
+
+void StopMatcher::findItems(StrandComplex *complex, vector<complexItem*> &items) {
+
+	StrandOrdering *ordering = complex->getOrdering();
+
+	auto candidates = structures.equal_range(ordering->getNameHash());
+
+	for (auto it = candidates.first; it != candidates.second; it++)
+		if (complex->checkStructure(it->second.item->strand_ids, it->second.strandCount, it->second.item->structure) > 0)
+			items.push_back(it->second.item);
+
+}
@@ -13,9 +13,14 @@ help@multistrand.org
 #include "scomplex.h" // implicitly includes strandordering.h, and is necessary for proper ordering. TODO: decorrelate these headers, they should be independent.
 #include <string>
 #include <sstream>
+#include <vector>
+#include <utility>
 #include <assert.h>
 #include <iostream>
 #include <utility.h>
+#include "energycache.h"
+#include "structurehash.h"
+#include "stopdistance.h"
 
 using std::cout;
 
@@ -42,12 +47,28 @@ orderingList::orderingList(int insize, int n_id, char *inTag, char *inSeq, char
 	thisCodeSeq[size] = '\0';
 	thisStruct[size] = '\0';
 
+	unpaired = 0;
+	for (int loop = 0; loop < size; loop++)
+		if (thisStruct[loop] == '.')
+			unpaired++;
+
 	next = prev = NULL;
 	thisLoop = NULL;
+	ordering = NULL;
+	offset = -1;
+
+	uidHash = uidKey(uid);
+	nameHash = nameKey(thisTag);
+
+	PairMask::addStrand(thisCodeSeq, size, &mask);
 
 }
 
 orderingList::~orderingList(void) {
+	// loop energies are cached by position in the strand sequences, see EnergyCache.
+	EnergyCache::invalidate();
+	PairMask::removeStrand(thisCodeSeq);
+
 	if (thisTag != NULL)
 		delete[] thisTag;
 	if (thisSeq != NULL)
@@ -79,6 +100,7 @@ StrandOrdering::~StrandOrdering(void) {
 		delete[] struc;
 	if (strandnames != NULL)
 		delete[] strandnames;
+	clearDistances();
 	return;
 }
 
@@ -102,6 +124,9 @@ StrandOrdering::StrandOrdering(orderingList *beginning, orderingList *ending, in
 	last = ending;
 	count = numitems;
 
+	for (orderingList *traverse = first; traverse != NULL; traverse = traverse->next)
+		traverse->ordering = this;
+
 }
 
 // Note that in_cseq is the code sequence (ie, not printable) and in_seq is the printable version.
@@ -173,6 +198,11 @@ StrandOrdering::StrandOrdering(char *in_seq, char *in_structure, char *in_cseq)
 		new_elem = NULL;
 	}
 
+	for (orderingList *traverse = first; traverse != NULL; traverse = traverse->next)
+		traverse->ordering = this;
+
+	computeHashes();
+
 }
 
 StrandOrdering::StrandOrdering(char *in_seq, char *in_structure, char *in_cseq, class identList *strandids) {
@@ -248,16 +278,31 @@ StrandOrdering::StrandOrdering(char *in_seq, char *in_structure, char *in_cseq,
 		}
 		new_elem = NULL;
 	}
+
+	for (orderingList *traverse = first; traverse != NULL; traverse = traverse->next)
+		traverse->ordering = this;
+
+	computeHashes();
 	delete strandids;
 }
 
 StrandOrdering * StrandOrdering::joinOrdering(StrandOrdering *first, StrandOrdering *second) {
 
+	for (orderingList *traverse = second->first; traverse != NULL; traverse = traverse->next)
+		traverse->ordering = first;
+
 	first->last->next = second->first;
 	second->first->prev = first->last;
 	first->last = second->last;
 
 	first->count += second->count;
+	first->clearDistances();
+	second->clearDistances();
+
+	first->structureHash ^= second->structureHash;
+	first->strandNameHash += second->strandNameHash;
+	first->pairNameHash += second->pairNameHash;
+	first->nameMask |= second->nameMask;
 
 	if (first->seq != NULL) {
 		delete[] first->seq;
@@ -274,7 +319,7 @@ StrandOrdering * StrandOrdering::joinOrdering(StrandOrdering *first, StrandOrder
 	second->first = NULL;
 	second->last = NULL;
 
-	first->openInfo.upToDate = false;
+	first->invalidateOpenInfo();
 
 	return first;
 }
@@ -385,31 +430,112 @@ OpenLoop *StrandOrdering::checkIDList(class identList * stoplist, int id_count)
 
 }
 
-/*
+// as checkIDList, but the rotation must also have the dot-paren structure of
+// the stop complex. The structure is rebuilt from the pairs for each rotation
+// that has the right names.
+OpenLoop *StrandOrdering::checkStructure(class identList *stoplist, int id_count, char *structure) {
 
- int StrandOrdering::checkIDBound( char *id )
+	if (id_count != count)
+		return NULL;
 
- */
+	vector<orderingList*> strands;
+	vector<int> offsets, partner;
+	int length = getPartners(strands, offsets, partner);
+
+	if ((int) strlen(structure) != length + count - 1)
+		return NULL;
 
-int StrandOrdering::checkIDBound(char *id) {
+	for (int rotation = 0; rotation < count; rotation++) {
 
-	orderingList *traverse = first;
+		class identList *id_traverse = stoplist;
+		bool same = true;
+
+		for (int loop = 0; same && loop < count; loop++, id_traverse = id_traverse->next)
+			same = strcmp(strands[(rotation + loop) % count]->thisTag, id_traverse->id) == 0;
+
+		// position is counted from the start of the rotated ordering, stop skips the '+'.
+		int position = 0;
+		char *stop = structure;
+
+		for (int loop = 0; same && loop < count; loop++) {
 
-	unsigned int loop;
-	int flag;
-	while (traverse != NULL) {
-		if (strcmp(traverse->thisTag, id) == 0) {
-			flag = 0;
-			for (loop = 0; loop < strlen(traverse->thisStruct) && (flag == 0); loop++)
-				if (traverse->thisStruct[loop] == '.')
-					flag = 1;
-
-			if (flag == 0)
-				return 1;
+			orderingList *strand = strands[(rotation + loop) % count];
+
+			if (loop > 0)
+				same = (*stop++ == '+');
+
+			for (int index = 0; same && index < strand->size; index++, position++, stop++) {
+
+				int base = offsets[(rotation + loop) % count] + index;
+				char expected = '.';
+
+				if (partner[base] >= 0) {
+					int other = (partner[base] - offsets[rotation] + length) % length;
+					expected = (other > position) ? '(' : ')';
+				}
+
+				same = (*stop == expected);
+			}
 		}
-		traverse = traverse->next;
+
+		if (same)
+			return strands[rotation]->thisLoop;
 	}
-	return 0;
+
+	return NULL;
+
+}
+
+// the distance is built the first time a stop complex is checked, and then kept up to date.
+OpenLoop *StrandOrdering::checkDistance(class complexItem *stopitem) {
+
+	for (unsigned int loop = 0; loop < distances.size(); loop++)
+		if (distances[loop]->item == stopitem)
+			return distances[loop]->check();
+
+	distances.push_back(new StopDistance(stopitem, this));
+	return distances.back()->check();
+
+}
+
+void StrandOrdering::clearDistances(void) {
+
+	for (unsigned int loop = 0; loop < distances.size(); loop++)
+		delete distances[loop];
+
+	distances.clear();
+
+}
+
+// the strands in order, where each starts in the flat sequence without breaks,
+// and the partner of each base there (-1 if unpaired). Returns the length.
+int StrandOrdering::getPartners(vector<orderingList*> &strands, vector<int> &offsets, vector<int> &partner) {
+
+	int length = 0;
+
+	for (orderingList *traverse = first; traverse != NULL; traverse = traverse->next) {
+		strands.push_back(traverse);
+		offsets.push_back(length);
+		length += traverse->size;
+	}
+
+	partner.assign(length, -1);
+	vector<int> open;
+
+	for (unsigned int loop = 0; loop < strands.size(); loop++) {
+		for (int index = 0; index < strands[loop]->size; index++) {
+			if (strands[loop]->thisStruct[index] == '(') {
+				open.push_back(offsets[loop] + index);
+			} else if (strands[loop]->thisStruct[index] == ')') {
+				partner[offsets[loop] + index] = open.back();
+				partner[open.back()] = offsets[loop] + index;
+				open.pop_back();
+			}
+		}
+	}
+
+	return length;
+
 }
 
 // void generateFlatSequence( char **sequence, char **structure, char **code_sequence
@@ -423,7 +549,7 @@ void StrandOrdering::generateFlatSequence(char **sequence, char **structure, cha
 	int cpos = 0;
 	orderingList *traverse = first;
 
-	openInfo.upToDate = false;
+	invalidateOpenInfo();
 
 	for (index = 0; index < count; index++, traverse = traverse->next){
 		totallength += traverse->size;
@@ -546,7 +672,7 @@ OpenLoop* StrandOrdering::getIndex(JoinCriteria& crit, int site, char **location
 
 			assert(traverse->thisLoop != NULL);
 
-			map<HalfContext, BaseCount>& myTally = traverse->thisLoop->getOpenInfo().tally;
+			BaseCount& baseCount = traverse->thisLoop->getOpenInfo().tally[crit.half[site].getIndex()];
 
 //			if (!myTally.count(crit.half[site])) {
 //
@@ -588,28 +714,22 @@ OpenLoop* StrandOrdering::getIndex(JoinCriteria& crit, int site, char **location
 //
 //			}
 
-			if (myTally.count(crit.half[site])) { // FD: there is at least one of the correct type in this openLoop
-
-				BaseCount& baseCount = myTally.find(crit.half[site])->second;
+			if (*index < baseCount.count[(int) type]) {
 
-				if (*index < baseCount.count[type]) {
+				if (utility::debugTraces) {
 
-					if (utility::debugTraces) {
+					cout << traverse->thisLoop->toString() << endl;
 
-						cout << traverse->thisLoop->toString() << endl;
-
-					}
-
-					*location = traverse->thisLoop->getBase(type, *index, crit.half[site]);
+				}
 
+				*location = traverse->thisLoop->getBase(type, *index, crit.half[site]);
 
-					return traverse->thisLoop;
 
-				} else {
+				return traverse->thisLoop;
 
-					*index = *index - baseCount.count[type];
+			} else {
 
-				}
+				*index = *index - baseCount.count[(int) type];
 
 			}
 
@@ -627,7 +747,7 @@ OpenLoop* StrandOrdering::getIndex(JoinCriteria& crit, int site, char **location
 
 void StrandOrdering::addOpenLoop(OpenLoop *newLoop, int index) {
 
-	openInfo.upToDate = false;
+	invalidateOpenInfo();
 
 	int cpos, cstrand;
 	orderingList *traverse;
@@ -653,7 +773,7 @@ StrandOrdering *StrandOrdering::breakOrdering(Loop *firstOldBreak, Loop *secondO
 	orderingList *temp = NULL, *temp2 = NULL, *traverse, *extra = NULL;
 	StrandOrdering *newOrdering;
 
-	openInfo.upToDate = false;
+	invalidateOpenInfo();
 
 	int numitems = 0;
 	for (traverse = first; traverse != NULL; traverse = traverse->next) {
@@ -693,6 +813,18 @@ StrandOrdering *StrandOrdering::breakOrdering(Loop *firstOldBreak, Loop *secondO
 		count = count - numitems;
 	}
 
+	clearDistances();
+
+	// no pairs span the two parts, so what remains here is what the new part is not.
+	newOrdering->computeHashes();
+	structureHash ^= newOrdering->structureHash;
+	strandNameHash -= newOrdering->strandNameHash;
+	pairNameHash -= newOrdering->pairNameHash;
+
+	nameMask = 0;
+	for (traverse = first; traverse != NULL; traverse = traverse->next)
+		nameMask |= nameBit(traverse->nameHash);
+
 	if (seq != NULL) {
 		delete[] seq;
 		seq = NULL;
@@ -713,9 +845,7 @@ StrandOrdering *StrandOrdering::breakOrdering(Loop *firstOldBreak, Loop *secondO
 	return newOrdering;
 }
 
-char *StrandOrdering::getSequence(void) {
-	if (seq != NULL)
-		return seq;
+void StrandOrdering::flatten(void) {
 
 	int totallength = 0, index = 0, cpos = 0;
 	orderingList *traverse = first;
@@ -731,6 +861,7 @@ char *StrandOrdering::getSequence(void) {
 		strncpy(&(seq[cpos]), traverse->thisSeq, traverse->size);
 		strncpy(&(struc[cpos]), traverse->thisStruct, traverse->size);
 
+		traverse->offset = cpos;
 		cpos += traverse->size;
 
 		if (index != count - 1) {
@@ -743,38 +874,18 @@ char *StrandOrdering::getSequence(void) {
 		}
 	}
 
-	return seq;
 }
 
-char *StrandOrdering::getStructure(void) {
-	if (struc != NULL)
-		return struc;
-
-	int totallength = 0, index = 0, cpos = 0;
-	orderingList *traverse = first;
-	for (index = 0; index < count; index++, traverse = traverse->next)
-		totallength += traverse->size;
-	totallength += count - 1;
-	//  printf("Total sequence length w/breaks: %d\n",totallength);
-
-	seq = new char[totallength + 1];
-	struc = new char[totallength + 1];
-
-	for (index = 0, cpos = 0, traverse = first; index < count; index++, traverse = traverse->next) {
-		strncpy(&(seq[cpos]), traverse->thisSeq, traverse->size);
-		strncpy(&(struc[cpos]), traverse->thisStruct, traverse->size);
+char *StrandOrdering::getSequence(void) {
+	if (seq == NULL)
+		flatten();
 
-		cpos += traverse->size;
+	return seq;
+}
 
-		if (index != count - 1) {
-			seq[cpos] = '+';
-			struc[cpos] = '+';
-			cpos++;
-		} else {
-			seq[cpos] = '\0';
-			struc[cpos] = '\0';
-		}
-	}
+char *StrandOrdering::getStructure(void) {
+	if (struc == NULL)
+		flatten();
 
 	return struc;
 }
@@ -813,7 +924,7 @@ Loop *StrandOrdering::getLoop(void) {
 
 void StrandOrdering::replaceOpenLoop(Loop *oldLoop, Loop *newLoop) {
 
-	openInfo.upToDate = false;
+	invalidateOpenInfo();
 
 	orderingList *traverse = NULL;
 	for (traverse = first; traverse != NULL; traverse = traverse->next) {
@@ -844,6 +955,19 @@ BaseCount& StrandOrdering::getExteriorBases() {
 	return exteriorBases;
 }
 
+void StrandOrdering::invalidateOpenInfo(void) {
+
+	openInfo.upToDate = false;
+	openVersion++;
+
+}
+
+uint64_t StrandOrdering::getOpenVersion(void) {
+
+	return openVersion;
+
+}
+
 OpenInfo& StrandOrdering::getOpenInfo(void) {
 
 	if (openInfo.upToDate) {
@@ -899,11 +1023,16 @@ void StrandOrdering::addBasepair(char *first_bp, char *second_bp) {
 	char *temp;
 	orderingList *traverse = NULL;
 	int iflag = 0;
+	orderingList *hit[2] = { NULL, NULL }; // the strands holding the two bases, for patching struc
+	int hitIndex[2] = { 0, 0 };
+	int hits = 0;
 
-	openInfo.upToDate = false;
+	invalidateOpenInfo();
 
 	for (traverse = first; traverse != NULL; traverse = traverse->next, iflag = 0) {
 		if (((first_bp - traverse->thisCodeSeq) < traverse->size) && ((first_bp - traverse->thisCodeSeq) >= 0)) {
+			hit[hits] = traverse;
+			hitIndex[hits++] = first_bp - traverse->thisCodeSeq;
 			if (id[0] == NULL)
 				id[0] = &traverse->thisStruct[first_bp - traverse->thisCodeSeq];
 			else
@@ -911,6 +1040,8 @@ void StrandOrdering::addBasepair(char *first_bp, char *second_bp) {
 			iflag = 1;
 		}
 		if (((second_bp - traverse->thisCodeSeq) < traverse->size) && ((second_bp - traverse->thisCodeSeq) >= 0)) {
+			hit[hits] = traverse;
+			hitIndex[hits++] = second_bp - traverse->thisCodeSeq;
 			if (id[0] == NULL)
 				id[0] = &traverse->thisStruct[second_bp - traverse->thisCodeSeq];
 			else {
@@ -926,13 +1057,19 @@ void StrandOrdering::addBasepair(char *first_bp, char *second_bp) {
 	assert(*id[0] == '.' && *id[1] == '.');
 	*id[0] = '(';
 	*id[1] = ')';
-	if (seq != NULL) {
-		delete[] seq;
-		seq = NULL;
-	}
+	hit[0]->unpaired--;
+	hit[1]->unpaired--;
+
+	structureHash ^= pairKey(baseKey(hit[0]->uidHash, hitIndex[0]), baseKey(hit[1]->uidHash, hitIndex[1]));
+	pairNameHash += pairKey(baseKey(hit[0]->nameHash, hitIndex[0]), baseKey(hit[1]->nameHash, hitIndex[1]));
+
+	for (unsigned int loop = 0; loop < distances.size(); loop++)
+		distances[loop]->update(hit[0], hitIndex[0], hit[1], hitIndex[1], true);
+
+	// the sequence is unchanged, and the structure only at the two bases.
 	if (struc != NULL) {
-		delete[] struc;
-		struc = NULL;
+		for (int loop = 0; loop < hits; loop++)
+			struc[hit[loop]->offset + hitIndex[loop]] = hit[loop]->thisStruct[hitIndex[loop]];
 	}
 
 	return;
@@ -945,14 +1082,19 @@ void StrandOrdering::breakBasepair(char *first_bp, char *second_bp) {
 	char *temp = NULL;
 	orderingList *traverse = NULL;
 	int iflag = 0;
+	orderingList *hit[2] = { NULL, NULL }; // the strands holding the two bases, for patching struc
+	int hitIndex[2] = { 0, 0 };
+	int hits = 0;
 
-	openInfo.upToDate = false;
+	invalidateOpenInfo();
 
 	for (traverse = first; traverse != NULL; traverse = traverse->next, iflag = 0) {
 
 		traverse->thisLoop->openInfo.upToDate  = false;
 
 		if (((first_bp - traverse->thisCodeSeq) < traverse->size) && ((first_bp - traverse->thisCodeSeq) >= 0)) {
+			hit[hits] = traverse;
+			hitIndex[hits++] = first_bp - traverse->thisCodeSeq;
 			if (id[0] == NULL)
 				id[0] = &traverse->thisStruct[first_bp - traverse->thisCodeSeq];
 			else
@@ -960,6 +1102,8 @@ void StrandOrdering::breakBasepair(char *first_bp, char *second_bp) {
 			iflag = 1;
 		}
 		if (((second_bp - traverse->thisCodeSeq) < traverse->size) && ((second_bp - traverse->thisCodeSeq) >= 0)) {
+			hit[hits] = traverse;
+			hitIndex[hits++] = second_bp - traverse->thisCodeSeq;
 			if (id[0] == NULL)
 				id[0] = &traverse->thisStruct[second_bp - traverse->thisCodeSeq];
 			else {
@@ -977,18 +1121,83 @@ void StrandOrdering::breakBasepair(char *first_bp, char *second_bp) {
 	assert((*id[0] == '(' && *id[1] == ')'));
 	*id[0] = '.';
 	*id[1] = '.';
-	if (seq != NULL) {
-		delete[] seq;
-		seq = NULL;
-	}
+	hit[0]->unpaired++;
+	hit[1]->unpaired++;
+
+	structureHash ^= pairKey(baseKey(hit[0]->uidHash, hitIndex[0]), baseKey(hit[1]->uidHash, hitIndex[1]));
+	pairNameHash -= pairKey(baseKey(hit[0]->nameHash, hitIndex[0]), baseKey(hit[1]->nameHash, hitIndex[1]));
+
+	for (unsigned int loop = 0; loop < distances.size(); loop++)
+		distances[loop]->update(hit[0], hitIndex[0], hit[1], hitIndex[1], false);
+
+	// the sequence is unchanged, and the structure only at the two bases.
 	if (struc != NULL) {
-		delete[] struc;
-		struc = NULL;
+		for (int loop = 0; loop < hits; loop++)
+			struc[hit[loop]->offset + hitIndex[loop]] = hit[loop]->thisStruct[hitIndex[loop]];
 	}
 
 	return;
 }
 
+uint64_t StrandOrdering::getStructureHash(void) {
+
+	return structureHash;
+
+}
+
+uint64_t StrandOrdering::getNameHash(void) {
+
+	return mixHash(strandNameHash) + pairNameHash;
+
+}
+
+uint64_t StrandOrdering::getNameMask(void) {
+
+	return nameMask;
+
+}
+
+// the strands in order form one nested structure, so the pairs are matched with a stack.
+void StrandOrdering::computeHashes(void) {
+
+	vector<std::pair<orderingList*, int> > open;
+
+	structureHash = strandNameHash = pairNameHash = nameMask = 0;
+
+	for (orderingList *traverse = first; traverse != NULL; traverse = traverse->next) {
+
+		structureHash ^= traverse->uidHash;
+		strandNameHash += traverse->nameHash;
+		nameMask |= nameBit(traverse->nameHash);
+
+		for (int index = 0; index < traverse->size; index++) {
+
+			if (traverse->thisStruct[index] == '(') {
+				open.push_back(std::make_pair(traverse, index));
+			} else if (traverse->thisStruct[index] == ')') {
+				assert(open.size() > 0);
+				orderingList *other = open.back().first;
+				int otherIndex = open.back().second;
+				open.pop_back();
+
+				structureHash ^= pairKey(baseKey(other->uidHash, otherIndex), baseKey(traverse->uidHash, index));
+				pairNameHash += pairKey(baseKey(other->nameHash, otherIndex), baseKey(traverse->nameHash, index));
+			}
+		}
+	}
+
+}
+
+bool StrandOrdering::verifyHashes(void) {
+
+	uint64_t hashes[4] = { structureHash, strandNameHash, pairNameHash, nameMask };
+
+	computeHashes();
+
+	return hashes[0] == structureHash && hashes[1] == strandNameHash && hashes[2] == pairNameHash && hashes[3] == nameMask;
+
+}
+
 int StrandOrdering::getStrandCount(void) {
 	return count;
 }
@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2017 California Institute of Technology. All rights reserved.
+Multistrand nucleic acid kinetic simulator
+help@multistrand.org
+*/
+
+#include "randomstream.h"
+
+// Philox4x32 constants
+const uint32_t PHILOX_M0 = 0xD2511F53;
+const uint32_t PHILOX_M1 = 0xCD9E8D57;
+const uint32_t PHILOX_W0 = 0x9E3779B9;
+const uint32_t PHILOX_W1 = 0xBB67AE85;
+const int PHILOX_ROUNDS = 10;
+
+// the third counter word separates the uniform streams from the seed derivation.
+const uint32_t DOMAIN_UNIFORM = 0;
+const uint32_t DOMAIN_SEED = 1;
+
+RandomStream::RandomStream(void) {
+
+	seed(0);
+
+}
+
+void RandomStream::seed(long seed) {
+
+	key[0] = (uint32_t) ((uint64_t) seed & 0xFFFFFFFF);
+	key[1] = (uint32_t) ((uint64_t) seed >> 32);
+	counter = 0;
+	position = RANDOMSTREAM_BATCH;
+
+}
+
+void RandomStream::block(const uint32_t counter[4], const uint32_t key[2], uint32_t output[4]) {
+
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+
+	for (int round = 0; round < PHILOX_ROUNDS; round++) {
+
+		uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+		uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+
+		c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+		c1 = (uint32_t) p1;
+		c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+		c3 = (uint32_t) p0;
+
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	output[0] = c0;
+	output[1] = c1;
+	output[2] = c2;
+	output[3] = c3;
+
+}
+
+// Each block gives two doubles with 53 random bits each.
+void RandomStream::refill(void) {
+
+	uint32_t input[4], output[4];
+
+	input[2] = DOMAIN_UNIFORM;
+	input[3] = 0;
+
+	for (int i = 0; i < RANDOMSTREAM_BATCH; i += 2) {
+
+		input[0] = (uint32_t) (counter & 0xFFFFFFFF);
+		input[1] = (uint32_t) (counter >> 32);
+		counter++;
+
+		block(input, key, output);
+
+		buffer[i] = ((output[0] >> 5) * 67108864.0 + (output[1] >> 6)) * (1.0 / 9007199254740992.0);
+		buffer[i + 1] = ((output[2] >> 5) * 67108864.0 + (output[3] >> 6)) * (1.0 / 9007199254740992.0);
+	}
+
+	position = 0;
+
+}
+
+long RandomStream::trajectorySeed(long initialSeed, long index) {
+
+	if (index == 0)
+		return initialSeed;
+
+	uint32_t input[4], output[4], seedKey[2];
+
+	seedKey[0] = (uint32_t) ((uint64_t) initialSeed & 0xFFFFFFFF);
+	seedKey[1] = (uint32_t) ((uint64_t) initialSeed >> 32);
+
+	input[0] = (uint32_t) ((uint64_t) index & 0xFFFFFFFF);
+	input[1] = (uint32_t) ((uint64_t) index >> 32);
+	input[2] = DOMAIN_SEED;
+	input[3] = 0;
+
+	block(input, seedKey, output);
+
+	// non-negative and 31 bits, like the seeds lrand48 used to give.
+	return (long) (output[0] & 0x7FFFFFFF);
+
+}
@@ -70,6 +70,19 @@ PSimOptions::PSimOptions(PyObject* input) :
 	getLongAttr(python_settings, use_stop_conditions, &stop_options);
 	getDoubleAttr(python_settings, simulation_time, &max_sim_time);
 
+	// optional, older python option objects do not carry this setting.
+	if (python_settings != NULL && PyObject_HasAttrString(python_settings, "use_move_tree")) {
+		getBoolAttr(python_settings, use_move_tree, &useMoveTree);
+	}
+
+	if (python_settings != NULL && PyObject_HasAttrString(python_settings, "use_lazy_moves")) {
+		getBoolAttr(python_settings, use_lazy_moves, &useLazyMoves);
+	}
+
+	if (python_settings != NULL && PyObject_HasAttrString(python_settings, "num_threads")) {
+		getLongAttr(python_settings, num_threads, &num_threads);
+	}
+
 	debug = false;	// this is the main switch for simOptions debug, for now.
 
 }
@@ -86,6 +99,9 @@ string SimOptions::toString() {
 	ss << "stop_count = " << stop_count << " \n";
 	ss << "max_sim_time = " << max_sim_time << " \n";
 	ss << "seed = " << seed << " \n";
+	ss << "useMoveTree = " << useMoveTree << " \n";
+	ss << "useLazyMoves = " << useLazyMoves << " \n";
+	ss << "num_threads = " << num_threads << " \n";
 
 //	ss << "myComplexes = { ";
 //
@@ -178,6 +194,24 @@ bool SimOptions::usingArrhenius(void) {
 
 }
 
+bool SimOptions::usingMoveTree(void) {
+
+	return useMoveTree;
+
+}
+
+bool SimOptions::usingLazyMoves(void) {
+
+	return useLazyMoves;
+
+}
+
+long SimOptions::getThreadCount(void) {
+
+	return num_threads;
+
+}
+
 PyObject* PSimOptions::getPythonSettings() {
 
 	return python_settings;
@@ -7,15 +7,86 @@ help@multistrand.org
 #include "options.h"
 #include "ssystem.h"
 #include "simoptions.h"
+#include "energycache.h"
 
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
 #include <vector>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
-int noInitialMoves = 0;
-int timeOut = 0;
+std::atomic<int> noInitialMoves(0);
+std::atomic<int> timeOut(0);
+
+// Held around every call into python and every use of the shared options.
+// In threaded mode the workers run without the GIL, so they take it back here too.
+// Does nothing when the system is not threaded (mutex == NULL).
+class PythonGuard {
+public:
+	PythonGuard(std::recursive_mutex* mutex, bool needGIL) {
+
+		this->mutex = mutex;
+		this->needGIL = (mutex != NULL) && needGIL;
+
+		if (mutex != NULL)
+			mutex->lock();
+		if (this->needGIL)
+			state = PyGILState_Ensure();
+
+	}
+
+	~PythonGuard(void) {
+
+		if (needGIL)
+			PyGILState_Release(state);
+		if (mutex != NULL)
+			mutex->unlock();
+
+	}
+
+private:
+	std::recursive_mutex* mutex;
+	bool needGIL;
+	PyGILState_STATE state;
+};
+
+// Installs the energy model and the move modes of a system as the ones the loops
+// in this thread use, and puts back the previous ones (e.g. the model from
+// initialize_energy_model) on exit. Systems with different options can so run
+// side by side, each in its own threads.
+class EnergyModelScope {
+public:
+	EnergyModelScope(EnergyModel* model, SimOptions* options) {
+
+		previous = Loop::GetEnergyModel();
+		previousMoveTree = MoveContainer::useMoveTree;
+		previousLazyMoves = LazyMoves::useLazyMoves;
+
+		Loop::SetEnergyModel(model);
+
+		if (options != NULL) {
+			MoveContainer::useMoveTree = options->usingMoveTree();
+			LazyMoves::useLazyMoves = options->usingLazyMoves();
+		}
+
+	}
+
+	~EnergyModelScope(void) {
+
+		Loop::SetEnergyModel(previous);
+		MoveContainer::useMoveTree = previousMoveTree;
+		LazyMoves::useLazyMoves = previousLazyMoves;
+
+	}
+
+private:
+	EnergyModel* previous;
+	bool previousMoveTree;
+	bool previousLazyMoves;
+};
 
 SimulationSystem::SimulationSystem(PyObject *system_o) {
 
@@ -47,17 +118,21 @@ void SimulationSystem::construct(void) {
 	simulation_mode = simOptions->getSimulationMode();
 	simulation_count_remaining = simOptions->getSimulationCount();
 
-	if (Loop::GetEnergyModel() == NULL) {
-		energyModel = NULL;
-		energyModel = new NupackEnergyModel(simOptions->getPythonSettings());
-		Loop::SetEnergyModel(energyModel);
-	} else {
-		energyModel = Loop::GetEnergyModel();
-	}
+	// every system with options builds its own model, so that systems with
+	// different temperatures or salt do not share one.
+	energyModel = new NupackEnergyModel(simOptions->getPythonSettings());
+	ownsEnergyModel = true;
 
 	startState = NULL;
 	complexList = NULL;
 
+	// the stop conditions do not change between steps or trajectories, so
+	// we only build the linked lists from the python options once.
+	if (simOptions->getStopOptions() && simOptions->getStopCount() > 0) {
+		stopConditions = simOptions->getStopComplexes(0);
+		stopMatcher = new StopMatcher(stopConditions);
+	}
+
 	// move these to sim_settings
 	exportStatesInterval = (simOptions->getOInterval() >= 0);
 	exportStatesTime = (simOptions->getOTime() >= 0);
@@ -66,6 +141,32 @@ void SimulationSystem::construct(void) {
 
 
 
+SimulationSystem::SimulationSystem(SimulationSystem* parent) {
+
+	this->parent = parent;
+
+	system_options = parent->system_options;
+	simOptions = parent->simOptions;
+	energyModel = parent->energyModel;
+	ownsEnergyModel = false;
+	initial_seed = parent->initial_seed;
+	stopConditions = parent->stopConditions;
+	stopMatcher = parent->stopMatcher;
+
+	simulation_mode = parent->simulation_mode;
+	simulation_count_remaining = 0;
+
+	startState = NULL;
+	complexList = NULL;
+
+	exportStatesInterval = parent->exportStatesInterval;
+	exportStatesTime = parent->exportStatesTime;
+
+	callbackMutex = parent->callbackMutex;
+	releasedGIL = parent->releasedGIL;
+
+}
+
 SimulationSystem::SimulationSystem(void) {
 
 	std::cout << "Initializing SimulationSystem \n";
@@ -73,11 +174,9 @@ SimulationSystem::SimulationSystem(void) {
 	simulation_mode = -1;
 	simulation_count_remaining = -1;
 
-	if (Loop::GetEnergyModel() == NULL) {
-		energyModel = NULL;
-	} else {
-		energyModel = Loop::GetEnergyModel();
-	}
+	// borrows the model set by initialize_energy_model, if any.
+	energyModel = Loop::GetEnergyModel();
+	ownsEnergyModel = false;
 
 	system_options = NULL;
 	simOptions = NULL;
@@ -96,6 +195,18 @@ SimulationSystem::~SimulationSystem(void) {
 		delete complexList;
 	complexList = NULL;
 
+	// workers share the stop conditions of their parent.
+	if (stopConditions != NULL && parent == NULL)
+		delete stopConditions;
+	stopConditions = NULL;
+
+	if (stopMatcher != NULL && parent == NULL)
+		delete stopMatcher;
+	stopMatcher = NULL;
+
+	if (energyModel != NULL && ownsEnergyModel)
+		delete energyModel;
+
 // the remaining members are not our responsibility, we null them out
 // just in case something thread-unsafe happens.
 
@@ -106,9 +217,18 @@ SimulationSystem::~SimulationSystem(void) {
 
 void SimulationSystem::StartSimulation(void) {
 
+	EnergyModelScope scope(energyModel, simOptions);
+
+	// the cache counters are per thread, so count what this run adds to them.
+	long hits = EnergyCache::getHits();
+	long misses = EnergyCache::getMisses();
+	long bounds = LazyMoves::boundMisses;
+
 	InitializeRNG();
 
-	if (simulation_mode & SIMULATION_MODE_FLAG_FIRST_BIMOLECULAR) {
+	if (simOptions->getThreadCount() > 1 && simulation_count_remaining > 1) {
+		StartSimulation_Threaded();
+	} else if (simulation_mode & SIMULATION_MODE_FLAG_FIRST_BIMOLECULAR) {
 		StartSimulation_FirstStep();
 	} else if (simulation_mode & SIMULATION_MODE_FLAG_TRAJECTORY) {
 		StartSimulation_Trajectory();
@@ -117,10 +237,151 @@ void SimulationSystem::StartSimulation(void) {
 	} else
 		StartSimulation_Standard();
 
+	cacheHits += EnergyCache::getHits() - hits;
+	cacheMisses += EnergyCache::getMisses() - misses;
+	boundMisses += LazyMoves::boundMisses - bounds;
+
 	finalizeSimulation();
 
 }
 
+/*
+ Threaded mode: runs the trajectories on a pool of worker systems, one per thread.
+
+ The workers share the options, stop conditions and the (read-only) energy model,
+ and each has its own complex list and random stream. The stream of a trajectory
+ depends only on the initial seed and its index (see RandomStream), so each trajectory
+ is the same as in a serial run, but results are reported in the order they finish.
+ */
+
+void SimulationSystem::StartSimulation_Threaded(void) {
+
+	int threadCount = (int) std::min(simOptions->getThreadCount(), simulation_count_remaining);
+
+	std::recursive_mutex mutex;
+	callbackMutex = &mutex;
+	releasedGIL = (system_options != NULL);
+
+	vector<SimulationSystem*> workers;
+	for (int i = 0; i < threadCount; i++) {
+		workers.push_back(new SimulationSystem(this));
+	}
+
+	// release the GIL while the workers run; they re-acquire it for callbacks.
+	PyThreadState* pythonState = NULL;
+	if (releasedGIL) {
+		PyEval_InitThreads();
+		pythonState = PyEval_SaveThread();
+	}
+
+	vector<std::thread> threads;
+	for (int i = 0; i < threadCount; i++) {
+		threads.push_back(std::thread(&SimulationSystem::runWorker, workers[i]));
+	}
+
+	for (int i = 0; i < threadCount; i++) {
+		threads[i].join();
+	}
+
+	if (releasedGIL) {
+		PyEval_RestoreThread(pythonState);
+	}
+
+	if (!failedTrajectories.empty()) {
+
+		std::sort(failedTrajectories.begin(), failedTrajectories.end());
+
+		if (system_options != NULL && !PyErr_Occurred()) {
+			PyErr_Format(PyExc_RuntimeError, "Could not initialize trajectory %ld (%d failed); the remaining trajectories were not run.",
+					failedTrajectories[0], (int) failedTrajectories.size());
+		} else {
+			cout << "Could not initialize trajectory " << failedTrajectories[0] << "; the remaining trajectories were not run.\n";
+		}
+	}
+
+	for (int i = 0; i < threadCount; i++) {
+
+		for (std::pair<const uint64_t, int>& state : workers[i]->countMap) {
+			countMap[state.first] += state.second;
+		}
+
+		cacheHits += workers[i]->cacheHits;
+		cacheMisses += workers[i]->cacheMisses;
+		boundMisses += workers[i]->boundMisses;
+
+		delete workers[i];
+	}
+
+	callbackMutex = NULL;
+	releasedGIL = false;
+
+}
+
+// hands out the next trajectory index, or false when all trajectories are taken.
+bool SimulationSystem::nextTrajectory(long* index) {
+
+	std::lock_guard<std::recursive_mutex> lock(*callbackMutex);
+
+	if (simulation_count_remaining <= 0) {
+		return false;
+	}
+
+	simulation_count_remaining--;
+	*index = trajectory_index++;
+
+	return true;
+
+}
+
+// records a trajectory that could not be initialized, and stops handing out the others.
+void SimulationSystem::failTrajectory(long index) {
+
+	std::lock_guard<std::recursive_mutex> lock(*callbackMutex);
+
+	failedTrajectories.push_back(index);
+	simulation_count_remaining = 0;
+
+}
+
+void SimulationSystem::runWorker(void) {
+
+	EnergyModelScope scope(energyModel, simOptions);
+	long index;
+
+	long hits = EnergyCache::getHits();
+	long misses = EnergyCache::getMisses();
+	long bounds = LazyMoves::boundMisses;
+
+	while (parent->nextTrajectory(&index)) {
+
+		startTrajectory(index);
+
+		if (InitializeSystem() != 0) {
+			parent->failTrajectory(index);
+			break;
+		}
+
+		if (simulation_mode & SIMULATION_MODE_FLAG_FIRST_BIMOLECULAR) {
+			SimulationLoop_FirstStep();
+		} else if (simulation_mode & SIMULATION_MODE_FLAG_TRAJECTORY) {
+			SimulationLoop_Trajectory();
+		} else if (simulation_mode & SIMULATION_MODE_FLAG_TRANSITION) {
+			SimulationLoop_Transition();
+		} else {
+			SimulationLoop_Standard();
+		}
+
+		PythonGuard guard(callbackMutex, releasedGIL);
+		pingAttr(system_options, increment_trajectory_count);
+
+	}
+
+	cacheHits = EnergyCache::getHits() - hits;
+	cacheMisses = EnergyCache::getMisses() - misses;
+	boundMisses = LazyMoves::boundMisses - bounds;
+
+}
+
 void SimulationSystem::StartSimulation_FirstStep(void) {
 
 	while (simulation_count_remaining > 0) {
@@ -191,6 +452,12 @@ void SimulationSystem::finalizeSimulation(void) {
 		cout << "No initial moves for this first step simulation x" << noInitialMoves << "\n";
 	}
 
+	if (boundMisses > 0) {
+
+		cout << "Grouped creation moves above their bound, made exact x" << boundMisses << "\n";
+
+	}
+
 	if (timeOut > 0) {
 
 		cout << "time-out detected x" << timeOut << "\n";
@@ -204,6 +471,12 @@ void SimulationSystem::finalizeSimulation(void) {
 
 	}
 
+	if (SimOptions::countCacheHits) {
+
+		cout << "Energy cache hits " << cacheHits << ", misses " << cacheMisses << "\n";
+
+	}
+
 	cout << flush;
 }
 
@@ -223,10 +496,12 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 
 	rate = complexList->getTotalFlux();
 
+	first = stopConditions;
+
 	do {
 
-		rchoice = rate * drand48();
-		stime += (log(1. / (1.0 - drand48())) / rate);
+		rchoice = rate * rng.uniform();
+		stime += (log(1. / (1.0 - rng.uniform())) / rate);
 
 		// 1.0 - drand as drand returns in the [0.0, 1.0) range, we need a (0.0,1.0] range.
 		// see notes below in First Step mode.
@@ -247,7 +522,12 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 			// FD: Mathematically it is also the correct thing to do,
 			// FD: when we remember the memoryless property of the Markov chain
 
-			(void) complexList->doBasicChoice(rchoice, stime);
+			// a rejected grouped move leaves the state as it was, and the flux
+			// too unless its group was made exact.
+			if (complexList->doBasicChoice(rchoice, stime) == MOVE_REJECTED) {
+				rate = complexList->getTotalFlux();
+				continue;
+			}
 
 			///Add the state to the hashmap counter
 			this->countState(complexList);
@@ -257,30 +537,25 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 			if (stopoptions) {
 
 				if (stopcount <= 0) {
+					PythonGuard guard(callbackMutex, releasedGIL);
 					simOptions->stopResultError(current_seed);
 					return;
 				}
 
 				checkresult = false;
-				first = simOptions->getStopComplexes(0);
-				checkresult = complexList->checkStopComplexList(first->citem);
+				checkresult = complexList->checkStopCondition(0, first->citem);
 				traverse = first;
 
-				while (traverse->next != NULL && !checkresult) {
+				for (int idx = 1; traverse->next != NULL && !checkresult; idx++) {
 					traverse = traverse->next;
-					checkresult = complexList->checkStopComplexList(traverse->citem);
-				}
-				// Note: we cannot delete first here if checkresult != 0,
-				// as traverse->tag may be needed. It will get checked at
-				// that point and deleted once traverse->tag is used,
-				// later.
-				if (!checkresult) {
-					delete first;
+					checkresult = complexList->checkStopCondition(idx, traverse->citem);
 				}
 			}
 		}
 	} while (stime < maxsimtime && !checkresult);
 
+	PythonGuard guard(callbackMutex, releasedGIL);
+
 	if (stime == NAN) {
 
 		simOptions->stopResultNan(current_seed);
@@ -289,7 +564,6 @@ void SimulationSystem::SimulationLoop_Standard(void) {
 
 		dumpCurrentStateToPython();
 		simOptions->stopResultNormal(current_seed, stime, traverse->tag);
-		delete first;
 
 	} else { // stime >= maxsimtime
 
@@ -303,17 +577,8 @@ void SimulationSystem::countState(SComplexList* complexList) {
 
 	if (SimOptions::countStates) {
 
-		string myComplex = complexList->toString();
-
-		if (countMap.count(myComplex) == 0) {
-
-			countMap[myComplex] = 1;
-
-		} else {
-
-			countMap[myComplex]++;
-
-		}
+		// the hash is kept current by the moves, no strings are built.
+		countMap[complexList->getStateHash()]++;
 
 	}
 
@@ -345,10 +610,11 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 
 	if (stopoptions) {
 		if (stopcount <= 0) {
+			PythonGuard guard(callbackMutex, releasedGIL);
 			simOptions->stopResultError(current_seed);
 			return;
 		}
-		first = simOptions->getStopComplexes(0);
+		first = stopConditions;
 	}
 
 	// write the initial state:
@@ -358,8 +624,8 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 
 	do {
 
-		rchoice = rate * drand48();
-		stime += (log(1. / (1.0 - drand48())) / rate);
+		rchoice = rate * rng.uniform();
+		stime += (log(1. / (1.0 - rng.uniform())) / rate);
 		// 1.0 - drand as drand returns in the [0.0, 1.0) range, we need a (0.0,1.0] range.
 		// see notes below in First Step mode.
 
@@ -374,6 +640,10 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 		}
 
 		int ArrMoveType = complexList->doBasicChoice(rchoice, stime);
+		if (ArrMoveType == MOVE_REJECTED) {
+			rate = complexList->getTotalFlux();
+			continue;
+		}
 		rate = complexList->getTotalFlux();
 		current_state_count += 1;
 
@@ -383,16 +653,18 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 
 		if (stopoptions) {
 			stopFlag = false;
-			stopFlag = complexList->checkStopComplexList(first->citem);
+			stopFlag = complexList->checkStopCondition(0, first->citem);
 			traverse = first;
-			while (traverse->next != NULL && !stopFlag) {
+			for (int idx = 1; traverse->next != NULL && !stopFlag; idx++) {
 				traverse = traverse->next;
-				stopFlag = complexList->checkStopComplexList(traverse->citem);
+				stopFlag = complexList->checkStopCondition(idx, traverse->citem);
 			}
 		}
 
 	} while (stime < maxsimtime && !stopFlag);
 
+	PythonGuard guard(callbackMutex, releasedGIL);
+
 	if (stime == NAN) {
 
 		simOptions->stopResultNan(current_seed);
@@ -406,10 +678,6 @@ void SimulationSystem::SimulationLoop_Trajectory() {
 		simOptions->stopResultTime(current_seed, stime);
 
 	}
-
-	if (first != NULL) {
-		delete first;
-	}
 }
 
 void SimulationSystem::SimulationLoop_Transition(void) {
@@ -432,6 +700,7 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 
 	if (stopcount <= 0 || !stopoptions) {
 		// this simulation mode MUST have some stop conditions set.
+		PythonGuard guard(callbackMutex, releasedGIL);
 		simOptions->stopResultError(current_seed);
 		return;
 	}
@@ -446,19 +715,18 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 
 	complexList->initializeList();
 
-	first = simOptions->getStopComplexes(0);
+	first = stopConditions;
 	traverse = first;
 	checkresult = false;
 	for (int idx = 0; idx < stopcount; idx++) {
 		if (strstr(traverse->tag, "stop:") == traverse->tag)
 			stop_entries[idx] = true;
 
-		checkresult = complexList->checkStopComplexList(traverse->citem);
+		checkresult = complexList->checkStopCondition(idx, traverse->citem);
 
 		transition_states[idx] = checkresult;
 		traverse = traverse->next;
 	}
-	delete first;
 	sendTransitionStateVectorToPython(transition_states, stime);
 // start
 
@@ -467,29 +735,32 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 	stopFlag = false;
 	do {
 
-		rchoice = rate * drand48();
-		stime += (log(1. / (1.0 - drand48())) / rate);
+		rchoice = rate * rng.uniform();
+		stime += (log(1. / (1.0 - rng.uniform())) / rate);
 		// 1.0 - drand as drand returns in the [0.0, 1.0) range, we need a (0.0,1.0] range.
 		// see notes below in First Step mode.
 
 		if (stime < maxsimtime) {
 			// See note in SimulationLoop_Standard
 
-			complexList->doBasicChoice(rchoice, stime);
+			if (complexList->doBasicChoice(rchoice, stime) == MOVE_REJECTED) {
+				rate = complexList->getTotalFlux();
+				continue;
+			}
 			rate = complexList->getTotalFlux();
 
 			// check if our transition state membership vector has changed
 			checkresult = false;
-			first = simOptions->getStopComplexes(0);
 			traverse = first;
 			for (int idx = 0; idx < stopcount; idx++) {
 
-				checkresult = complexList->checkStopComplexList(traverse->citem);
+				checkresult = complexList->checkStopCondition(idx, traverse->citem);
 
 				if (checkresult && stop_entries[idx] == true) {
 					// multiple stop states could suddenly be true, we add
 					// a status line entry for the first one found.
 					if (!stopFlag) {
+						PythonGuard guard(callbackMutex, releasedGIL);
 						simOptions->stopResultNormal(current_seed, stime, traverse->tag);
 					}
 
@@ -503,10 +774,6 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 				transition_states[idx] = checkresult;
 				traverse = traverse->next;
 			}
-			delete first; // we can do this now as we no longer need to
-						  // save the stoplist until the loop exits, due
-						  // to moving printStatusLine to immediately upon
-						  // finding the stopping condition.
 			if (state_changed) {
 				sendTransitionStateVectorToPython(transition_states, stime);
 				state_changed = false;
@@ -514,6 +781,8 @@ void SimulationSystem::SimulationLoop_Transition(void) {
 		}
 	} while (stime < maxsimtime && !stopFlag);
 
+	PythonGuard guard(callbackMutex, releasedGIL);
+
 	if (stime == NAN) {
 
 		simOptions->stopResultNan(current_seed);
@@ -560,12 +829,13 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 
 		noInitialMoves++;
 
+		PythonGuard guard(callbackMutex, releasedGIL);
 		simOptions->stopResultBimolecular("NoMoves", current_seed, 0.0, 0.0,
 		NULL);
 		return;
 	}
 
-	rchoice = rate * drand48();
+	rchoice = rate * rng.uniform();
 
 	int ArrMoveType = complexList->doJoinChoice(rchoice);
 
@@ -587,11 +857,12 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 
 // Begin normal steps.
 	rate = complexList->getTotalFlux();
+	first = stopConditions;
 
 	do {
 
-		rchoice = rate * drand48();
-		stime += (log(1. / (1.0 - drand48())) / rate);
+		rchoice = rate * rng.uniform();
+		stime += (log(1. / (1.0 - rng.uniform())) / rate);
 
 		if (debugTraces) {
 			cout << "Printing my complexlist! *************************************** \n";
@@ -604,6 +875,10 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 		}
 
 		int ArrMoveType = complexList->doBasicChoice(rchoice, stime);
+		if (ArrMoveType == MOVE_REJECTED) {
+			rate = complexList->getTotalFlux();
+			continue;
+		}
 
 		rate = complexList->getTotalFlux();
 		current_state_count++;
@@ -615,28 +890,25 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 		if (stopcount > 0 && stopoptions) {
 
 			stopFlag = false;
-			first = simOptions->getStopComplexes(0);
 			traverse = first;
-			stopFlag = complexList->checkStopComplexList(traverse->citem);
+			stopFlag = complexList->checkStopCondition(0, traverse->citem);
 
-			while (traverse->next != NULL && !stopFlag) {
+			for (int idx = 1; traverse->next != NULL && !stopFlag; idx++) {
 				traverse = traverse->next;
-				stopFlag = complexList->checkStopComplexList(traverse->citem);
+				stopFlag = complexList->checkStopCondition(idx, traverse->citem);
 			}
-
-			if (!stopFlag && first != NULL)
-				delete first;
 		}
 
 	} while (stime < maxsimtime && !stopFlag);
 
+	PythonGuard guard(callbackMutex, releasedGIL);
+
 	if (stopFlag) {
 		dumpCurrentStateToPython();
 		if (strcmp(traverse->tag, "REVERSE") == 0)
 			simOptions->stopResultBimolecular("Reverse", current_seed, stime, frate, traverse->tag);
 		else
 			simOptions->stopResultBimolecular("Forward", current_seed, stime, frate, traverse->tag);
-		delete first;
 	} else {
 		timeOut++;
 		dumpCurrentStateToPython();
@@ -652,6 +924,7 @@ void SimulationSystem::SimulationLoop_FirstStep(void) {
 // Helper function to send current state to python side. //
 ///////////////////////////////////////////////////////////
 void SimulationSystem::dumpCurrentStateToPython(void) {
+	PythonGuard guard(callbackMutex, releasedGIL);
 	int id;
 	char *names, *sequence, *structure;
 	double energy;
@@ -672,6 +945,7 @@ void SimulationSystem::dumpCurrentStateToPython(void) {
 /////////////////////////////////////////////////////////////////////////////////////
 
 void SimulationSystem::sendTransitionStateVectorToPython(boolvector transition_states, double current_time) {
+	PythonGuard guard(callbackMutex, releasedGIL);
 	PyObject *mylist = PyList_New((Py_ssize_t) transition_states.size());
 // we now have a new reference here that we'll need to DECREF.
 
@@ -717,6 +991,7 @@ void SimulationSystem::sendTransitionStateVectorToPython(boolvector transition_s
 ///////////////////////////////////////////////////////////
 
 void SimulationSystem::sendTrajectory_CurrentStateToPython(double current_time, int arrType) {
+	PythonGuard guard(callbackMutex, releasedGIL);
 	int id;
 	char *names, *sequence, *structure;
 	double energy;
@@ -742,6 +1017,9 @@ int SimulationSystem::InitializeSystem(PyObject *alternate_start) {
 	class StrandComplex *tempcomplex;
 	class identList *id;
 
+	// the generated complexes are stored in the shared options, so hold on until we copied them.
+	PythonGuard guard(callbackMutex, releasedGIL);
+
 	simOptions->generateComplexes(alternate_start, current_seed);
 
 // FD: Somehow, check if complex list is pre-populated.
@@ -750,6 +1028,7 @@ int SimulationSystem::InitializeSystem(PyObject *alternate_start) {
 		delete complexList;
 
 	complexList = new SComplexList(energyModel);
+	complexList->stopMatcher = stopMatcher;
 
 // FD: this is the python - C interface
 	for (unsigned int i = 0; i < simOptions->myComplexes->size(); i++) {
@@ -793,19 +1072,29 @@ void SimulationSystem::InitializeRNG(void) {
 			current_seed = time(NULL);
 		}
 	}
-// now initialize this generator using our random seed, so that we can reproduce as necessary.
-	srand48(current_seed);
+// now initialize the first stream using our random seed, so that we can reproduce as necessary.
+	initial_seed = current_seed;
+	trajectory_index = 0;
+	startTrajectory(0);
+}
+
+// the stream of trajectory index depends only on the initial seed and the index.
+void SimulationSystem::startTrajectory(long index) {
+	current_seed = RandomStream::trajectorySeed(initial_seed, index);
+	rng.seed(current_seed);
 }
 
 void SimulationSystem::generateNextRandom(void) {
-	current_seed = lrand48();
-	srand48(current_seed);
+	trajectory_index++;
+	startTrajectory(trajectory_index);
 }
 
 PyObject *SimulationSystem::calculateEnergy(PyObject *start_state, int typeflag) {
 	double *values = NULL;
 	PyObject *retval = NULL;
 
+	EnergyModelScope scope(energyModel, simOptions);
+
 // calc based on current state, do not clean up anything.
 	if (start_state != Py_None) {
 		InitializeSystem(start_state);
@@ -830,7 +1119,10 @@ void SimulationSystem::printTransition(double input) {
 
 	cout << "Using RNG =" << input;
 	Move* myMove = startState->getChoice(&input);
-	cout << ", we selected move: \n " << myMove->toString(simOptions->energyOptions) << " \n ";
+	if (myMove == NULL)
+		cout << ", we selected a rejected grouped move \n ";
+	else
+		cout << ", we selected move: \n " << myMove->toString(simOptions->energyOptions) << " \n ";
 
 }
 
@@ -871,6 +1163,8 @@ void SimulationSystem::printAllMoves() {
 // FD: a simple peak into the initial state
 void SimulationSystem::InitialInfo(void) {
 
+	EnergyModelScope scope(energyModel, simOptions);
+
 	if (InitializeSystem() != 0) {
 		return;
 	}
@@ -20,6 +20,10 @@ except ImportError:
 
 import unittest
 import warnings
+import hashlib
+import glob
+import shutil
+import tempfile
 # for IPython, some of the IPython libs used by unittest have a
 # deprecated usage of BaseException, so we turn that specific warning
 # off.
@@ -247,6 +251,284 @@ class MI_System_Object_TestCase(unittest.TestCase):
         MI_System_Object_TestCase.str_run_system_several_times += "Third run results [yet another system]:\n{0}\n".format(str(self.options.interface))
 
 
+def runSeeded(start, stops=[], mode="Trajectory", num=10, time=1e-4, seed=5, **settings):
+    """ Runs num seeded trajectories from the start complexes and returns the options,
+    which hold the results and the end states. The settings are set on the options. """
+    o = Options(simulation_mode=mode, num_simulations=num, simulation_time=time,
+                rate_method="Metropolis", dangles="Some", temperature=25.0, verbosity=0,
+                bimolecular_scaling=1e6, unimolecular_scaling=5e6)
+    o.start_state = start
+    if stops:
+        o.stop_conditions = stops
+    o.initial_seed = seed
+    for name, value in settings.items():
+        setattr(o, name, value)
+
+    SimSystem(o).start()
+    return o
+
+
+def strandNames(c):
+    """ The strand names of an end state complex, leaving out the strand ids, which count up
+    over all the strands made. """
+    return ",".join(n.split(":")[1] for n in c[2].split(","))
+
+
+def endStates(o):
+    """ The final complexes of each trajectory, in the order of the seeds, as strand names:structure. """
+    return [" ".join(sorted("%s:%s" % (strandNames(c), c[4]) for c in state))
+            for state in sorted(o.interface.end_states, key=lambda state: state[0][0])]
+
+
+class MI_StopMatcher_TestCase(unittest.TestCase):
+    """ Structure stop conditions are matched in any rotation of the complex.
+
+    """
+    def runSeeds(self, stopStrands, stopType=0, count=0):
+        x = Domain(name="x", sequence="GCATGCA")
+        y = Domain(name="y", sequence="TTCAGGC")
+        z = Domain(name="z", sequence="ACGTCAG")
+        a = Strand(name="a", domains=[x, y])
+        b = Strand(name="b", domains=[y.C, z])
+        c = Strand(name="c", domains=[z.C, x.C])
+        strands = {"a": a, "b": b, "c": c}
+
+        stop = Complex(strands=[strands[s] for s in stopStrands], structure="((+)(+))")
+        start = [Complex(strands=[a, b], structure=".(+)."), Complex(strands=[c], structure="..")]
+
+        o = runSeeded(start, [StopCondition("junction", [(stop, stopType, count)])], mode="Normal")
+        return sorted((r.seed, r.tag, r.time) for r in o.interface.results), endStates(o)
+
+    def junctions(self, results):
+        """ Checks that all rotations stop the same trajectories, and that the others end
+        the same. Returns the stopped complexes of each rotation, as strand names:structure. """
+        junctions = {}
+
+        for order, (outcomes, states) in results.items():
+            self.assertEqual(outcomes, results["abc"][0])
+            self.assertEqual(len(states), len(outcomes))
+            junctions[order] = []
+
+            for (seed, tag, time), state, first in zip(outcomes, states, results["abc"][1]):
+                if tag == "junction":
+                    junctions[order] += [c for c in state.split(" ") if sorted(c.split(":")[0].split(",")) == ["a", "b", "c"]]
+                else:
+                    self.assertEqual(state, first)
+
+        self.assertTrue(len(junctions["abc"]) > 0)
+        return junctions
+
+    def test_rotations(self):
+        """ Test [StopMatcher]: Give the stop complex of a three-way junction in each of its rotations
+
+        Matching rotates only the complex that matches, so all runs take the same trajectories,
+        and each stops in the junction given in the order of its stop complex."""
+        results = dict((order, self.runSeeds(order)) for order in ["abc", "bca", "cab"])
+
+        for order, junctions in self.junctions(results).items():
+            for junction in junctions:
+                self.assertEqual(junction, ",".join(order) + ":" + "(" * 14 + "+" + ")" * 7 + "(" * 7 + "+" + ")" * 14)
+
+    def test_distance_rotations(self):
+        """ Test [StopMatcher]: Give count and loose stop complexes in each of their rotations
+
+        The distances are kept for each rotation, and also leave the complex as it is until it
+        matches. All bases pair in the junction, so the stopped complexes have at most 4 unpaired."""
+        for stopType in [3, 4]:
+            results = dict((order, self.runSeeds(order, stopType, 4)) for order in ["abc", "bca", "cab"])
+
+            for order, junctions in self.junctions(results).items():
+                for junction in junctions:
+                    names, structure = junction.split(":")
+                    self.assertEqual(names, ",".join(order))
+                    self.assertTrue(structure.count(".") <= 4)
+
+    def test_disassoc_order(self):
+        """ Test [StopMatcher]: Stop on a DISASSOC complex that several complexes match
+
+        As the scan over the complexes did, the first matching complex in list order is
+        rotated to the strand order of the stop complex, and the others are left as they are."""
+        x = Domain(name="x", sequence="GCATGCATTCAGGCATCCAG")
+        start = [Complex(strands=[Strand(name="b", domains=[x.C]), Strand(name="a", domains=[x])], structure="(+)")
+                 for copy in range(3)]
+        stop = Complex(strands=[Strand(name="a", domains=[x]), Strand(name="b", domains=[x.C])], structure="(+)")
+
+        o = runSeeded(start, [StopCondition("apart", [(stop, 2, 0)])], mode="Normal", num=3, seed=3)
+
+        self.assertEqual([r.tag for r in o.interface.results], ["apart"] * 3)
+        for state in o.interface.end_states:
+            self.assertEqual([strandNames(c) for c in state], ["a,b", "b,a", "b,a"])
+
+
+class MI_RandomStreams_TestCase(unittest.TestCase):
+    """ Each trajectory draws from its own random stream, given by the seed and its index.
+
+    """
+    def runStreams(self, num, threads):
+        x = Domain(name="x", sequence="GCATGCATTCAGGCATCCAGTT")
+        a = Strand(name="a", domains=[x])
+        b = Strand(name="b", domains=[x.C])
+        start = [Complex(strands=[a], structure="."), Complex(strands=[b], structure=".")]
+        stop = StopCondition("Forward", [(Complex(strands=[a, b], structure="(+)"), 4, 4)])
+
+        o = runSeeded(start, [stop], mode="Normal", num=num, seed=9, num_threads=threads)
+        outcomes = sorted((r.seed, r.tag, r.time) for r in o.interface.results)
+        return zip(outcomes, endStates(o))
+
+    def test_streams(self):
+        """ Test [RandomStreams]: Run the same trajectories on one and three threads, and fewer of them
+
+        The trajectories do not depend on the thread that runs them or on the others that
+        run, so the first three of six end as when only three run."""
+        single = self.runStreams(6, 1)
+
+        self.assertTrue(any(tag == "Forward" for ((seed, tag, time), state) in single))
+        self.assertEqual(len(set(seed for ((seed, tag, time), state) in single)), 6)
+        self.assertEqual(single, self.runStreams(6, 3))
+
+        for trajectory in self.runStreams(3, 1):
+            self.assertTrue(trajectory in single)
+
+
+class MI_ParameterCache_TestCase(unittest.TestCase):
+    """ Parameter tables mapped from the cache file give the results of the parsed tables.
+
+    """
+    def runCached(self, cache):
+        os.environ["MULTISTRAND_CACHE"] = cache
+
+        x = Domain(name="x", sequence="GCATGCATTCAGGCATCCAGTT")
+        a = Strand(name="a", domains=[x])
+        b = Strand(name="b", domains=[x.C])
+        start = [Complex(strands=[a], structure="."), Complex(strands=[b], structure=".")]
+        stop = StopCondition("Forward", [(Complex(strands=[a, b], structure="(+)"), 4, 4)])
+
+        # a temperature the other tests do not use, as each process maps a file only once.
+        o = runSeeded(start, [stop], mode="Normal", num=6, seed=13, temperature=31.0)
+        return sorted((r.seed, r.tag, r.time) for r in o.interface.results), endStates(o)
+
+    def test_mapped_tables(self):
+        """ Test [ParameterCache]: Run with the cache off, then with a new cache directory
+
+        The second run writes the cache file and maps its tables."""
+        saved = os.environ.get("MULTISTRAND_CACHE")
+        directory = tempfile.mkdtemp()
+
+        try:
+            parsed = self.runCached("")
+            mapped = self.runCached(directory)
+
+            self.assertEqual(len(glob.glob(os.path.join(directory, "nupack-*.bin"))), 1)
+            self.assertEqual(parsed, mapped)
+        finally:
+            if saved is None:
+                del os.environ["MULTISTRAND_CACHE"]
+            else:
+                os.environ["MULTISTRAND_CACHE"] = saved
+            shutil.rmtree(directory)
+
+
+class MI_LazyMoves_TestCase(unittest.TestCase):
+    """ Grouped creation moves (use_lazy_moves) keep the distribution of the trajectories.
+
+    """
+    sequence = "AATAATCGGATAAAACGGGAATGCCATGTATACCTACTCCTTTTAAGAATATTTCATATATGAT"
+
+    def runPairs(self, lazy):
+        s = Strand(name="s", sequence=self.sequence)
+        o = runSeeded([Complex(strands=[s], structure="." * len(self.sequence))], mode="Normal",
+                      num=1000, time=3e-7, seed=7, use_lazy_moves=lazy)
+
+        self.assertEqual(len(o.interface.end_states), 1000)
+        return [sum(c[4].count("(") for c in state) for state in o.interface.end_states]
+
+    def test_lazy_moves(self):
+        """ Test [LazyMoves]: Fold a long strand for a fixed time, with and without grouping
+
+        The sides of the strand have well over LAZY_MIN_PAIRS pairs, so its creation
+        moves are grouped. The share of unfolded strands and the mean number of base
+        pairs at the end should agree to well within their sampling error."""
+        exact = self.runPairs(False)
+        lazy = self.runPairs(True)
+
+        unfolded = [sum(1 for p in pairs if p == 0) / 1000.0 for pairs in [exact, lazy]]
+        mean = [sum(pairs) / 1000.0 for pairs in [exact, lazy]]
+
+        self.assertTrue(0.1 < unfolded[0] < 0.9)
+        self.assertAlmostEqual(unfolded[0], unfolded[1], delta=0.08)
+        self.assertAlmostEqual(mean[0], mean[1], delta=0.4)
+
+
+class MI_Pinned_Trajectories_TestCase(unittest.TestCase):
+    """ Optimized move generation and energy computations leave the trajectories as they were.
+
+    The digests of the end states were recorded with the code before each optimization,
+    for the same seeds. None of the optimizations changes a rate or a choice, so any
+    difference in the digests is a regression.
+    """
+    def digest(self, time=1e-6, **settings):
+        x = Domain(name="x", sequence="GCATGCATTCAGGCATCCAGTTAGCAGT")
+        y = Domain(name="y", sequence="TTATGATAAT")
+        z = Domain(name="z", sequence="CTGACGATTGCAGTCAACGTGATGCTAGTCATGGCAT")
+        a = Strand(name="a", domains=[x, y, z])
+        b = Strand(name="b", domains=[z.C, y.C])
+        c = Strand(name="c", domains=[x.C])
+        start = [Complex(strands=[a, b], structure="..(+)."), Complex(strands=[c], structure=".")]
+
+        o = runSeeded(start, mode="Normal", num=2, time=time, seed=11, **settings)
+        return hashlib.md5(repr(endStates(o))).hexdigest()[:12]
+
+    def test_pair_masks(self):
+        """ Test [Pinned]: Generate the creation moves of three strands through the pair masks
+
+        Strand a is 75 bases long, so its masks take two words, and the sides of the
+        multiloops and open loops fall at offsets into the strands. GT pairs change the masks."""
+        self.assertEqual(self.digest(), "9c48487b8b39")
+        self.assertEqual(self.digest(gt_enable=True), "7f81869b4763")
+
+    def test_move_tree(self):
+        """ Test [Pinned]: Keep the moves of the loops in move trees (use_move_tree)
+
+        The tree picks the same move as the list for each choice, so the trajectories are
+        those of the default runs."""
+        self.assertEqual(self.digest(use_move_tree=True), "9c48487b8b39")
+        self.assertEqual(self.digest(time=1e-5, use_move_tree=True), "4fe75ab6d473")
+
+    def test_energy_cache(self):
+        """ Test [Pinned]: Run longer trajectories through the loop energy cache
+
+        The loops of the states that the trajectories return to are looked up in the cache.
+        The model at 37 C runs between two at 25 C, whose cached energies it must not use."""
+        self.assertEqual(self.digest(time=1e-5), "4fe75ab6d473")
+        self.assertEqual(self.digest(time=1e-5, temperature=37.0), "2af93b4ae59d")
+        self.assertEqual(self.digest(time=1e-5), "4fe75ab6d473")
+
+    arrhenius = dict(useArrRates=True, lnAStack=7.8, EStack=3.1, lnALoop=8.3, ELoop=4.2, lnAEnd=7.1, EEnd=2.6,
+                     lnAStackStack=7.4, EStackStack=3.5, lnALoopEnd=6.9, ELoopEnd=2.2,
+                     lnAStackEnd=7.7, EStackEnd=3.8, lnAStackLoop=8.0, EStackLoop=2.9)
+
+    def test_batch_rates(self):
+        """ Test [Pinned]: Compute the rates of the creation moves in batches
+
+        For the Metropolis (see test_pair_masks) and Kawasaki rate methods, and for the
+        Arrhenius rates, whose prefactors are applied after the batch."""
+        self.assertEqual(self.digest(rate_method=2), "9ffa3b566ec0")
+        self.assertEqual(self.digest(**self.arrhenius), "b0d94b9c04bc")
+
+    def test_kernels(self):
+        """ Test [Pinned]: Compute loop energies and rates in the kernels for each model option
+
+        The dangles None and All, each with the three rate models; the tests above use
+        dangles Some."""
+        digests = {0: ["bf9a28a458d0", "778f0290af43", "133958e048fd"],
+                   2: ["c920190cb103", "0703983f5559", "4d46faff0374"]}
+
+        for dangles in [0, 2]:
+            self.assertEqual(self.digest(dangles=dangles), digests[dangles][0])
+            self.assertEqual(self.digest(dangles=dangles, rate_method=2), digests[dangles][1])
+            self.assertEqual(self.digest(dangles=dangles, **self.arrhenius), digests[dangles][2])
+
+
 class SetupSuite( object ):
     """ Container for default set of tests and standard method for running them."""
 
@@ -259,6 +541,21 @@ class SetupSuite( object ):
         self._suite.addTests(
             unittest.TestLoader().loadTestsFromTestCase(
                 MI_Options_Object_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_StopMatcher_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_Pinned_Trajectories_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_RandomStreams_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_ParameterCache_TestCase ))
+        self._suite.addTests(
+            unittest.TestLoader().loadTestsFromTestCase(
+                MI_LazyMoves_TestCase ))
 
     def runTests(self):
         if hasattr(self, "_suite") and self._suite is not None: